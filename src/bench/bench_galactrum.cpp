@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 
 #include <crypto/sha256.h>
+#include <crypto/Lyra2RE/Lyra2.h>
 #include <key.h>
 #include <validation.h>
 #include <util.h>
@@ -56,6 +57,7 @@ int main(int argc, char** argv)
     }
 
     SHA256AutoDetect();
+    LYRA2AutoDetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
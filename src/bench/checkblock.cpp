@@ -8,6 +8,9 @@
 #include <validation.h>
 #include <streams.h>
 #include <consensus/validation.h>
+#include <util.h>
+
+#include <boost/thread/thread.hpp>
 
 namespace block_bench {
 #include <bench/data/block413567.raw.h>
@@ -52,5 +55,96 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
     }
 }
 
+// A block received from the network has its header hash requested about this
+// many times on its way through ProcessNewBlock: CheckBlock, AcceptBlockHeader,
+// AcceptBlock, ActivateBestChain, ConnectBlock and the validation interface
+// callbacks in net_processing.
+static const int BLOCK_HASH_REQUESTS = 8;
+
+static void BlockHashPerRequest(benchmark::State& state)
+{
+    CDataStream stream((const char*)block_bench::block413567,
+            (const char*)&block_bench::block413567[sizeof(block_bench::block413567)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < BLOCK_HASH_REQUESTS; i++) {
+            block.InvalidateCachedHash();
+            block.GetHash();
+        }
+    }
+}
+
+static void BlockHashMemoized(benchmark::State& state)
+{
+    CDataStream stream((const char*)block_bench::block413567,
+            (const char*)&block_bench::block413567[sizeof(block_bench::block413567)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    while (state.KeepRunning()) {
+        block.InvalidateCachedHash();
+        for (int i = 0; i < BLOCK_HASH_REQUESTS; i++) {
+            block.GetHash();
+        }
+    }
+}
+
+// Header sync is reported per this many headers, delivered the way peers
+// send them: in full headers messages of MAX_HEADERS_RESULTS each.
+static const size_t HEADER_SYNC_HEADERS = 100000;
+
+static void HeaderSync(benchmark::State& state, int nThreads)
+{
+    CDataStream stream((const char*)block_bench::block413567,
+            (const char*)&block_bench::block413567[sizeof(block_bench::block413567)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    std::vector<std::vector<CBlockHeader>> messages;
+    for (size_t n = 0; n < HEADER_SYNC_HEADERS; n++) {
+        if (n % MAX_HEADERS_RESULTS == 0)
+            messages.emplace_back();
+        CBlockHeader header = block.GetBlockHeader();
+        header.nNonce = n;
+        messages.back().push_back(header);
+    }
+
+    boost::thread_group threadGroup;
+    nScriptCheckThreads = nThreads;
+    for (int i = 0; i < nThreads - 1; i++)
+        threadGroup.create_thread(&ThreadHeaderHashCheck);
+
+    while (state.KeepRunning()) {
+        for (const std::vector<CBlockHeader>& headers : messages) {
+            for (const CBlockHeader& header : headers)
+                header.InvalidateCachedHash();
+            PrecomputeHeaderHashes(headers);
+        }
+    }
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+    nScriptCheckThreads = 0;
+}
+
+static void HeaderSync100kSerial(benchmark::State& state)
+{
+    HeaderSync(state, 0);
+}
+
+static void HeaderSync100kParallel(benchmark::State& state)
+{
+    HeaderSync(state, std::max(2, GetNumCores()));
+}
+
 BENCHMARK(DeserializeBlockTest, 130);
 BENCHMARK(DeserializeAndCheckBlockTest, 160);
+BENCHMARK(BlockHashPerRequest, 20);
+BENCHMARK(BlockHashMemoized, 160);
+BENCHMARK(HeaderSync100kSerial, 1);
+BENCHMARK(HeaderSync100kParallel, 1);
@@ -10,6 +10,7 @@
 #include <random.h>
 #include <uint256.h>
 #include <utiltime.h>
+#include <crypto/common.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
@@ -60,6 +61,44 @@ static void SHA512(benchmark::State& state)
         CSHA512().Write(in.data(), in.size()).Finalize(hash);
 }
 
+static void LYRA2_32b(benchmark::State& state)
+{
+    std::vector<uint8_t> in(32,0);
+    while (state.KeepRunning()) {
+        LYRA2(in.data(), 32, in.data(), 32, in.data(), 32, 1, 4, 4);
+    }
+}
+
+static void Lyra2REv2_80b(benchmark::State& state)
+{
+    std::vector<uint8_t> in(80,0);
+    while (state.KeepRunning()) {
+        uint256 hash = lyra2re2_hash(in.begin(), in.end());
+        memcpy(in.data(), hash.begin(), 32);
+    }
+}
+
+// Miner-style batches: 80-byte headers that differ only in their nonce.
+static void Lyra2REv2Lanes(benchmark::State& state, size_t lanes)
+{
+    unsigned char headers[LYRA2RE2_MAX_LANES][80] = {};
+    const unsigned char* inputs[LYRA2RE2_MAX_LANES];
+    uint256 hashes[LYRA2RE2_MAX_LANES];
+    uint32_t nonce = 0;
+    for (size_t i = 0; i < lanes; i++)
+        inputs[i] = headers[i];
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < lanes; i++) {
+            WriteLE32(headers[i] + 76, nonce++);
+        }
+        lyra2re2_hash_lanes(inputs, 80, hashes, lanes);
+    }
+}
+
+static void Lyra2REv2_80b_1way(benchmark::State& state) { Lyra2REv2Lanes(state, 1); }
+static void Lyra2REv2_80b_4way(benchmark::State& state) { Lyra2REv2Lanes(state, 4); }
+static void Lyra2REv2_80b_8way(benchmark::State& state) { Lyra2REv2Lanes(state, 8); }
+
 static void SipHash_32b(benchmark::State& state)
 {
     uint256 x;
@@ -93,6 +132,11 @@ BENCHMARK(SHA256, 340);
 BENCHMARK(SHA512, 330);
 
 BENCHMARK(SHA256_32b, 4700 * 1000);
+BENCHMARK(LYRA2_32b, 700 * 1000);
+BENCHMARK(Lyra2REv2_80b, 150 * 1000);
+BENCHMARK(Lyra2REv2_80b_1way, 150 * 1000);
+BENCHMARK(Lyra2REv2_80b_4way, 40 * 1000);
+BENCHMARK(Lyra2REv2_80b_8way, 20 * 1000);
 BENCHMARK(SipHash_32b, 40 * 1000 * 1000);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -0,0 +1,105 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <kernel.h>
+#include <validation.h>
+
+// Long enough for the stake modifier of a coin at KERNEL_HEIGHT to be
+// selected from blocks after it, and for the coin to pass the minimum age.
+static const int STAKE_CHAIN_LENGTH = 200;
+static const int KERNEL_HEIGHT = 10;
+// Timestamps tried per coin by the wallet (CWallet::nHashDrift)
+static const unsigned int STAKE_HASH_DRIFT = 45;
+
+// Measures the chain-state side of proof-of-stake block validation: finding
+// the kernel's spent output and its block, and evaluating the kernel hash.
+static void CheckStakeKernel(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    const Consensus::Params& consensus = Params().GetConsensus();
+
+    LOCK(cs_main);
+    std::vector<CBlockIndex> blocks(STAKE_CHAIN_LENGTH);
+    for (int i = 0; i < STAKE_CHAIN_LENGTH; i++) {
+        CBlockIndex& index = blocks[i];
+        index.nHeight = i;
+        index.nTime = 1500000000 + i * consensus.nPosTargetSpacing;
+        index.nBits = 0x207fffff;
+        index.pprev = i ? &blocks[i - 1] : nullptr;
+        index.phashBlock = &mapBlockIndex.emplace(ArithToUint256(arith_uint256(i + 1)), &index).first->first;
+        index.SetStakeModifier(i, true);
+        index.BuildSkip();
+    }
+    chainActive.SetTip(&blocks.back());
+
+    CCoinsView viewDummy;
+    pcoinsTip.reset(new CCoinsViewCache(&viewDummy));
+    COutPoint prevout(ArithToUint256(arith_uint256(0xbeef)), 0);
+    pcoinsTip->AddCoin(prevout, Coin(CTxOut(1000 * COIN, CScript()), KERNEL_HEIGHT, false, false), false);
+
+    const CBlockIndex* pindexTip = chainActive.Tip();
+    while (state.KeepRunning()) {
+        CTxOut txoutPrev;
+        const CBlockIndex* pindexFrom = nullptr;
+        assert(GetStakeKernelInput(prevout, txoutPrev, pindexFrom));
+        uint256 hashProofOfStake;
+        CheckStakeKernelHash(pindexTip->nBits, pindexFrom->GetBlockHash(), pindexFrom->GetBlockTime(), txoutPrev.nValue,
+                             prevout, pindexTip->GetBlockTime(), hashProofOfStake);
+    }
+
+    pcoinsTip.reset();
+    chainActive.SetTip(nullptr);
+    for (const CBlockIndex& index : blocks)
+        mapBlockIndex.erase(index.GetBlockHash());
+}
+
+// Measures one staking try of the wallet's kernel search: the per-coin context
+// is built once per tip, so each try only hashes the kernel timestamp.
+static void SearchStakeKernel(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    const Consensus::Params& consensus = Params().GetConsensus();
+
+    LOCK(cs_main);
+    std::vector<CBlockIndex> blocks(STAKE_CHAIN_LENGTH);
+    for (int i = 0; i < STAKE_CHAIN_LENGTH; i++) {
+        CBlockIndex& index = blocks[i];
+        index.nHeight = i;
+        index.nTime = 1500000000 + i * consensus.nPosTargetSpacing;
+        index.nBits = 0x207fffff;
+        index.pprev = i ? &blocks[i - 1] : nullptr;
+        index.phashBlock = &mapBlockIndex.emplace(ArithToUint256(arith_uint256(i + 1)), &index).first->first;
+        index.SetStakeModifier(i, true);
+        index.BuildSkip();
+    }
+    chainActive.SetTip(&blocks.back());
+
+    const CBlockIndex* pindexFrom = &blocks[KERNEL_HEIGHT];
+    COutPoint prevout(ArithToUint256(arith_uint256(0xbeef)), 0);
+    CStakeKernelContext kernel;
+    assert(kernel.Init(pindexFrom->GetBlockHash(), pindexFrom->GetBlockTime(), 1000 * COIN, prevout));
+
+    // walk the wallet's hash drift window; an unreachable target keeps every
+    // try a miss, as most of them are
+    const unsigned int nTimeTx = chainActive.Tip()->GetBlockTime();
+    unsigned int nTry = 0;
+    while (state.KeepRunning()) {
+        uint256 hashProofOfStake;
+        kernel.CheckHash(0x01000001, nTimeTx - nTry, hashProofOfStake);
+        nTry = (nTry + 1) % STAKE_HASH_DRIFT;
+    }
+
+    chainActive.SetTip(nullptr);
+    for (const CBlockIndex& index : blocks)
+        mapBlockIndex.erase(index.GetBlockHash());
+}
+
+BENCHMARK(CheckStakeKernel, 100000);
+BENCHMARK(SearchStakeKernel, 1000000);
@@ -0,0 +1,70 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <arith_uint256.h>
+#include <key.h>
+#include <masternode.h>
+#include <messagesigner.h>
+#include <util.h>
+
+// Pings arriving in one burst, e.g. right after the masternode list sync
+static const int PING_BURST_SIZE = 10000;
+
+static std::vector<CMasternodePing> SignPings(const CKey& key, bool fNewSigs)
+{
+    std::vector<CMasternodePing> vPings(PING_BURST_SIZE);
+    for (int i = 0; i < PING_BURST_SIZE; i++) {
+        CMasternodePing& mnp = vPings[i];
+        mnp.masternodeOutpoint = COutPoint(ArithToUint256(arith_uint256(i + 1)), 1);
+        mnp.blockHash = ArithToUint256(arith_uint256(0xbeef));
+        mnp.sigTime = 1500000000 + i;
+        if (fNewSigs) {
+            assert(CHashSigner::SignHash(mnp.GetSignatureHash(), key, CPubKey::InputScriptType::SPENDP2PKH, mnp.vchSig));
+        } else {
+            assert(CMessageSigner::SignMessage(mnp.GetStrMessage(), mnp.vchSig, key, CPubKey::InputScriptType::SPENDP2PKH));
+        }
+    }
+    return vPings;
+}
+
+// Verifies a burst of distinct pings the way CMasternodePing::CheckSignature
+// does before and after SPORK_6_NEW_SIGS. The message signature cache is
+// shrunk to a couple of entries so that every ping is verified in full.
+static void VerifyMasternodePings(benchmark::State& state, bool fNewSigs)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CPubKey pubkey = key.GetPubKey();
+    std::vector<CMasternodePing> vPings = SignPings(key, fNewSigs);
+
+    gArgs.ForceSetArg("-maxmsgsigcachesize", "0");
+    InitMessageSignatureCache();
+
+    while (state.KeepRunning()) {
+        for (const CMasternodePing& mnp : vPings) {
+            std::string strError;
+            bool fValid = fNewSigs ? CHashSigner::VerifyHash(mnp.GetSignatureHash(), pubkey, mnp.vchSig, strError)
+                                   : CMessageSigner::VerifyMessage(pubkey, mnp.vchSig, mnp.GetStrMessage(), strError);
+            assert(fValid);
+        }
+    }
+
+    gArgs.ForceSetArg("-maxmsgsigcachesize", std::to_string(DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE));
+    InitMessageSignatureCache();
+}
+
+static void VerifyMasternodePingsString(benchmark::State& state)
+{
+    VerifyMasternodePings(state, false);
+}
+
+static void VerifyMasternodePingsHash(benchmark::State& state)
+{
+    VerifyMasternodePings(state, true);
+}
+
+BENCHMARK(VerifyMasternodePingsString, 2);
+BENCHMARK(VerifyMasternodePingsHash, 2);
@@ -22,14 +22,40 @@ static CPubKey::InputScriptType GetScriptTypeFromDestination(const CTxDestinatio
 
 CBlockSigner::CBlockSigner(CBlock &block, const CKeyStore *keystore, const TPoSContract &contract) :
     refBlock(block),
+    pblockToSign(&block),
     refKeystore(keystore),
-    refContract(contract)
+    refContract(contract),
+    fSignatureHashCached(false)
 {
 
 }
 
+CBlockSigner::CBlockSigner(const CBlock &block, const TPoSContract &contract) :
+    refBlock(block),
+    pblockToSign(nullptr),
+    refKeystore(nullptr),
+    refContract(contract),
+    fSignatureHashCached(false)
+{
+
+}
+
+const uint256 &CBlockSigner::GetSignatureHash() const
+{
+    if(!fSignatureHashCached)
+    {
+        hashSignature = refBlock.IsTPoSBlock() ? refBlock.GetTPoSHash() : refBlock.GetHash();
+        fSignatureHashCached = true;
+    }
+
+    return hashSignature;
+}
+
 bool CBlockSigner::SignBlock()
 {
+    if(!pblockToSign)
+        return error("CBlockSigner::SignBlock() : signer was created for verification only");
+
     CKey keySecret;
     CPubKey::InputScriptType scriptType;
 
@@ -70,7 +96,7 @@ bool CBlockSigner::SignBlock()
         }
     }
 //?
-    return CHashSigner::SignHash(refBlock.IsTPoSBlock() ? refBlock.GetTPoSHash() : refBlock.GetHash(), keySecret, scriptType, refBlock.vchBlockSig);
+    return CHashSigner::SignHash(GetSignatureHash(), keySecret, scriptType, pblockToSign->vchBlockSig);
 }
 
 bool CBlockSigner::CheckBlockSignature() const
@@ -90,7 +116,6 @@ bool CBlockSigner::CheckBlockSignature() const
         return error("CBlockSigner::CheckBlockSignature() : failed to extract destination from script: %s", txout.scriptPubKey.ToString());
     }
 
-    auto hashMessage = refBlock.IsTPoSBlock() ? refBlock.GetTPoSHash() : refBlock.GetHash();
     if(refBlock.IsProofOfStake())
     {
         if(refBlock.IsTPoSBlock())
@@ -104,5 +129,5 @@ bool CBlockSigner::CheckBlockSignature() const
     }
 
     std::string strError;
-    return CHashSigner::VerifyHash(hashMessage, destination, refBlock.vchBlockSig, strError);
+    return CHashSigner::VerifyHash(GetSignatureHash(), destination, refBlock.vchBlockSig, strError);
 }
@@ -1,6 +1,8 @@
 #ifndef BLOCKSIGNER_H
 #define BLOCKSIGNER_H
 
+#include <uint256.h>
+
 class CBlock;
 class TPoSContract;
 class CPubKey;
@@ -10,12 +12,21 @@ class CKeyStore;
 struct CBlockSigner {
 
     CBlockSigner(CBlock &block, const CKeyStore *keystore, const TPoSContract &contract);
+    // verification only, the block is never copied or modified
+    CBlockSigner(const CBlock &block, const TPoSContract &contract);
 
     bool SignBlock();
     bool CheckBlockSignature() const;
 
-    CBlock &refBlock;
+    const CBlock &refBlock;
+    CBlock *pblockToSign;
     const CKeyStore *refKeystore;
     const TPoSContract &refContract;
+
+private:
+    const uint256 &GetSignatureHash() const;
+
+    mutable uint256 hashSignature;
+    mutable bool fSignatureHashCached;
 };
 #endif // BLOCKSIGNER_H
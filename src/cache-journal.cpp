@@ -0,0 +1,60 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cache-journal.h>
+
+#include <util.h>
+
+static const char DB_RECORD = 'r';
+static const char DB_SNAPSHOT = 's';
+
+std::unique_ptr<CCacheJournalDB> pcachejournal;
+
+CCacheJournalDB::CCacheJournalDB(size_t nCacheSize, bool fMemory, bool fWipe)
+    : CDBWrapper(GetDataDir() / "cachejournal", nCacheSize, fMemory, fWipe)
+{}
+
+void CCacheJournalDB::WriteRecord(CDBBatch& batch, const std::string& strTable, const record_t& vchKey, const record_t& vchValue)
+{
+    batch.Write(std::make_pair(DB_RECORD, std::make_pair(strTable, vchKey)), vchValue);
+}
+
+bool CCacheJournalDB::ReadRecords(const std::string& strTable, std::vector<std::pair<record_t, record_t> >& vRecordsRet)
+{
+    vRecordsRet.clear();
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_RECORD, std::make_pair(strTable, record_t())));
+    std::pair<char, std::pair<std::string, record_t> > key;
+    while (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_RECORD && key.second.first == strTable) {
+        record_t vchValue;
+        if (!pcursor->GetValue(vchValue)) {
+            return error("%s: failed to read a record of %s", __func__, strTable);
+        }
+        vRecordsRet.emplace_back(key.second.second, vchValue);
+        pcursor->Next();
+    }
+    return true;
+}
+
+void CCacheJournalDB::ResetTable(CDBBatch& batch, const std::string& strTable, const uint256& hashSnapshot)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_RECORD, std::make_pair(strTable, record_t())));
+    std::pair<char, std::pair<std::string, record_t> > key;
+    while (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_RECORD && key.second.first == strTable) {
+        batch.Erase(key);
+        pcursor->Next();
+    }
+    batch.Write(std::make_pair(DB_SNAPSHOT, strTable), std::make_pair(hashSnapshot, CLIENT_VERSION));
+}
+
+bool CCacheJournalDB::IsTableOf(const std::string& strTable, const uint256& hashSnapshot)
+{
+    std::pair<uint256, int> snapshot;
+    if (!Read(std::make_pair(DB_SNAPSHOT, strTable), snapshot)) {
+        // nothing was snapshotted yet, the journal has everything there is
+        return hashSnapshot.IsNull();
+    }
+    return snapshot.first == hashSnapshot && snapshot.second == CLIENT_VERSION;
+}
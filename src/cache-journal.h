@@ -0,0 +1,319 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CACHE_JOURNAL_H
+#define CACHE_JOURNAL_H
+
+#include <clientversion.h>
+#include <dbwrapper.h>
+#include <flat-database.h>
+#include <hash.h>
+#include <streams.h>
+#include <uint256.h>
+#include <util.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+/** Cache size of the cache journal database */
+static const size_t CACHE_JOURNAL_DB_CACHE_SIZE = 2 << 20;
+/** Seconds between writes of the changed cache entries to the journal */
+static const int CACHE_JOURNAL_FLUSH_SECONDS = 60;
+/** Seconds between rewrites of the .dat snapshots, which empty the journal */
+static const int CACHE_JOURNAL_SNAPSHOT_SECONDS = 60 * 60;
+
+/**
+ * Access to the cache journal database (cachejournal/)
+ *
+ * Holds the entries of the masternode, payment, governance and stakenode caches
+ * that changed since their .dat file was last written, by table and serialized
+ * key. An empty value marks an erased entry. Each table also records the hash of
+ * the snapshot its records apply to.
+ */
+class CCacheJournalDB : public CDBWrapper
+{
+public:
+    typedef std::vector<unsigned char> record_t;
+
+    explicit CCacheJournalDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    static void WriteRecord(CDBBatch& batch, const std::string& strTable, const record_t& vchKey, const record_t& vchValue);
+    bool ReadRecords(const std::string& strTable, std::vector<std::pair<record_t, record_t> >& vRecordsRet);
+
+    /** Erase the records of a table and tie it to a new snapshot */
+    void ResetTable(CDBBatch& batch, const std::string& strTable, const uint256& hashSnapshot);
+    /** Whether the records of a table apply to this snapshot, written by this client version */
+    bool IsTableOf(const std::string& strTable, const uint256& hashSnapshot);
+};
+
+extern std::unique_ptr<CCacheJournalDB> pcachejournal;
+
+/** The entry of a journaled map, nullptr if it has none for key */
+template<typename K, typename V>
+const V* FindJournalEntry(const std::map<K, V>& mapEntries, const K& key)
+{
+    auto it = mapEntries.find(key);
+    return it == mapEntries.end() ? nullptr : &it->second;
+}
+
+/**
+ * Journal of one map of a cache. The owner of the map marks the entries it
+ * adds, changes or erases dirty, a flush journals the dirty entries whose hash
+ * differs from the one last journaled or snapshotted. Entries are hashed as
+ * serialized for disk with SER_GETHASH added, which lets them leave out
+ * bookkeeping that changes without the entry changing, such as the time of
+ * their last check. The owner of the map serializes access to the table.
+ *
+ * Besides std::map, any container whose iteration yields (key, value) pairs in
+ * key order and that has a FindJournalEntry overload can be journaled, it then
+ * applies the records of ReadEntries itself.
+ */
+template<typename K, typename V>
+class CCacheJournalTable
+{
+private:
+    std::string strTable;
+    std::map<K, uint256> mapEntryHashes;
+    std::set<K> setDirty;
+    // hashes of the entries in the batch being written, null for erased ones
+    std::vector<std::pair<K, uint256> > vPending;
+
+    template<typename T>
+    static CCacheJournalDB::record_t SerializeRecord(const T& obj)
+    {
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << obj;
+        return CCacheJournalDB::record_t(ss.begin(), ss.end());
+    }
+
+    template<typename T>
+    static uint256 HashEntry(const T& obj)
+    {
+        CDataStream ss(SER_DISK | SER_GETHASH, CLIENT_VERSION);
+        ss << obj;
+        return Hash(ss.begin(), ss.end());
+    }
+
+public:
+    explicit CCacheJournalTable(const std::string& strTableIn) : strTable(strTableIn) {}
+
+    /// The entries as they are now are in the snapshot about to be written
+    template<typename M>
+    void SetBaseline(const M& mapEntries)
+    {
+        mapEntryHashes.clear();
+        for (const auto& entry : mapEntries) {
+            mapEntryHashes.emplace_hint(mapEntryHashes.end(), entry.first, HashEntry(entry.second));
+        }
+        setDirty.clear();
+        vPending.clear();
+    }
+
+    /// The entry was added, changed or erased, or might have been
+    void MarkDirty(const K& key) { setDirty.insert(key); }
+
+    /// Every entry journaled so far was erased, e.g. the map was cleared
+    void MarkAllDirty()
+    {
+        for (const auto& entry : mapEntryHashes) {
+            setDirty.insert(entry.first);
+        }
+    }
+
+    /// The entries before key were dropped, for maps that only ever drop their lowest keys
+    void MarkDirtyBefore(const K& key)
+    {
+        for (auto it = mapEntryHashes.begin(); it != mapEntryHashes.end() && it->first < key; ++it) {
+            setDirty.insert(it->first);
+        }
+    }
+
+    /// Add the dirty entries that changed since they were last journaled to
+    /// batch. Call Commit once the batch is written or Abort if it failed, the
+    /// batch can be written without holding the lock of the map. Returns the
+    /// number of records added.
+    template<typename M>
+    int WriteChanges(CDBBatch& batch, const M& mapEntries)
+    {
+        int nRecords = 0;
+        vPending.clear();
+        for (const K& key : setDirty) {
+            const auto* pentry = FindJournalEntry(mapEntries, key);
+            auto itOld = mapEntryHashes.find(key);
+            if (!pentry) {
+                if (itOld == mapEntryHashes.end()) continue; // added and erased again
+                CCacheJournalDB::WriteRecord(batch, strTable, SerializeRecord(key), CCacheJournalDB::record_t());
+                vPending.emplace_back(key, uint256());
+            } else {
+                uint256 hash = HashEntry(*pentry);
+                if (itOld != mapEntryHashes.end() && itOld->second == hash) continue;
+                CCacheJournalDB::WriteRecord(batch, strTable, SerializeRecord(key), SerializeRecord(*pentry));
+                vPending.emplace_back(key, hash);
+            }
+            nRecords++;
+        }
+        setDirty.clear();
+        return nRecords;
+    }
+
+    void Commit()
+    {
+        for (const auto& entry : vPending) {
+            if (entry.second.IsNull()) {
+                mapEntryHashes.erase(entry.first);
+            } else {
+                mapEntryHashes[entry.first] = entry.second;
+            }
+        }
+        vPending.clear();
+    }
+
+    /// The batch was not written, its entries are journaled by the next flush
+    void Abort()
+    {
+        for (const auto& entry : vPending) {
+            setDirty.insert(entry.first);
+        }
+        vPending.clear();
+    }
+
+    void Reset(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot)
+    {
+        db.ResetTable(batch, strTable, hashSnapshot);
+    }
+
+    /// Parse the journaled entries of a snapshot, an erased entry has no value.
+    /// Returns false if the journal is of another snapshot or can not be parsed.
+    bool ReadEntries(CCacheJournalDB& db, const uint256& hashSnapshot, std::vector<std::pair<K, std::unique_ptr<V> > >& vEntriesRet)
+    {
+        vEntriesRet.clear();
+        if (!db.IsTableOf(strTable, hashSnapshot)) return false;
+
+        std::vector<std::pair<CCacheJournalDB::record_t, CCacheJournalDB::record_t> > vRecords;
+        if (!db.ReadRecords(strTable, vRecords)) return false;
+
+        // parse everything before the caller touches its map, a bad record discards the journal
+        try {
+            for (const auto& record : vRecords) {
+                K key;
+                CDataStream ssKey(record.first, SER_DISK, CLIENT_VERSION);
+                ssKey >> key;
+                std::unique_ptr<V> pvalue;
+                if (!record.second.empty()) {
+                    pvalue.reset(new V());
+                    CDataStream ssValue(record.second, SER_DISK, CLIENT_VERSION);
+                    ssValue >> *pvalue;
+                }
+                vEntriesRet.emplace_back(key, std::move(pvalue));
+            }
+        } catch (const std::exception& e) {
+            vEntriesRet.clear();
+            return error("%s: Deserialize error in %s - %s", __func__, strTable, e.what());
+        }
+        LogPrintf("Replaying %d journal records of %s\n", vRecords.size(), strTable);
+        return true;
+    }
+
+    /// Apply the journaled entries to a freshly loaded snapshot. Returns false,
+    /// leaving mapEntries as it is, if the journal is of another snapshot.
+    bool Replay(CCacheJournalDB& db, const uint256& hashSnapshot, std::map<K, V>& mapEntries)
+    {
+        std::vector<std::pair<K, std::unique_ptr<V> > > vEntries;
+        if (!ReadEntries(db, hashSnapshot, vEntries)) return false;
+
+        for (auto& entry : vEntries) {
+            if (entry.second) {
+                mapEntries[entry.first] = *entry.second;
+            } else {
+                mapEntries.erase(entry.first);
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * A cache kept as a .dat snapshot (see CFlatDB) plus a journal of the entries
+ * that changed since. Changes are journaled periodically, so a crash loses at
+ * most one flush interval, and shutdown only writes what changed. The snapshot
+ * is rewritten now and then to keep the journal short.
+ *
+ * T provides SetJournalBaseline, WriteJournal, ReplayJournal and ResetJournal
+ * for the maps it journals.
+ */
+template<typename T>
+class CJournaledFlatDB
+{
+private:
+    CFlatDB<T> flatdb;
+    std::string strFilename;
+
+public:
+    CJournaledFlatDB(std::string strFilenameIn, std::string strMagicMessageIn)
+        : flatdb(strFilenameIn, strMagicMessageIn),
+          strFilename(strFilenameIn)
+    {}
+
+    bool Load(T& objToLoad)
+    {
+        if (!flatdb.Load(objToLoad)) return false;
+        if (!pcachejournal) return true;
+
+        if (objToLoad.ReplayJournal(*pcachejournal, flatdb.GetLastHash())) {
+            objToLoad.SetJournalBaseline();
+            LogPrintf("     %s\n", objToLoad.ToString());
+            return true;
+        }
+        // the journal belongs to another snapshot, e.g. a crash hit right after
+        // the snapshot was rewritten, start over from what was loaded
+        LogPrintf("Journal of %s does not match the snapshot, discarding it\n", strFilename);
+        return Reset(objToLoad);
+    }
+
+    /// Start over with a snapshot of the cache as it is, e.g. when it was not loaded
+    bool Reset(T& objToReset)
+    {
+        objToReset.SetJournalBaseline();
+        return Snapshot(objToReset);
+    }
+
+    /// Write the entries changed since the last flush to the journal. Without
+    /// fSync the records can be lost to a crash of the machine, but not of the
+    /// process, which is what the periodic flushes are there for.
+    bool Flush(T& objToSave, bool fSync)
+    {
+        if (!pcachejournal) return flatdb.Dump(objToSave);
+
+        int64_t nStart = GetTimeMillis();
+        int nRecords = objToSave.WriteJournal(*pcachejournal, fSync);
+        if (nRecords < 0) {
+            return error("%s: Failed to write the journal of %s", __func__, strFilename);
+        }
+        LogPrint(BCLog::BENCH, "Journaled %d changes of %s  %dms\n", nRecords, strFilename, GetTimeMillis() - nStart);
+        return true;
+    }
+
+    /// Rewrite the .dat file and empty the journal
+    bool Snapshot(T& objToSave)
+    {
+        if (!pcachejournal) return flatdb.Dump(objToSave);
+
+        // everything up to here is journaled and goes into the snapshot, changes
+        // made while it is written are journaled again by the next flush, replaying
+        // them on top of the snapshot is harmless. Should the snapshot fail the
+        // journal still applies to the previous one.
+        // the synced reset below syncs what this flush wrote as well
+        if (!Flush(objToSave, false)) return false;
+        if (!flatdb.Dump(objToSave)) return false;
+
+        CDBBatch batch(*pcachejournal);
+        objToSave.ResetJournal(batch, *pcachejournal, flatdb.GetLastHash());
+        return pcachejournal->WriteBatch(batch, true);
+    }
+};
+
+#endif // CACHE_JOURNAL_H
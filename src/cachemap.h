@@ -141,6 +141,18 @@ public:
         return true;
     }
 
+    /// Like Get, but also marks the item as the most recently used one
+    bool GetAndRefresh(const K& key, V& value)
+    {
+        map_it it = mapIndex.find(key);
+        if(it == mapIndex.end()) {
+            return false;
+        }
+        listItems.splice(listItems.begin(), listItems, it->second);
+        value = it->second->value;
+        return true;
+    }
+
     void Erase(const K& key)
     {
         map_it it = mapIndex.find(key);
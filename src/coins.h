@@ -125,6 +125,21 @@ public:
     }
 };
 
+/** Salted hasher for CKeyID and other uint160 keys */
+class SaltedKeyIDHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedKeyIDHasher();
+
+    size_t operator()(const uint160& id) const {
+        return CSipHasher(k0, k1).Write(id.begin(), id.size()).Finalize();
+    }
+};
+
 struct CCoinsCacheEntry
 {
     Coin coin; // The actual cached data.
@@ -27,25 +27,11 @@
 extern "C"{
 #endif
 /**
- * Executes Lyra2 based on the G function from Blake2b. This version supports salts and passwords
- * whose combined length is smaller than the size of the memory matrix, (i.e., (nRows x nCols x b) bits,
- * where "b" is the underlying sponge's bitrate). In this implementation, the "basil" is composed by all
- * integer parameters (treated as type "unsigned int") in the order they are provided, plus the value
- * of nCols, (i.e., basil = kLen || pwdlen || saltlen || timeCost || nRows || nCols).
- *
- * @param K The derived key to be output by the algorithm
- * @param kLen Desired key length
- * @param pwd User password
- * @param pwdlen Password length
- * @param salt Salt
- * @param saltlen Salt length
- * @param timeCost Parameter to determine the processing time (T)
- * @param nRows Number or rows of the memory matrix (R)
- * @param nCols Number of columns of the memory matrix (C)
- *
- * @return 0 if the key is generated correctly; -1 if there is an error (usually due to lack of memory for allocation)
+ * Runs the Lyra2 core over caller-provided memory. The matrix needs room for
+ * nRows x nCols blocks, memMatrix for nRows row pointers and state for 16 words;
+ * nothing is allocated here.
  */
-int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
+static void LYRA2_core(uint64_t *wholeMatrix, uint64_t **memMatrix, uint64_t *state, void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
 
     //============================= Basic variables ============================//
     int64_t row = 2; //index of row to be processed
@@ -58,25 +44,11 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     int64_t i; //auxiliary iteration counter
     //==========================================================================/
 
-    //========== Initializing the Memory Matrix and pointers to it =============//
-    //Tries to allocate enough space for the whole memory matrix
-
-
+    //================== Initializing the pointers to the rows =================//
+    //Every row is fully written during the Setup phase before it is read, so
+    //the matrix itself does not need to be cleared here
     const int64_t ROW_LEN_INT64 = BLOCK_LEN_INT64 * nCols;
-    const int64_t ROW_LEN_BYTES = ROW_LEN_INT64 * 8;
 
-    i = (int64_t) ((int64_t) nRows * (int64_t) ROW_LEN_BYTES);
-    uint64_t *wholeMatrix = malloc(i);
-    if (wholeMatrix == NULL) {
-      return -1;
-    }
-	memset(wholeMatrix, 0, i);
-
-    //Allocates pointers to each row of the matrix
-    uint64_t **memMatrix = malloc(nRows * sizeof (uint64_t*));
-    if (memMatrix == NULL) {
-      return -1;
-    }
     //Places the pointers in the correct positions
     uint64_t *ptrWord = wholeMatrix;
     for (i = 0; i < nRows; i++) {
@@ -125,10 +97,6 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
 
     //======================= Initializing the Sponge State ====================//
     //Sponge state: 16 uint64_t, BLOCK_LEN_INT64 words of them for the bitrate (b) and the remainder for the capacity (c)
-    uint64_t *state = malloc(16 * sizeof (uint64_t));
-    if (state == NULL) {
-      return -1;
-    }
     initState(state);
     //==========================================================================/
 
@@ -202,15 +170,68 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     squeeze(state, K, kLen);
     //==========================================================================/
 
-    //========================= Freeing the memory =============================//
-    free(memMatrix);
-    free(wholeMatrix);
-
-    //Wiping out the sponge's internal state before freeing it
+    //Wiping out the sponge's internal state
     memset(state, 0, 16 * sizeof (uint64_t));
-    free(state);
-    //==========================================================================/
+}
+
+/**
+ * Executes Lyra2 on a caller-owned context. Contexts are reusable and, since
+ * nothing is allocated, safe to keep per thread; this is the steady-state
+ * entry point for hashing headers.
+ *
+ * @return 0 if the key is generated correctly; -1 if nRows or nCols exceed the context's capacity
+ */
+int LYRA2_ctx(LYRA2_CTX *ctx, void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
+    const uint64_t nBlocksInput = ((saltlen + pwdlen + 6 * sizeof (uint64_t)) / BLOCK_LEN_BLAKE2_SAFE_BYTES) + 1;
+    if (nRows < 3 || nRows > LYRA2_CTX_MAX_ROWS || nCols > LYRA2_CTX_MAX_COLS ||
+        nBlocksInput * BLOCK_LEN_BLAKE2_SAFE_BYTES > nRows * nCols * BLOCK_LEN_BYTES) {
+      return -1;
+    }
+    LYRA2_core(ctx->matrix, ctx->rows, ctx->state, K, kLen, pwd, pwdlen, salt, saltlen, timeCost, nRows, nCols);
+    return 0;
+}
+
+/**
+ * Executes Lyra2 based on the G function from Blake2b. This version supports salts and passwords
+ * whose combined length is smaller than the size of the memory matrix, (i.e., (nRows x nCols x b) bits,
+ * where "b" is the underlying sponge's bitrate). In this implementation, the "basil" is composed by all
+ * integer parameters (treated as type "unsigned int") in the order they are provided, plus the value
+ * of nCols, (i.e., basil = kLen || pwdlen || saltlen || timeCost || nRows || nCols).
+ *
+ * @param K The derived key to be output by the algorithm
+ * @param kLen Desired key length
+ * @param pwd User password
+ * @param pwdlen Password length
+ * @param salt Salt
+ * @param saltlen Salt length
+ * @param timeCost Parameter to determine the processing time (T)
+ * @param nRows Number or rows of the memory matrix (R)
+ * @param nCols Number of columns of the memory matrix (C)
+ *
+ * @return 0 if the key is generated correctly; -1 if there is an error (usually due to lack of memory for allocation)
+ */
+int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
+    //Parameters that fit a context (such as Lyra2REv2's 4x4 matrix) run on the stack
+    if (nRows <= LYRA2_CTX_MAX_ROWS && nCols <= LYRA2_CTX_MAX_COLS) {
+      LYRA2_CTX ctx;
+      return LYRA2_ctx(&ctx, K, kLen, pwd, pwdlen, salt, saltlen, timeCost, nRows, nCols);
+    }
+
+    //Tries to allocate enough space for the whole memory matrix
+    const int64_t ROW_LEN_BYTES = BLOCK_LEN_INT64 * nCols * 8;
+    uint64_t *wholeMatrix = malloc((int64_t) nRows * ROW_LEN_BYTES);
+    uint64_t **memMatrix = malloc(nRows * sizeof (uint64_t*));
+    uint64_t state[16];
+    if (wholeMatrix == NULL || memMatrix == NULL) {
+      free(wholeMatrix);
+      free(memMatrix);
+      return -1;
+    }
+
+    LYRA2_core(wholeMatrix, memMatrix, state, K, kLen, pwd, pwdlen, salt, saltlen, timeCost, nRows, nCols);
 
+    free(memMatrix);
+    free(wholeMatrix);
     return 0;
 }
 
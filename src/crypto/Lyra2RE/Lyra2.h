@@ -39,8 +39,25 @@ typedef unsigned char byte;
         #define BLOCK_LEN_BYTES (BLOCK_LEN_INT64 * 8)    //Block length, in bytes
 #endif
 
+//Largest matrix a LYRA2_CTX can hold; Lyra2REv2 uses nRows = nCols = 4
+#define LYRA2_CTX_MAX_ROWS 8
+#define LYRA2_CTX_MAX_COLS 8
+
+//Working memory for one Lyra2 evaluation. A context can be reused for any number
+//of calls, which keeps LYRA2_ctx() free of heap allocations.
+typedef struct {
+    uint64_t state[16];
+    uint64_t matrix[LYRA2_CTX_MAX_ROWS * LYRA2_CTX_MAX_COLS * BLOCK_LEN_INT64];
+    uint64_t *rows[LYRA2_CTX_MAX_ROWS];
+} LYRA2_CTX;
+
 int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols);
 
+int LYRA2_ctx(LYRA2_CTX *ctx, void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols);
+
+//Picks the fastest sponge permutation for this CPU; returns its name
+const char *LYRA2AutoDetect(void);
+
 int LYRA2_old(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols);
 
 #ifdef __cplusplus
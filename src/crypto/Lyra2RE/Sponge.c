@@ -18,9 +18,17 @@
  * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#if defined(HAVE_CONFIG_H)
+#include <config/galactrum-config.h>
+#endif
+
+#include <assert.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+#include <cpuid.h>
+#endif
 #include "Sponge.h"
 #include "Lyra2.h"
 
@@ -53,24 +61,29 @@ inline void initState(uint64_t state[/*16*/]) {
     state[15] = blake2b_IV[7];
 }
 
+/**
+ * Portable implementation of the sponge permutation: applies "rounds" rounds
+ * of Blake2b's compression function (without message words) to the state.
+ *
+ * @param v         A 1024-bit (16 uint64_t) array to be processed by Blake2b's G function
+ * @param rounds    Number of rounds to apply
+ */
+static void blake2bLyraRounds_generic(uint64_t *v, unsigned int rounds) {
+    while (rounds--) {
+        ROUND_LYRA(0);
+    }
+}
+
+/** Permutation used by the sponge; replaced by a SIMD version in LYRA2AutoDetect(). */
+static blake2bLyraRoundsFn blake2bLyraRounds = blake2bLyraRounds_generic;
+
 /**
  * Execute Blake2b's G function, with all 12 rounds.
  *
  * @param v     A 1024-bit (16 uint64_t) array to be processed by Blake2b's G function
  */
 inline static void blake2bLyra(uint64_t *v) {
-    ROUND_LYRA(0);
-    ROUND_LYRA(1);
-    ROUND_LYRA(2);
-    ROUND_LYRA(3);
-    ROUND_LYRA(4);
-    ROUND_LYRA(5);
-    ROUND_LYRA(6);
-    ROUND_LYRA(7);
-    ROUND_LYRA(8);
-    ROUND_LYRA(9);
-    ROUND_LYRA(10);
-    ROUND_LYRA(11);
+    blake2bLyraRounds(v, 12);
 }
 
 /**
@@ -163,7 +176,7 @@ inline void absorbBlockBlake2Safe(uint64_t *state, const uint64_t *in) {
  * @param state     The current state of the sponge
  * @param rowOut    Row to receive the data squeezed
  */
-inline void reducedSqueezeRow0(uint64_t* state, uint64_t* rowOut, uint64_t nCols) {
+static void reducedSqueezeRow0_generic(uint64_t* state, uint64_t* rowOut, uint64_t nCols) {
     uint64_t* ptrWord = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to M[0][C-1]
     int i;
     //M[row][C-1-col] = H.reduced_squeeze()
@@ -198,7 +211,7 @@ inline void reducedSqueezeRow0(uint64_t* state, uint64_t* rowOut, uint64_t nCols
  * @param rowIn		Row to feed the sponge
  * @param rowOut	Row to receive the sponge's output
  */
-inline void reducedDuplexRow1(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols) {
+static void reducedDuplexRow1_generic(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols) {
     uint64_t* ptrWordIn = rowIn;				//In Lyra2: pointer to prev
     uint64_t* ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to row
     int i;
@@ -258,7 +271,7 @@ inline void reducedDuplexRow1(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut
  * @param rowOut         Row receiving the output
  *
  */
-inline void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+static void reducedDuplexRowSetup_generic(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
     uint64_t* ptrWordIn = rowIn;				//In Lyra2: pointer to prev
     uint64_t* ptrWordInOut = rowInOut;				//In Lyra2: pointer to row*
     uint64_t* ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to row
@@ -332,7 +345,7 @@ inline void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *ro
  * @param rowOut         Row receiving the output
  *
  */
-inline void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+static void reducedDuplexRow_generic(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
     uint64_t* ptrWordInOut = rowInOut; //In Lyra2: pointer to row*
     uint64_t* ptrWordIn = rowIn; //In Lyra2: pointer to prev
     uint64_t* ptrWordOut = rowOut; //In Lyra2: pointer to row
@@ -393,6 +406,96 @@ inline void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOu
 }
 
 
+//---- Dispatch: row operations may be replaced by SIMD versions that keep the state in registers
+typedef void (*reducedSqueezeRow0Fn)(uint64_t *state, uint64_t *rowOut, uint64_t nCols);
+typedef void (*reducedDuplexRow1Fn)(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols);
+typedef void (*reducedDuplexRowFn)(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
+
+static reducedSqueezeRow0Fn reducedSqueezeRow0Impl = reducedSqueezeRow0_generic;
+static reducedDuplexRow1Fn reducedDuplexRow1Impl = reducedDuplexRow1_generic;
+static reducedDuplexRowFn reducedDuplexRowSetupImpl = reducedDuplexRowSetup_generic;
+static reducedDuplexRowFn reducedDuplexRowImpl = reducedDuplexRow_generic;
+
+void reducedSqueezeRow0(uint64_t *state, uint64_t *rowOut, uint64_t nCols) {
+    reducedSqueezeRow0Impl(state, rowOut, nCols);
+}
+
+void reducedDuplexRow1(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols) {
+    reducedDuplexRow1Impl(state, rowIn, rowOut, nCols);
+}
+
+void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    reducedDuplexRowSetupImpl(state, rowIn, rowInOut, rowOut, nCols);
+}
+
+void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    reducedDuplexRowImpl(state, rowIn, rowInOut, rowOut, nCols);
+}
+
+/** Known-answer test: Lyra2REv2 parameters over a fixed 32-byte password/salt. */
+static int LYRA2SelfTest(void) {
+    static const unsigned char expected[32] = {
+        0xd4, 0x97, 0xa4, 0xa2, 0xce, 0x68, 0xa6, 0x52, 0x5d, 0x8e, 0x5c, 0x16, 0x5f, 0x31, 0x7c, 0xe3,
+        0xe5, 0x5a, 0x44, 0xbf, 0x0e, 0xad, 0x95, 0x3b, 0xb7, 0xcc, 0xda, 0x53, 0x0e, 0xbf, 0x0d, 0x1b
+    };
+    unsigned char in[32], out[32];
+    int i;
+    for (i = 0; i < 32; i++) {
+        in[i] = (unsigned char)(i * 7);
+    }
+    if (LYRA2(out, 32, in, 32, in, 32, 1, 4, 4) != 0) {
+        return 0;
+    }
+    return memcmp(out, expected, sizeof(out)) == 0;
+}
+
+static void useGenericSponge(void) {
+    blake2bLyraRounds = blake2bLyraRounds_generic;
+    reducedSqueezeRow0Impl = reducedSqueezeRow0_generic;
+    reducedDuplexRow1Impl = reducedDuplexRow1_generic;
+    reducedDuplexRowSetupImpl = reducedDuplexRowSetup_generic;
+    reducedDuplexRowImpl = reducedDuplexRow_generic;
+}
+
+/**
+ * Selects the sponge implementation for this CPU, in the same way
+ * SHA256AutoDetect() picks a SHA-256 transform. Must be called before other
+ * threads start hashing.
+ *
+ * @return The name of the selected implementation
+ */
+const char *LYRA2AutoDetect(void) {
+    useGenericSponge();
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+    uint32_t eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        //AVX2 needs the CPU flag as well as OS support for saving the YMM registers
+        if (((ecx >> 27) & 1) && __get_cpuid_max(0, NULL) >= 7) {
+            uint32_t xcr0_lo, xcr0_hi, eax7, ebx7, ecx7, edx7;
+            __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+            __cpuid_count(7, 0, eax7, ebx7, ecx7, edx7);
+            if ((xcr0_lo & 6) == 6 && ((ebx7 >> 5) & 1)) {
+                blake2bLyraRounds = blake2bLyraRounds_avx2;
+                reducedSqueezeRow0Impl = reducedSqueezeRow0_avx2;
+                reducedDuplexRow1Impl = reducedDuplexRow1_avx2;
+                reducedDuplexRowSetupImpl = reducedDuplexRowSetup_avx2;
+                reducedDuplexRowImpl = reducedDuplexRow_avx2;
+                assert(LYRA2SelfTest());
+                return "avx2";
+            }
+        }
+        if ((edx >> 26) & 1) {
+            blake2bLyraRounds = blake2bLyraRounds_sse2;
+            assert(LYRA2SelfTest());
+            return "sse2";
+        }
+    }
+#endif
+
+    assert(LYRA2SelfTest());
+    return "standard";
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -75,6 +75,18 @@ static inline uint64_t rotr64( const uint64_t w, const unsigned c ){
     G(r,7,v[ 3],v[ 4],v[ 9],v[14]);
 
 
+//---- Permutation
+//Applies "rounds" rounds of Blake2b's G function to a 16-word state
+typedef void (*blake2bLyraRoundsFn)(uint64_t *v, unsigned int rounds);
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+void blake2bLyraRounds_sse2(uint64_t *v, unsigned int rounds);
+void blake2bLyraRounds_avx2(uint64_t *v, unsigned int rounds);
+void reducedSqueezeRow0_avx2(uint64_t *state, uint64_t *rowOut, uint64_t nCols);
+void reducedDuplexRow1_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols);
+void reducedDuplexRowSetup_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
+void reducedDuplexRow_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
+#endif
+
 //---- Housekeeping
 void initState(uint64_t state[/*16*/]);
 
@@ -0,0 +1,177 @@
+/**
+ * AVX2 implementation of the Lyra2 sponge permutation (Blake2b's round
+ * function without message words). Each row of the 4x4 state fits in one
+ * 256-bit register; diagonalization is a lane permutation.
+ *
+ * This software is hereby placed in the public domain.
+ */
+#if defined(HAVE_CONFIG_H)
+#include <config/galactrum-config.h>
+#endif
+
+#include "Sponge.h"
+#include "Lyra2.h"
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+#include <immintrin.h>
+
+#define AVX2_ROTR32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define AVX2_ROTR24(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8( \
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, \
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define AVX2_ROTR16(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8( \
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, \
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define AVX2_ROTR63(x) _mm256_or_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+#define AVX2_G(a, b, c, d) \
+  do { \
+    a = _mm256_add_epi64(a, b); \
+    d = AVX2_ROTR32(_mm256_xor_si256(d, a)); \
+    c = _mm256_add_epi64(c, d); \
+    b = AVX2_ROTR24(_mm256_xor_si256(b, c)); \
+    a = _mm256_add_epi64(a, b); \
+    d = AVX2_ROTR16(_mm256_xor_si256(d, a)); \
+    c = _mm256_add_epi64(c, d); \
+    b = AVX2_ROTR63(_mm256_xor_si256(b, c)); \
+  } while(0)
+
+#define AVX2_ROUND(a, b, c, d) \
+  do { \
+    AVX2_G(a, b, c, d); \
+    /* Diagonalize: rotate rows 2, 3 and 4 left by 1, 2 and 3 words */ \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3)); \
+    AVX2_G(a, b, c, d); \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1)); \
+  } while(0)
+
+/* rotW: rotate the 12-word rate part (a, b, c) by one word towards higher indexes */
+#define AVX2_ROTW(a, b, c, r0, r1, r2) \
+  do { \
+    __m256i ta = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(2, 1, 0, 3)); \
+    __m256i tb = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+    __m256i tc = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(2, 1, 0, 3)); \
+    r0 = _mm256_blend_epi32(ta, tc, 0x03); \
+    r1 = _mm256_blend_epi32(tb, ta, 0x03); \
+    r2 = _mm256_blend_epi32(tc, tb, 0x03); \
+  } while(0)
+
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define AVX2_STORE(p, x) _mm256_storeu_si256((__m256i*)(p), (x))
+
+__attribute__((target("avx2")))
+void blake2bLyraRounds_avx2(uint64_t *v, unsigned int rounds) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)&v[0]);
+    __m256i b = _mm256_loadu_si256((const __m256i*)&v[4]);
+    __m256i c = _mm256_loadu_si256((const __m256i*)&v[8]);
+    __m256i d = _mm256_loadu_si256((const __m256i*)&v[12]);
+
+    while (rounds--) {
+        AVX2_ROUND(a, b, c, d);
+    }
+
+    _mm256_storeu_si256((__m256i*)&v[0], a);
+    _mm256_storeu_si256((__m256i*)&v[4], b);
+    _mm256_storeu_si256((__m256i*)&v[8], c);
+    _mm256_storeu_si256((__m256i*)&v[12], d);
+}
+
+/* Row operations keep the sponge state in registers across all columns; see Sponge.c for the portable versions. */
+
+__attribute__((target("avx2")))
+void reducedSqueezeRow0_avx2(uint64_t *state, uint64_t *rowOut, uint64_t nCols) {
+    __m256i a = AVX2_LOAD(&state[0]), b = AVX2_LOAD(&state[4]), c = AVX2_LOAD(&state[8]), d = AVX2_LOAD(&state[12]);
+    uint64_t *ptrWord = rowOut + (nCols - 1) * BLOCK_LEN_INT64;
+    uint64_t i;
+    for (i = 0; i < nCols; i++) {
+        AVX2_STORE(&ptrWord[0], a);
+        AVX2_STORE(&ptrWord[4], b);
+        AVX2_STORE(&ptrWord[8], c);
+        ptrWord -= BLOCK_LEN_INT64;
+        AVX2_ROUND(a, b, c, d);
+    }
+    AVX2_STORE(&state[0], a); AVX2_STORE(&state[4], b); AVX2_STORE(&state[8], c); AVX2_STORE(&state[12], d);
+}
+
+__attribute__((target("avx2")))
+void reducedDuplexRow1_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols) {
+    __m256i a = AVX2_LOAD(&state[0]), b = AVX2_LOAD(&state[4]), c = AVX2_LOAD(&state[8]), d = AVX2_LOAD(&state[12]);
+    uint64_t *ptrWordIn = rowIn;
+    uint64_t *ptrWordOut = rowOut + (nCols - 1) * BLOCK_LEN_INT64;
+    uint64_t i;
+    for (i = 0; i < nCols; i++) {
+        __m256i in0 = AVX2_LOAD(&ptrWordIn[0]), in1 = AVX2_LOAD(&ptrWordIn[4]), in2 = AVX2_LOAD(&ptrWordIn[8]);
+        a = _mm256_xor_si256(a, in0);
+        b = _mm256_xor_si256(b, in1);
+        c = _mm256_xor_si256(c, in2);
+        AVX2_ROUND(a, b, c, d);
+        AVX2_STORE(&ptrWordOut[0], _mm256_xor_si256(in0, a));
+        AVX2_STORE(&ptrWordOut[4], _mm256_xor_si256(in1, b));
+        AVX2_STORE(&ptrWordOut[8], _mm256_xor_si256(in2, c));
+        ptrWordIn += BLOCK_LEN_INT64;
+        ptrWordOut -= BLOCK_LEN_INT64;
+    }
+    AVX2_STORE(&state[0], a); AVX2_STORE(&state[4], b); AVX2_STORE(&state[8], c); AVX2_STORE(&state[12], d);
+}
+
+__attribute__((target("avx2")))
+void reducedDuplexRowSetup_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    __m256i a = AVX2_LOAD(&state[0]), b = AVX2_LOAD(&state[4]), c = AVX2_LOAD(&state[8]), d = AVX2_LOAD(&state[12]);
+    uint64_t *ptrWordIn = rowIn;
+    uint64_t *ptrWordInOut = rowInOut;
+    uint64_t *ptrWordOut = rowOut + (nCols - 1) * BLOCK_LEN_INT64;
+    uint64_t i;
+    for (i = 0; i < nCols; i++) {
+        __m256i in0 = AVX2_LOAD(&ptrWordIn[0]), in1 = AVX2_LOAD(&ptrWordIn[4]), in2 = AVX2_LOAD(&ptrWordIn[8]);
+        __m256i io0 = AVX2_LOAD(&ptrWordInOut[0]), io1 = AVX2_LOAD(&ptrWordInOut[4]), io2 = AVX2_LOAD(&ptrWordInOut[8]);
+        __m256i r0, r1, r2;
+        a = _mm256_xor_si256(a, _mm256_add_epi64(in0, io0));
+        b = _mm256_xor_si256(b, _mm256_add_epi64(in1, io1));
+        c = _mm256_xor_si256(c, _mm256_add_epi64(in2, io2));
+        AVX2_ROUND(a, b, c, d);
+        AVX2_STORE(&ptrWordOut[0], _mm256_xor_si256(in0, a));
+        AVX2_STORE(&ptrWordOut[4], _mm256_xor_si256(in1, b));
+        AVX2_STORE(&ptrWordOut[8], _mm256_xor_si256(in2, c));
+        AVX2_ROTW(a, b, c, r0, r1, r2);
+        AVX2_STORE(&ptrWordInOut[0], _mm256_xor_si256(io0, r0));
+        AVX2_STORE(&ptrWordInOut[4], _mm256_xor_si256(io1, r1));
+        AVX2_STORE(&ptrWordInOut[8], _mm256_xor_si256(io2, r2));
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+        ptrWordOut -= BLOCK_LEN_INT64;
+    }
+    AVX2_STORE(&state[0], a); AVX2_STORE(&state[4], b); AVX2_STORE(&state[8], c); AVX2_STORE(&state[12], d);
+}
+
+__attribute__((target("avx2")))
+void reducedDuplexRow_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    __m256i a = AVX2_LOAD(&state[0]), b = AVX2_LOAD(&state[4]), c = AVX2_LOAD(&state[8]), d = AVX2_LOAD(&state[12]);
+    uint64_t *ptrWordInOut = rowInOut;
+    uint64_t *ptrWordIn = rowIn;
+    uint64_t *ptrWordOut = rowOut;
+    uint64_t i;
+    for (i = 0; i < nCols; i++) {
+        __m256i r0, r1, r2;
+        a = _mm256_xor_si256(a, _mm256_add_epi64(AVX2_LOAD(&ptrWordIn[0]), AVX2_LOAD(&ptrWordInOut[0])));
+        b = _mm256_xor_si256(b, _mm256_add_epi64(AVX2_LOAD(&ptrWordIn[4]), AVX2_LOAD(&ptrWordInOut[4])));
+        c = _mm256_xor_si256(c, _mm256_add_epi64(AVX2_LOAD(&ptrWordIn[8]), AVX2_LOAD(&ptrWordInOut[8])));
+        AVX2_ROUND(a, b, c, d);
+        //rowOut and rowInOut may alias: update rowOut first, then reload rowInOut
+        AVX2_STORE(&ptrWordOut[0], _mm256_xor_si256(AVX2_LOAD(&ptrWordOut[0]), a));
+        AVX2_STORE(&ptrWordOut[4], _mm256_xor_si256(AVX2_LOAD(&ptrWordOut[4]), b));
+        AVX2_STORE(&ptrWordOut[8], _mm256_xor_si256(AVX2_LOAD(&ptrWordOut[8]), c));
+        AVX2_ROTW(a, b, c, r0, r1, r2);
+        AVX2_STORE(&ptrWordInOut[0], _mm256_xor_si256(AVX2_LOAD(&ptrWordInOut[0]), r0));
+        AVX2_STORE(&ptrWordInOut[4], _mm256_xor_si256(AVX2_LOAD(&ptrWordInOut[4]), r1));
+        AVX2_STORE(&ptrWordInOut[8], _mm256_xor_si256(AVX2_LOAD(&ptrWordInOut[8]), r2));
+        ptrWordOut += BLOCK_LEN_INT64;
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+    }
+    AVX2_STORE(&state[0], a); AVX2_STORE(&state[4], b); AVX2_STORE(&state[8], c); AVX2_STORE(&state[12], d);
+}
+#endif
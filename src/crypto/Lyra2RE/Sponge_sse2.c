@@ -0,0 +1,88 @@
+/**
+ * SSE2 implementation of the Lyra2 sponge permutation (Blake2b's round
+ * function without message words). Each row of the 4x4 state is held in two
+ * 128-bit registers, following the Blake2b SSE2 reference implementation by
+ * Samuel Neves (https://blake2.net/).
+ *
+ * This software is hereby placed in the public domain.
+ */
+#if defined(HAVE_CONFIG_H)
+#include <config/galactrum-config.h>
+#endif
+
+#include "Sponge.h"
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+#include <emmintrin.h>
+
+#define SSE2_ROTR64(x, c) _mm_or_si128(_mm_srli_epi64((x), (c)), _mm_slli_epi64((x), 64 - (c)))
+#define SSE2_ROTR32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define SSE2_ROTR63(x) _mm_or_si128(_mm_srli_epi64((x), 63), _mm_add_epi64((x), (x)))
+
+#define SSE2_G(a, b, c, d) \
+  do { \
+    a = _mm_add_epi64(a, b); \
+    d = SSE2_ROTR32(_mm_xor_si128(d, a)); \
+    c = _mm_add_epi64(c, d); \
+    b = SSE2_ROTR64(_mm_xor_si128(b, c), 24); \
+    a = _mm_add_epi64(a, b); \
+    d = SSE2_ROTR64(_mm_xor_si128(d, a), 16); \
+    c = _mm_add_epi64(c, d); \
+    b = SSE2_ROTR63(_mm_xor_si128(b, c)); \
+  } while(0)
+
+/* Rotates rows 2, 3 and 4 left by 1, 2 and 3 words so the diagonals line up as columns */
+#define SSE2_DIAGONALIZE(r2l, r3l, r4l, r2h, r3h, r4h) \
+  do { \
+    __m128i t0 = r4l, t1 = r2l, t2 = r3l; \
+    r3l = r3h; \
+    r3h = t2; \
+    r4l = _mm_unpackhi_epi64(r4h, _mm_unpacklo_epi64(t0, t0)); \
+    r4h = _mm_unpackhi_epi64(t0, _mm_unpacklo_epi64(r4h, r4h)); \
+    r2l = _mm_unpackhi_epi64(r2l, _mm_unpacklo_epi64(r2h, r2h)); \
+    r2h = _mm_unpackhi_epi64(r2h, _mm_unpacklo_epi64(t1, t1)); \
+  } while(0)
+
+#define SSE2_UNDIAGONALIZE(r2l, r3l, r4l, r2h, r3h, r4h) \
+  do { \
+    __m128i t0 = r3l, t1, t2; \
+    r3l = r3h; \
+    r3h = t0; \
+    t1 = r2l; \
+    t2 = r4l; \
+    r2l = _mm_unpackhi_epi64(r2h, _mm_unpacklo_epi64(r2l, r2l)); \
+    r2h = _mm_unpackhi_epi64(t1, _mm_unpacklo_epi64(r2h, r2h)); \
+    r4l = _mm_unpackhi_epi64(r4l, _mm_unpacklo_epi64(r4h, r4h)); \
+    r4h = _mm_unpackhi_epi64(r4h, _mm_unpacklo_epi64(t2, t2)); \
+  } while(0)
+
+__attribute__((target("sse2")))
+void blake2bLyraRounds_sse2(uint64_t *v, unsigned int rounds) {
+    __m128i r1l = _mm_loadu_si128((const __m128i*)&v[0]);
+    __m128i r1h = _mm_loadu_si128((const __m128i*)&v[2]);
+    __m128i r2l = _mm_loadu_si128((const __m128i*)&v[4]);
+    __m128i r2h = _mm_loadu_si128((const __m128i*)&v[6]);
+    __m128i r3l = _mm_loadu_si128((const __m128i*)&v[8]);
+    __m128i r3h = _mm_loadu_si128((const __m128i*)&v[10]);
+    __m128i r4l = _mm_loadu_si128((const __m128i*)&v[12]);
+    __m128i r4h = _mm_loadu_si128((const __m128i*)&v[14]);
+
+    while (rounds--) {
+        SSE2_G(r1l, r2l, r3l, r4l);
+        SSE2_G(r1h, r2h, r3h, r4h);
+        SSE2_DIAGONALIZE(r2l, r3l, r4l, r2h, r3h, r4h);
+        SSE2_G(r1l, r2l, r3l, r4l);
+        SSE2_G(r1h, r2h, r3h, r4h);
+        SSE2_UNDIAGONALIZE(r2l, r3l, r4l, r2h, r3h, r4h);
+    }
+
+    _mm_storeu_si128((__m128i*)&v[0], r1l);
+    _mm_storeu_si128((__m128i*)&v[2], r1h);
+    _mm_storeu_si128((__m128i*)&v[4], r2l);
+    _mm_storeu_si128((__m128i*)&v[6], r2h);
+    _mm_storeu_si128((__m128i*)&v[8], r3l);
+    _mm_storeu_si128((__m128i*)&v[10], r3h);
+    _mm_storeu_si128((__m128i*)&v[12], r4l);
+    _mm_storeu_si128((__m128i*)&v[14], r4h);
+}
+#endif
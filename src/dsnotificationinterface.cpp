@@ -68,6 +68,8 @@ void CDSNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock
     {
         instantsend.SyncTransaction(tx, nullptr);
     }
+
+    mnodeman.BlockConnected(*block, pindex);
 }
 
 void CDSNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock> &block)
@@ -76,4 +78,6 @@ void CDSNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBl
     {
         instantsend.SyncTransaction(tx, nullptr);
     }
+
+    mnodeman.BlockDisconnected(*block);
 }
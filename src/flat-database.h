@@ -13,6 +13,37 @@
 
 #include <boost/filesystem.hpp>
 
+/**
+ * The data part of a flat database file. Like with a CDataStream, size() is
+ * what is left to read, some objects only read trailing fields if there is any.
+ */
+class CFlatDBFile
+{
+private:
+    CAutoFile& file;
+    size_t nDataLeft;
+
+public:
+    CFlatDBFile(CAutoFile& fileIn, size_t nDataSize) : file(fileIn), nDataLeft(nDataSize) {}
+
+    int GetType() const { return file.GetType(); }
+    int GetVersion() const { return file.GetVersion(); }
+    size_t size() const { return nDataLeft; }
+
+    void read(char* pch, size_t nSize)
+    {
+        if (nSize > nDataLeft)
+            throw std::ios_base::failure("CFlatDBFile::read: end of data");
+        file.read(pch, nSize);
+        nDataLeft -= nSize;
+    }
+
+    void write(const char* pch, size_t nSize)
+    {
+        file.write(pch, nSize);
+    }
+};
+
 /** 
 *   Generic Dumping and Loading
 *   ---------------------------
@@ -36,6 +67,8 @@ private:
     boost::filesystem::path pathDB;
     std::string strFilename;
     std::string strMagicMessage;
+    // checksum of the file as last read or written
+    uint256 hashLast;
 
     bool Write(const T& objToSave)
     {
@@ -43,30 +76,46 @@ private:
 
         int64_t nStart = GetTimeMillis();
 
-        // serialize, checksum data up to that point, then append checksum
+        // the object serializes itself under its lock, the file is written
+        // from the buffer once the lock is released
         CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-        ssObj << strMagicMessage; // specific magic message for this type of object
-        ssObj << Params().MessageStart(); // network specific magic number
-        ssObj << objToSave;
-        uint256 hash = Hash(ssObj.begin(), ssObj.end());
-        ssObj << hash;
-
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
+        try {
+            ssObj << objToSave;
+        }
+        catch (std::exception &e) {
+            return error("%s: Serialize error - %s", __func__, e.what());
+        }
+
+        // write to a temporary file and move it in place, a crash leaves the old file intact
+        boost::filesystem::path pathTmp = pathDB;
+        pathTmp += ".new";
+        FILE *file = fopen(pathTmp.string().c_str(), "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
 
-        // Write and commit header, data
+        // checksum data up to that point, then append checksum
+        uint256 hash;
         try {
-            fileout << ssObj;
+            CFlatDBFile fileData(fileout, 0);
+            CHashedWriter<CFlatDBFile> writer(&fileData);
+            writer << strMagicMessage; // specific magic message for this type of object
+            writer << Params().MessageStart(); // network specific magic number
+            writer.write(ssObj.data(), ssObj.size());
+            hash = writer.GetHash();
+            fileout << hash;
         }
         catch (std::exception &e) {
-            return error("%s: Serialize or I/O error - %s", __func__, e.what());
+            return error("%s: I/O error - %s", __func__, e.what());
         }
+        if (!FileCommit(fileout.Get()))
+            return error("%s: Failed to flush file %s", __func__, pathTmp.string());
         fileout.fclose();
+        if (!RenameOver(pathTmp, pathDB))
+            return error("%s: Rename-into-place failed", __func__);
+        hashLast = hash;
 
-        LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+        LogPrintf("Written info to %s  %dms, %dkB\n", strFilename, GetTimeMillis() - nStart, ssObj.size() >> 10);
         LogPrintf("     %s\n", objToSave.ToString());
 
         return true;
@@ -77,6 +126,7 @@ private:
         //LOCK(objToLoad.cs);
 
         int64_t nStart = GetTimeMillis();
+        size_t nPeakMemoryStart = GetProcessPeakMemoryUsage();
         // open input file, and associate with CAutoFile
         FILE *file = fopen(pathDB.string().c_str(), "rb");
         CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
@@ -86,43 +136,22 @@ private:
             return FileError;
         }
 
-        // use file size to size memory buffer
-        int fileSize = boost::filesystem::file_size(pathDB);
-        int dataSize = fileSize - sizeof(uint256);
-        // Don't try to resize to a negative number if file is small
-        if (dataSize < 0)
-            dataSize = 0;
-        std::vector<unsigned char> vchData;
-        vchData.resize(dataSize);
-        uint256 hashIn;
-
-        // read data and checksum from file
-        try {
-            filein.read((char *)&vchData[0], dataSize);
-            filein >> hashIn;
-        }
-        catch (std::exception &e) {
-            error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            return HashReadError;
-        }
-        filein.fclose();
-
-        CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
-
-        // verify stored checksum matches input data
-        uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-        if (hashIn != hashTmp)
+        // the checksum follows the data
+        int64_t nDataSize = (int64_t)boost::filesystem::file_size(pathDB) - (int64_t)sizeof(uint256);
+        if (nDataSize < 0)
         {
-            error("%s: Checksum mismatch, data corrupted", __func__);
-            return IncorrectHash;
+            error("%s: File %s is too small", __func__, pathDB.string());
+            return HashReadError;
         }
 
-
+        // hash the data as it is read, the object is deserialized straight from the file
+        CFlatDBFile fileData(filein, nDataSize);
+        CHashVerifier<CFlatDBFile> verifier(&fileData);
         unsigned char pchMsgTmp[4];
         std::string strMagicMessageTmp;
         try {
             // de-serialize file header (file specific magic message) and ..
-            ssObj >> strMagicMessageTmp;
+            verifier >> strMagicMessageTmp;
 
             // ... verify the message matches predefined one
             if (strMagicMessage != strMagicMessageTmp)
@@ -133,7 +162,7 @@ private:
 
 
             // de-serialize file header (network specific magic number) and ..
-            ssObj >> pchMsgTmp;
+            verifier >> pchMsgTmp;
 
             // ... verify the network matches ours
             if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
@@ -141,24 +170,71 @@ private:
                 error("%s: Invalid network magic number", __func__);
                 return IncorrectMagicNumber;
             }
+        }
+        catch (std::exception &e) {
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return HashReadError;
+        }
+
+        bool fFormatError = false;
+        try {
+            if (fDryRun) {
+                // only the checksum is of interest
+                verifier.ignore(verifier.size());
+            } else {
+                // de-serialize data into T object
+                verifier >> objToLoad;
+            }
+        }
+        catch (std::exception &e) {
+            // keep hashing to tell a corrupted file from one in an unexpected format
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            fFormatError = true;
+        }
 
-            // de-serialize data into T object
-            ssObj >> objToLoad;
+        uint256 hashIn;
+        try {
+            if (fFormatError) {
+                verifier.ignore(verifier.size());
+            }
+            filein >> hashIn;
         }
         catch (std::exception &e) {
             objToLoad.Clear();
             error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return HashReadError;
+        }
+        filein.fclose();
+
+        // verify stored checksum matches input data
+        if (hashIn != verifier.GetHash())
+        {
+            objToLoad.Clear();
+            error("%s: Checksum mismatch, data corrupted", __func__);
+            return IncorrectHash;
+        }
+
+        if (fFormatError)
+        {
+            objToLoad.Clear();
             return IncorrectFormat;
         }
 
-        LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
-        LogPrintf("     %s\n", objToLoad.ToString());
-        if(!fDryRun) {
-            LogPrintf("%s: Cleaning....\n", __func__);
-            objToLoad.CheckAndRemove();
-            LogPrintf("     %s\n", objToLoad.ToString());
+        hashLast = hashIn;
+
+        if (fDryRun) {
+            return Ok;
         }
 
+        // of the whole process, other threads allocating meanwhile count as well
+        size_t nPeakMemory = GetProcessPeakMemoryUsage();
+        LogPrintf("Loaded info from %s  %dms, process peak memory %dMB (+%dMB)\n", strFilename, GetTimeMillis() - nStart,
+                  nPeakMemory >> 20, (nPeakMemory - nPeakMemoryStart) >> 20);
+        LogPrintf("     %s\n", objToLoad.ToString());
+        LogPrintf("%s: Cleaning....\n", __func__);
+        objToLoad.CheckAndRemove();
+        LogPrintf("     %s\n", objToLoad.ToString());
+
         return Ok;
     }
 
@@ -171,6 +247,9 @@ public:
         strMagicMessage = strMagicMessageIn;
     }
 
+    /// Checksum of the file as last loaded or dumped, null if there was none
+    const uint256& GetLastHash() const { return hashLast; }
+
     bool Load(T& objToLoad)
     {
         LogPrintf("Reading info from %s...\n", strFilename);
@@ -217,7 +296,8 @@ public:
         }
 
         LogPrintf("Writing info to %s...\n", strFilename);
-        Write(objToSave);
+        if (!Write(objToSave))
+            return false;
         LogPrintf("%s dump finished  %dms\n", strFilename, GetTimeMillis() - nStart);
 
         return true;
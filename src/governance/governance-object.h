@@ -252,6 +252,10 @@ public:
         return fileVotes;
     }
 
+    const CGovernanceObjectVoteFile& GetVoteFile() const {
+        return fileVotes;
+    }
+
     // Signature related functions
 
     void SetMasternodeVin(const COutPoint& outpoint);
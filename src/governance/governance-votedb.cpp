@@ -4,14 +4,140 @@
 
 #include <governance/governance-votedb.h>
 
+#include <util.h>
+
+static const char DB_OBJECT_VOTE = 'o';
+static const char DB_VOTE_PARENT = 'v';
+static const char DB_IN_USE = 'U';
+
+std::unique_ptr<CGovernanceVoteDB> pgovernancevotedb;
+
+CGovernanceVoteDB::CGovernanceVoteDB(size_t nCacheSize, bool fMemory, bool fWipe)
+    : CDBWrapper(GetDataDir() / "govvotes", nCacheSize, fMemory, fWipe)
+{}
+
+bool CGovernanceVoteDB::WriteVote(const CGovernanceVote& vote)
+{
+    uint256 nVoteHash = vote.GetHash();
+    CDBBatch batch(*this);
+    batch.Write(std::make_pair(DB_OBJECT_VOTE, std::make_pair(vote.GetParentHash(), nVoteHash)), vote);
+    batch.Write(std::make_pair(DB_VOTE_PARENT, nVoteHash), vote.GetParentHash());
+    return WriteBatch(batch);
+}
+
+bool CGovernanceVoteDB::ReadVote(const uint256& nParentHash, const uint256& nVoteHash, CGovernanceVote& vote)
+{
+    return Read(std::make_pair(DB_OBJECT_VOTE, std::make_pair(nParentHash, nVoteHash)), vote);
+}
+
+bool CGovernanceVoteDB::HaveVote(const uint256& nParentHash, const uint256& nVoteHash)
+{
+    return Exists(std::make_pair(DB_OBJECT_VOTE, std::make_pair(nParentHash, nVoteHash)));
+}
+
+bool CGovernanceVoteDB::ReadVoteParent(const uint256& nVoteHash, uint256& nParentHashRet)
+{
+    return Read(std::make_pair(DB_VOTE_PARENT, nVoteHash), nParentHashRet);
+}
+
+std::vector<CGovernanceVote> CGovernanceVoteDB::ReadVotes(const uint256& nParentHash)
+{
+    std::vector<CGovernanceVote> vecResult;
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_OBJECT_VOTE, std::make_pair(nParentHash, uint256())));
+    std::pair<char, std::pair<uint256, uint256> > key;
+    while (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_OBJECT_VOTE && key.second.first == nParentHash) {
+        CGovernanceVote vote;
+        if (!pcursor->GetValue(vote)) {
+            LogPrintf("CGovernanceVoteDB::ReadVotes -- failed to read vote %s\n", key.second.second.ToString());
+        } else {
+            vecResult.push_back(vote);
+        }
+        pcursor->Next();
+    }
+    return vecResult;
+}
+
+int CGovernanceVoteDB::EraseVotes(const uint256& nParentHash, const COutPoint* pOutpointMasternode)
+{
+    int nErased = 0;
+    CDBBatch batch(*this);
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_OBJECT_VOTE, std::make_pair(nParentHash, uint256())));
+    std::pair<char, std::pair<uint256, uint256> > key;
+    while (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_OBJECT_VOTE && key.second.first == nParentHash) {
+        CGovernanceVote vote;
+        if (!pOutpointMasternode || (pcursor->GetValue(vote) && vote.GetMasternodeOutpoint() == *pOutpointMasternode)) {
+            batch.Erase(key);
+            batch.Erase(std::make_pair(DB_VOTE_PARENT, key.second.second));
+            ++nErased;
+        }
+        pcursor->Next();
+    }
+    WriteBatch(batch);
+    return nErased;
+}
+
+bool CGovernanceVoteDB::PruneVotes(std::function<bool(const uint256&)> fKeep, std::map<uint256, int>& mapVoteCountsRet)
+{
+    mapVoteCountsRet.clear();
+    int nErased = 0;
+    CDBBatch batch(*this);
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_OBJECT_VOTE, std::make_pair(uint256(), uint256())));
+    std::pair<char, std::pair<uint256, uint256> > key;
+    while (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_OBJECT_VOTE) {
+        if (fKeep(key.second.first)) {
+            ++mapVoteCountsRet[key.second.first];
+        } else {
+            batch.Erase(key);
+            batch.Erase(std::make_pair(DB_VOTE_PARENT, key.second.second));
+            ++nErased;
+        }
+        // keep the batch small, pruning may erase the whole history
+        if (batch.SizeEstimate() > (1 << 20)) {
+            if (!WriteBatch(batch)) return false;
+            batch.Clear();
+        }
+        pcursor->Next();
+    }
+    LogPrintf("CGovernanceVoteDB::PruneVotes -- erased %d votes of unknown objects\n", nErased);
+    return WriteBatch(batch, true);
+}
+
+bool CGovernanceVoteDB::WriteInUse(bool fInUse)
+{
+    return Write(DB_IN_USE, fInUse ? '1' : '0', true);
+}
+
+bool CGovernanceVoteDB::ReadInUse()
+{
+    char ch;
+    if (!Read(DB_IN_USE, ch))
+        return !IsEmpty();
+    return ch == '1';
+}
+
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile()
-    : nMemoryVotes(0),
+    : pvotedb(nullptr),
+      nParentHash(),
+      nVoteCount(0),
+      listVotes(),
+      mapVoteIndex()
+{}
+
+CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(CGovernanceVoteDB* pvotedbIn)
+    : pvotedb(pvotedbIn),
+      nParentHash(),
+      nVoteCount(0),
       listVotes(),
       mapVoteIndex()
 {}
 
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other)
-    : nMemoryVotes(other.nMemoryVotes),
+    : pvotedb(other.pvotedb),
+      nParentHash(other.nParentHash),
+      nVoteCount(other.nVoteCount),
       listVotes(other.listVotes),
       mapVoteIndex()
 {
@@ -20,31 +146,57 @@ CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVote
 
 void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
 {
+    CGovernanceVoteDB* pdb = GetVoteDB();
+    nParentHash = vote.GetParentHash();
+    if(pdb && !pdb->WriteVote(vote)) {
+        LogPrintf("CGovernanceObjectVoteFile::AddVote -- failed to write vote %s\n", vote.GetHash().ToString());
+    }
+
     listVotes.insert(std::begin(listVotes), 1, vote);
     mapVoteIndex[vote.GetHash()] = listVotes.begin();
-    ++nMemoryVotes;
+    ++nVoteCount;
+
+    // the older votes are on disk
+    if(pdb && listVotes.size() > (size_t)MAX_MEMORY_VOTES) {
+        mapVoteIndex.erase(listVotes.back().GetHash());
+        listVotes.pop_back();
+    }
 }
 
 bool CGovernanceObjectVoteFile::HasVote(const uint256& nHash) const
 {
+    CGovernanceVoteDB* pdb = GetVoteDB();
     vote_m_cit it = mapVoteIndex.find(nHash);
-    if(it == mapVoteIndex.end()) {
-        return false;
+    if(it != mapVoteIndex.end()) {
+        return true;
     }
-    return true;
+    return nVoteCount > 0 && pdb && pdb->HaveVote(nParentHash, nHash);
 }
 
 bool CGovernanceObjectVoteFile::GetVote(const uint256& nHash, CGovernanceVote& vote) const
 {
+    CGovernanceVoteDB* pdb = GetVoteDB();
     vote_m_cit it = mapVoteIndex.find(nHash);
-    if(it == mapVoteIndex.end()) {
-        return false;
+    if(it != mapVoteIndex.end()) {
+        vote = *(it->second);
+        return true;
     }
-    vote = *(it->second);
-    return true;
+    return nVoteCount > 0 && pdb && pdb->ReadVote(nParentHash, nHash, vote);
 }
 
 std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
+{
+    CGovernanceVoteDB* pdb = GetVoteDB();
+    if(!pdb) {
+        return GetCachedVotes();
+    }
+    if(nVoteCount == 0) {
+        return std::vector<CGovernanceVote>();
+    }
+    return pdb->ReadVotes(nParentHash);
+}
+
+std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetCachedVotes() const
 {
     std::vector<CGovernanceVote> vecResult;
     for(vote_l_cit it = listVotes.begin(); it != listVotes.end(); ++it) {
@@ -55,10 +207,11 @@ std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 
 void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
+    CGovernanceVoteDB* pdb = GetVoteDB();
     vote_l_it it = listVotes.begin();
     while(it != listVotes.end()) {
         if(it->GetMasternodeOutpoint() == outpointMasternode) {
-            --nMemoryVotes;
+            if(!pdb) --nVoteCount;
             mapVoteIndex.erase(it->GetHash());
             listVotes.erase(it++);
         }
@@ -66,11 +219,27 @@ void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpo
             ++it;
         }
     }
+    if(pdb && nVoteCount > 0) {
+        nVoteCount -= pdb->EraseVotes(nParentHash, &outpointMasternode);
+    }
+}
+
+void CGovernanceObjectVoteFile::RemoveAllVotes()
+{
+    CGovernanceVoteDB* pdb = GetVoteDB();
+    if(pdb && nVoteCount > 0) {
+        pdb->EraseVotes(nParentHash);
+    }
+    listVotes.clear();
+    mapVoteIndex.clear();
+    nVoteCount = 0;
 }
 
 CGovernanceObjectVoteFile& CGovernanceObjectVoteFile::operator=(const CGovernanceObjectVoteFile& other)
 {
-    nMemoryVotes = other.nMemoryVotes;
+    pvotedb = other.pvotedb;
+    nParentHash = other.nParentHash;
+    nVoteCount = other.nVoteCount;
     listVotes = other.listVotes;
     RebuildIndex();
     return *this;
@@ -79,14 +248,12 @@ CGovernanceObjectVoteFile& CGovernanceObjectVoteFile::operator=(const CGovernanc
 void CGovernanceObjectVoteFile::RebuildIndex()
 {
     mapVoteIndex.clear();
-    nMemoryVotes = 0;
     vote_l_it it = listVotes.begin();
     while(it != listVotes.end()) {
         CGovernanceVote& vote = *it;
         uint256 nHash = vote.GetHash();
         if(mapVoteIndex.find(nHash) == mapVoteIndex.end()) {
             mapVoteIndex[nHash] = it;
-            ++nMemoryVotes;
             ++it;
         }
         else {
@@ -5,20 +5,59 @@
 #ifndef GOVERNANCE_VOTEDB_H
 #define GOVERNANCE_VOTEDB_H
 
+#include <functional>
 #include <list>
 #include <map>
+#include <memory>
 
+#include <dbwrapper.h>
 #include <governance/governance-vote.h>
 #include <serialize.h>
 #include <uint256.h>
 
+/** Cache size of the governance vote database */
+static const size_t GOVERNANCE_VOTE_DB_CACHE_SIZE = 8 << 20;
+
+/**
+ * Access to the governance vote database (govvotes/)
+ *
+ * Votes are stored by governance object so that the votes of one object can be
+ * read or erased with a single range scan, with an index from vote hash to object.
+ */
+class CGovernanceVoteDB : public CDBWrapper
+{
+public:
+    explicit CGovernanceVoteDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    bool WriteVote(const CGovernanceVote& vote);
+    bool ReadVote(const uint256& nParentHash, const uint256& nVoteHash, CGovernanceVote& vote);
+    bool HaveVote(const uint256& nParentHash, const uint256& nVoteHash);
+    /** Find the governance object a stored vote belongs to */
+    bool ReadVoteParent(const uint256& nVoteHash, uint256& nParentHashRet);
+    std::vector<CGovernanceVote> ReadVotes(const uint256& nParentHash);
+
+    /** Erase the votes of one object, all of them or only those of one masternode.
+     *  Returns the number of votes erased. */
+    int EraseVotes(const uint256& nParentHash, const COutPoint* pOutpointMasternode = nullptr);
+
+    /** Erase the votes of every object fKeep returns false for and count the
+     *  votes kept per object */
+    bool PruneVotes(std::function<bool(const uint256&)> fKeep, std::map<uint256, int>& mapVoteCountsRet);
+
+    /** Set while the node runs. governance.dat only matches the stored votes
+     *  when it was written during a clean shutdown. */
+    bool WriteInUse(bool fInUse);
+    bool ReadInUse();
+};
+
+extern std::unique_ptr<CGovernanceVoteDB> pgovernancevotedb;
+
 /**
  * Represents the collection of votes associated with a given CGovernanceObject
- * Recently received votes are held in memory until a maximum size is reached after
- * which older votes a flushed to a disk file.
+ * Votes are written to the governance vote database as they are received, the
+ * most recently received ones are also held in memory up to a maximum number.
  *
- * Note: This is a stub implementation that doesn't limit the number of votes held
- * in memory and doesn't flush to disk.
+ * Note: Without a vote database all votes are kept in memory.
  */
 class CGovernanceObjectVoteFile
 {
@@ -36,10 +75,17 @@ public: // Types
     typedef vote_m_t::const_iterator vote_m_cit;
 
 private:
-    static const int MAX_MEMORY_VOTES = -1;
+    static const int MAX_MEMORY_VOTES = 100;
 
-    int nMemoryVotes;
+    /// Vote database to use instead of pgovernancevotedb, for unit tests
+    CGovernanceVoteDB* pvotedb;
 
+    /// Hash of the governance object, set with the first vote
+    uint256 nParentHash;
+
+    int nVoteCount;
+
+    /// Most recently received votes first
     vote_l_t listVotes;
 
     vote_m_t mapVoteIndex;
@@ -47,6 +93,8 @@ private:
 public:
     CGovernanceObjectVoteFile();
 
+    explicit CGovernanceObjectVoteFile(CGovernanceVoteDB* pvotedbIn);
+
     CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other);
 
     /**
@@ -55,37 +103,53 @@ public:
     void AddVote(const CGovernanceVote& vote);
 
     /**
-     * Return true if the vote with this hash is currently cached in memory
+     * Return true if the file holds the vote with this hash
      */
     bool HasVote(const uint256& nHash) const;
 
     /**
-     * Retrieve a vote cached in memory
+     * Retrieve a vote from memory or disk
      */
     bool GetVote(const uint256& nHash, CGovernanceVote& vote) const;
 
-    int GetVoteCount() {
-        return nMemoryVotes;
+    int GetVoteCount() const {
+        return nVoteCount;
+    }
+
+    void SetVoteCount(int nCount) {
+        nVoteCount = nCount;
     }
 
     std::vector<CGovernanceVote> GetVotes() const;
 
+    /// Votes currently held in memory
+    std::vector<CGovernanceVote> GetCachedVotes() const;
+
     CGovernanceObjectVoteFile& operator=(const CGovernanceObjectVoteFile& other);
 
     void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
 
+    /// Erase every vote, from memory and disk, when the object is deleted
+    void RemoveAllVotes();
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action)
     {
-        READWRITE(nMemoryVotes);
-        READWRITE(listVotes);
+        // the votes themselves are in the vote database
+        READWRITE(nParentHash);
+        READWRITE(nVoteCount);
         if(ser_action.ForRead()) {
-            RebuildIndex();
+            listVotes.clear();
+            mapVoteIndex.clear();
         }
     }
 private:
+    CGovernanceVoteDB* GetVoteDB() const {
+        return pvotedb ? pvotedb : pgovernancevotedb.get();
+    }
+
     void RebuildIndex();
 
 };
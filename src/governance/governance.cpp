@@ -19,7 +19,7 @@ CGovernanceManager governance;
 
 int nSubmittedFinalBudget;
 
-const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-12";
+const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-13";
 const int CGovernanceManager::MAX_TIME_FUTURE_DEVIATION = 60*60;
 const int CGovernanceManager::RELIABLE_PROPAGATION_TIME = 60;
 
@@ -27,6 +27,7 @@ CGovernanceManager::CGovernanceManager()
     : nTimeLastDiff(0),
       nCachedBlockHeight(0),
       mapObjects(),
+      journalObjects("govobjects"),
       mapErasedGovernanceObjects(),
       mapMasternodeOrphanObjects(),
       mapWatchdogObjects(),
@@ -64,8 +65,8 @@ bool CGovernanceManager::HaveVoteForHash(uint256 nHash)
 {
     LOCK(cs);
 
-    CGovernanceObject* pGovobj = NULL;
-    if(!mapVoteToObject.Get(nHash,pGovobj)) {
+    CGovernanceObject* pGovobj = FindVoteObject(nHash);
+    if(!pGovobj) {
         return false;
     }
 
@@ -75,18 +76,39 @@ bool CGovernanceManager::HaveVoteForHash(uint256 nHash)
     return true;
 }
 
+CGovernanceObject* CGovernanceManager::FindVoteObject(const uint256& nHash)
+{
+    LOCK(cs);
+
+    CGovernanceObject* pGovobj = NULL;
+    if(mapVoteToObject.Get(nHash, pGovobj)) {
+        return pGovobj;
+    }
+
+    // older votes are only indexed on disk
+    uint256 nParentHash;
+    if(!pgovernancevotedb || !pgovernancevotedb->ReadVoteParent(nHash, nParentHash)) {
+        return NULL;
+    }
+    return FindGovernanceObject(nParentHash);
+}
+
 int CGovernanceManager::GetVoteCount() const
 {
     LOCK(cs);
-    return (int)mapVoteToObject.GetSize();
+    int nCount = 0;
+    for (const auto& objpair : mapObjects) {
+        nCount += objpair.second.GetVoteFile().GetVoteCount();
+    }
+    return nCount;
 }
 
 bool CGovernanceManager::SerializeVoteForHash(uint256 nHash, CGovernanceVote& voteOut)
 {
     LOCK(cs);
 
-    CGovernanceObject* pGovobj = NULL;
-    if(!mapVoteToObject.Get(nHash,pGovobj)) {
+    CGovernanceObject* pGovobj = FindVoteObject(nHash);
+    if(!pGovobj) {
         return false;
     }
 
@@ -292,6 +314,7 @@ void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernance
         }
         else if(govobj.ProcessVote(NULL, vote, exception, connman)) {
             vote.Relay(connman);
+            journalObjects.MarkDirty(nHash);
             fRemove = true;
         }
         if(fRemove) {
@@ -350,6 +373,7 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
 
     // INSERT INTO OUR GOVERNANCE OBJECT MEMORY
     mapObjects.insert(std::make_pair(nHash, govobj));
+    journalObjects.MarkDirty(nHash);
 
     // SHOULD WE ADD THIS OBJECT TO ANY OTHER MANANGERS?
 
@@ -411,6 +435,7 @@ bool CGovernanceManager::UpdateCurrentWatchdog(CGovernanceObject& watchdogNew)
             if(it->second.nDeletionTime == 0) {
                 it->second.nDeletionTime = nNow;
             }
+            journalObjects.MarkDirty(it->first);
         }
         nHashWatchdogCurrent = watchdogNew.GetHash();
         nTimeWatchdogCurrent = watchdogNew.GetCreationTime();
@@ -446,6 +471,7 @@ void CGovernanceManager::UpdateCachesAndClean()
                     if(it2->second.nDeletionTime == 0) {
                         it2->second.nDeletionTime = nNow;
                     }
+                    journalObjects.MarkDirty(it2->first);
                 }
                 if(it->first == nHashWatchdogCurrent) {
                     nHashWatchdogCurrent = uint256();
@@ -465,6 +491,7 @@ void CGovernanceManager::UpdateCachesAndClean()
         }
         it->second.ClearMasternodeVotes();
         it->second.fDirtyCache = true;
+        journalObjects.MarkDirty(it->first);
     }
 
     ScopedLockBool guard(cs, fRateChecksEnabled, false);
@@ -495,6 +522,8 @@ void CGovernanceManager::UpdateCachesAndClean()
 
             // UPDATE SENTINEL SIGNALING VARIABLES
             pObj->UpdateSentinelVariables();
+
+            journalObjects.MarkDirty(nHash);
         }
 
         if(pObj->IsSetCachedDelete() && (nHash == nHashWatchdogCurrent)) {
@@ -538,6 +567,8 @@ void CGovernanceManager::UpdateCachesAndClean()
             }
 
             mapErasedGovernanceObjects.insert(std::make_pair(nHash, nTimeExpired));
+            pObj->GetVoteFile().RemoveAllVotes();
+            journalObjects.MarkDirty(nHash);
             mapObjects.erase(it++);
         } else {
             ++it;
@@ -560,10 +591,14 @@ CGovernanceObject *CGovernanceManager::FindGovernanceObject(const uint256& nHash
 {
     LOCK(cs);
 
-    if(mapObjects.count(nHash))
-        return &mapObjects[nHash];
+    object_m_it it = mapObjects.find(nHash);
+    if(it == mapObjects.end()) {
+        return nullptr;
+    }
 
-    return nullptr;
+    // the caller may change the object
+    journalObjects.MarkDirty(nHash);
+    return &it->second;
 }
 
 std::vector<CGovernanceVote> CGovernanceManager::GetMatchingVotes(const uint256& nParentHash)
@@ -591,15 +626,17 @@ std::vector<CGovernanceVote> CGovernanceManager::GetCurrentVotes(const uint256&
     CGovernanceObject& govobj = it->second;
 
     CMasternode mn;
-    std::map<COutPoint, CMasternode> mapMasternodes;
+    CMasternodeMan::list_snapshot_ptr_t plist;
+    std::map<COutPoint, CMasternode> mapMasternodesFiltered;
     if(mnCollateralOutpointFilter == COutPoint()) {
-        mapMasternodes = mnodeman.GetFullMasternodeMap();
+        plist = mnodeman.GetListSnapshot();
     } else if (mnodeman.Get(mnCollateralOutpointFilter, mn)) {
-        mapMasternodes[mnCollateralOutpointFilter] = mn;
+        mapMasternodesFiltered[mnCollateralOutpointFilter] = mn;
     }
+    const std::map<COutPoint, CMasternode>& mapMasternodes = plist ? plist->mapMasternodes : mapMasternodesFiltered;
 
     // Loop thru each MN collateral outpoint and get the votes for the `nParentHash` governance object
-    for (auto& mnpair : mapMasternodes)
+    for (const auto& mnpair : mapMasternodes)
     {
         // get a vote_rec_t from the govobj
         vote_rec_t voteRecord;
@@ -972,6 +1009,7 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
     bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman);
     if(fOk) {
         mapVoteToObject.Insert(nHashVote, &govobj);
+        journalObjects.MarkDirty(nHashGovobj);
 
         if(govobj.GetObjectType() == GOVERNANCE_OBJECT_WATCHDOG) {
             mnodeman.UpdateWatchdogVoteTime(vote.GetMasternodeOutpoint());
@@ -990,6 +1028,7 @@ void CGovernanceManager::CheckMasternodeOrphanVotes(CConnman& connman)
 
     for(object_m_it it = mapObjects.begin(); it != mapObjects.end(); ++it) {
         it->second.CheckOrphanVotes(connman);
+        journalObjects.MarkDirty(it->first);
     }
 }
 
@@ -1271,13 +1310,28 @@ void CGovernanceManager::RebuildIndexes()
     mapVoteToObject.Clear();
     for(object_m_it it = mapObjects.begin(); it != mapObjects.end(); ++it) {
         CGovernanceObject& govobj = it->second;
-        std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetVotes();
+        // votes that are not in memory are found through the vote database
+        std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetCachedVotes();
         for(size_t i = 0; i < vecVotes.size(); ++i) {
             mapVoteToObject.Insert(vecVotes[i].GetHash(), &govobj);
         }
     }
 }
 
+void CGovernanceManager::PruneVotes()
+{
+    LOCK(cs);
+    std::map<uint256, int> mapVoteCounts;
+    auto fKeep = [this](const uint256& nParentHash) { return mapObjects.count(nParentHash) > 0; };
+    if(!pgovernancevotedb || !pgovernancevotedb->PruneVotes(fKeep, mapVoteCounts)) {
+        return;
+    }
+    for(auto& objpair : mapObjects) {
+        objpair.second.GetVoteFile().SetVoteCount(mapVoteCounts[objpair.first]);
+        journalObjects.MarkDirty(objpair.first);
+    }
+}
+
 void CGovernanceManager::AddCachedTriggers()
 {
     LOCK(cs);
@@ -1298,12 +1352,57 @@ void CGovernanceManager::InitOnLoad()
     LOCK(cs);
     int64_t nStart = GetTimeMillis();
     LogPrintf("Preparing masternode indexes and governance triggers...\n");
+    if(pgovernancevotedb) {
+        // after an unclean shutdown the vote database is ahead of governance.dat,
+        // and without governance.dat none of the stored votes are of use
+        if(pgovernancevotedb->ReadInUse() || mapObjects.empty()) {
+            PruneVotes();
+        }
+        pgovernancevotedb->WriteInUse(true);
+    }
     RebuildIndexes();
     AddCachedTriggers();
     LogPrintf("Masternode indexes and governance triggers prepared  %dms\n", GetTimeMillis() - nStart);
     LogPrintf("     %s\n", ToString());
 }
 
+void CGovernanceManager::SetJournalBaseline()
+{
+    LOCK(cs);
+    journalObjects.SetBaseline(mapObjects);
+}
+
+int CGovernanceManager::WriteJournal(CCacheJournalDB& db, bool fSync)
+{
+    CDBBatch batch(db);
+    int nRecords;
+    {
+        LOCK(cs);
+        nRecords = journalObjects.WriteChanges(batch, mapObjects);
+    }
+    bool fWritten = db.WriteBatch(batch, fSync);
+    LOCK(cs);
+    if(!fWritten) {
+        journalObjects.Abort();
+        return -1;
+    }
+    journalObjects.Commit();
+    return nRecords;
+}
+
+bool CGovernanceManager::ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    LOCK(cs);
+    if(!journalObjects.Replay(db, hashSnapshot, mapObjects)) return false;
+    // InitOnLoad rebuilds the indexes
+    return true;
+}
+
+void CGovernanceManager::ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    journalObjects.Reset(batch, db, hashSnapshot);
+}
+
 std::string CGovernanceManager::ToString() const
 {
     LOCK(cs);
@@ -8,6 +8,7 @@
 //#define ENABLE_GALACTRUM_DEBUG
 
 #include <bloom.h>
+#include <cache-journal.h>
 #include <cachemap.h>
 #include <cachemultimap.h>
 #include <chain.h>
@@ -234,6 +235,8 @@ private:
     // keep track of the scanning errors
     object_m_t mapObjects;
 
+    CCacheJournalTable<uint256, CGovernanceObject> journalObjects;
+
     // mapErasedGovernanceObjects contains key-value pairs, where
     //   key   - governance object's hash
     //   value - expiration time for deleted objects
@@ -326,6 +329,7 @@ public:
 
         LogPrint(BCLog::GOBJECT, "Governance object manager was cleared\n");
         mapObjects.clear();
+        journalObjects.MarkAllDirty();
         mapErasedGovernanceObjects.clear();
         mapWatchdogObjects.clear();
         nHashWatchdogCurrent = uint256();
@@ -338,6 +342,12 @@ public:
 
     std::string ToString() const;
 
+    /// Journal of the governance objects, their votes are in the vote database between snapshots, see CJournaledFlatDB
+    void SetJournalBaseline();
+    int WriteJournal(CCacheJournalDB& db, bool fSync);
+    bool ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot);
+    void ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot);
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -450,6 +460,12 @@ private:
 
     void RebuildIndexes();
 
+    /// Object of a vote held in memory or in the vote database
+    CGovernanceObject* FindVoteObject(const uint256& nHash);
+
+    /// Erase stored votes of unknown objects and recount the votes of the others
+    void PruneVotes();
+
     void AddCachedTriggers();
 
     bool UpdateCurrentWatchdog(CGovernanceObject& watchdogNew);
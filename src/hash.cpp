@@ -6,6 +6,8 @@
 #include <crypto/common.h>
 #include <crypto/hmac_sha512.h>
 
+#include <assert.h>
+
 
 inline uint32_t ROTL32(uint32_t x, int8_t r)
 {
@@ -245,3 +247,75 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+void lyra2re2_hash_lanes(const unsigned char* const* inputs, size_t len, uint256* hashes, size_t lanes)
+{
+    assert(lanes <= LYRA2RE2_MAX_LANES);
+    static const unsigned char pblank[1] = {0};
+    uint256 hashA[LYRA2RE2_MAX_LANES];
+    uint256 hashB[LYRA2RE2_MAX_LANES];
+    size_t i;
+
+    // blake256, sharing the state after a common first block
+    static const size_t BLAKE256_BLOCK_SIZE = 64;
+    size_t nPrefix = 0;
+    if (len >= BLAKE256_BLOCK_SIZE && lanes > 1) {
+        nPrefix = BLAKE256_BLOCK_SIZE;
+        for (i = 1; i < lanes && nPrefix; i++) {
+            if (memcmp(inputs[i], inputs[0], BLAKE256_BLOCK_SIZE) != 0)
+                nPrefix = 0;
+        }
+    }
+    sph_blake256_context ctx_blake_prefix;
+    sph_blake256_init(&ctx_blake_prefix);
+    if (nPrefix)
+        sph_blake256(&ctx_blake_prefix, inputs[0], nPrefix);
+    for (i = 0; i < lanes; i++) {
+        sph_blake256_context ctx_blake = ctx_blake_prefix;
+        sph_blake256(&ctx_blake, len ? inputs[i] + nPrefix : pblank, len - nPrefix);
+        sph_blake256_close(&ctx_blake, hashA[i].begin());
+    }
+
+    sph_keccak256_context ctx_keccak_init;
+    sph_keccak256_init(&ctx_keccak_init);
+    for (i = 0; i < lanes; i++) {
+        sph_keccak256_context ctx_keccak = ctx_keccak_init;
+        sph_keccak256(&ctx_keccak, hashA[i].begin(), 32);
+        sph_keccak256_close(&ctx_keccak, hashB[i].begin());
+    }
+
+    sph_cubehash256_context ctx_cubehash_init;
+    sph_cubehash256_init(&ctx_cubehash_init);
+    for (i = 0; i < lanes; i++) {
+        sph_cubehash256_context ctx_cubehash = ctx_cubehash_init;
+        sph_cubehash256(&ctx_cubehash, hashB[i].begin(), 32);
+        sph_cubehash256_close(&ctx_cubehash, hashA[i].begin());
+    }
+
+    LYRA2_CTX ctx_lyra2;
+    for (i = 0; i < lanes; i++) {
+        LYRA2_ctx(&ctx_lyra2, hashB[i].begin(), 32, hashA[i].begin(), 32, hashA[i].begin(), 32, 1, 4, 4);
+    }
+
+    sph_skein256_context ctx_skein_init;
+    sph_skein256_init(&ctx_skein_init);
+    for (i = 0; i < lanes; i++) {
+        sph_skein256_context ctx_skein = ctx_skein_init;
+        sph_skein256(&ctx_skein, hashB[i].begin(), 32);
+        sph_skein256_close(&ctx_skein, hashA[i].begin());
+    }
+
+    for (i = 0; i < lanes; i++) {
+        sph_cubehash256_context ctx_cubehash = ctx_cubehash_init;
+        sph_cubehash256(&ctx_cubehash, hashA[i].begin(), 32);
+        sph_cubehash256_close(&ctx_cubehash, hashB[i].begin());
+    }
+
+    sph_bmw256_context ctx_bmw_init;
+    sph_bmw256_init(&ctx_bmw_init);
+    for (i = 0; i < lanes; i++) {
+        sph_bmw256_context ctx_bmw = ctx_bmw_init;
+        sph_bmw256(&ctx_bmw, hashB[i].begin(), 32);
+        sph_bmw256_close(&ctx_bmw, hashes[i].begin());
+    }
+}
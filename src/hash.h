@@ -284,6 +284,8 @@ public:
         this->write(pch, nSize);
     }
 
+    size_t size() const { return source->size(); }
+
     void ignore(size_t nSize)
     {
         char data[1024];
@@ -303,6 +305,33 @@ public:
     }
 };
 
+/** Writes data to an underlying stream, while hashing the written data. */
+template<typename Destination>
+class CHashedWriter : public CHashWriter
+{
+private:
+    Destination* destination;
+
+public:
+    explicit CHashedWriter(Destination* destination_) : CHashWriter(destination_->GetType(), destination_->GetVersion()), destination(destination_) {}
+
+    void write(const char* pch, size_t nSize)
+    {
+        destination->write(pch, nSize);
+        CHashWriter::write(pch, nSize);
+    }
+
+    size_t size() const { return destination->size(); }
+
+    template<typename T>
+    CHashedWriter<Destination>& operator<<(const T& obj)
+    {
+        // Serialize to this stream
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+};
+
 /** Compute the 256-bit hash of an object's serialization. */
 template<typename T>
 uint256 SerializeHash(const T& obj, int nType=SER_GETHASH, int nVersion=PROTOCOL_VERSION)
@@ -460,4 +489,17 @@ inline uint256 lyra2re2_hash(const T1 pbegin, const T1 pend)
     return hash[0];
 }
 
+/** Largest batch accepted by lyra2re2_hash_lanes(). */
+static const size_t LYRA2RE2_MAX_LANES = 8;
+
+/**
+ * Lyra2REv2 over several independent inputs of the same length, giving the
+ * same results as calling lyra2re2_hash() on each. The chain runs stage by
+ * stage across all lanes: primitive contexts are initialised once per stage,
+ * one LYRA2 context is reused, and when every input shares its first 64 bytes
+ * (block headers that differ only in nonce) the first blake256 block is
+ * compressed once for the whole batch.
+ */
+void lyra2re2_hash_lanes(const unsigned char* const* inputs, size_t len, uint256* hashes, size_t lanes);
+
 #endif // BITCOIN_HASH_H
@@ -62,6 +62,7 @@
 #include <stakenode/stakenodeman.h>
 #include <netfulfilledman.h>
 #include <governance/governance.h>
+#include <cache-journal.h>
 #include <flat-database.h>
 
 #ifndef WIN32
@@ -190,6 +191,7 @@ static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 
 static boost::thread_group threadGroup;
 static CScheduler scheduler;
+static CScheduler extensionScheduler;
 
 void Interrupt()
 {
@@ -218,28 +220,39 @@ static bool LoadExtensionsDataCaches()
         boost::filesystem::remove((pathDB / strDBName).string(), ec);
     }
 
-    CFlatDB<CMasternodeMan> flatdb1(strDBName, "magicMasternodeCache");
+    // changes since the .dat files were last written are replayed from the journal
+    pcachejournal.reset(new CCacheJournalDB(CACHE_JOURNAL_DB_CACHE_SIZE));
+
+    CJournaledFlatDB<CMasternodeMan> flatdb1(strDBName, "magicMasternodeCache");
     if(!flatdb1.Load(mnodeman)) {
         return InitError(_("Failed to load masternode cache from") + "\n" + (pathDB / strDBName).string());
     }
 
+    // governance votes are kept in their own database, governance.dat only has per object counts
+    pgovernancevotedb.reset(new CGovernanceVoteDB(GOVERNANCE_VOTE_DB_CACHE_SIZE));
+
+    CJournaledFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
+    CJournaledFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
     if(mnodeman.size()) {
         strDBName = "mnpayments.dat";
         uiInterface.InitMessage(_("Loading masternode payment cache..."));
-        CFlatDB<CMasternodePayments> flatdb2(strDBName, "magicMasternodePaymentsCache");
         if(!flatdb2.Load(mnpayments)) {
             return InitError(_("Failed to load masternode payments cache from") + "\n" + (pathDB / strDBName).string());
         }
 
         strDBName = "governance.dat";
         uiInterface.InitMessage(_("Loading governance cache..."));
-        CFlatDB<CGovernanceManager> flatdb3(strDBName, "magicGovernanceCache");
         if(!flatdb3.Load(governance)) {
             return InitError(_("Failed to load governance cache from") + "\n" + (pathDB / strDBName).string());
         }
         governance.InitOnLoad();
     } else {
         uiInterface.InitMessage(_("Masternode cache is empty, skipping payments and governance cache..."));
+        // their journals no longer apply to anything
+        flatdb2.Reset(mnpayments);
+        flatdb3.Reset(governance);
+        // drops the stored votes of the governance objects that were not loaded
+        governance.InitOnLoad();
     }
 
     strDBName = "netfulfilled.dat";
@@ -249,7 +262,7 @@ static bool LoadExtensionsDataCaches()
         return InitError(_("Failed to load fulfilled requests cache from") + "\n" + (pathDB / strDBName).string());
     }
 
-    CFlatDB<CStakenodeMan> flatdb5("stakenodecache.dat", "magicStakenodeCache");
+    CJournaledFlatDB<CStakenodeMan> flatdb5("stakenodecache.dat", "magicStakenodeCache");
     if(!flatdb5.Load(stakenodeman)) {
         return InitError(_("Failed to load stakenode cache from") + "\n" + (pathDB / strDBName).string());
     }
@@ -257,19 +270,54 @@ static bool LoadExtensionsDataCaches()
     return true;
 }
 
+// journal flushes and snapshots run on the extension scheduler as well as at shutdown
+static CCriticalSection cs_extension_caches;
+
+static void FlushExtensionsDataCaches()
+{
+    LOCK(cs_extension_caches);
+    CJournaledFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
+    flatdb1.Flush(mnodeman, false);
+    CJournaledFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
+    flatdb2.Flush(mnpayments, false);
+    CJournaledFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
+    flatdb3.Flush(governance, false);
+    CJournaledFlatDB<CStakenodeMan> flatdb5("stakenodecache.dat", "magicStakenodeCache");
+    flatdb5.Flush(stakenodeman, false);
+}
+
+static void SnapshotExtensionsDataCaches()
+{
+    LOCK(cs_extension_caches);
+    CJournaledFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
+    flatdb1.Snapshot(mnodeman);
+    CJournaledFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
+    flatdb2.Snapshot(mnpayments);
+    CJournaledFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
+    flatdb3.Snapshot(governance);
+    CJournaledFlatDB<CStakenodeMan> flatdb5("stakenodecache.dat", "magicStakenodeCache");
+    flatdb5.Snapshot(stakenodeman);
+    CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
+    flatdb4.Dump(netfulfilledman);
+}
+
 static void StoreExtensionsDataCaches()
 {
-    // STORE DATA CACHES INTO SERIALIZED DAT FILES
-    CFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
-    flatdb1.Dump(mnodeman);
-    CFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
-    flatdb2.Dump(mnpayments);
-    CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
-    flatdb3.Dump(governance);
+    // JOURNAL WHAT CHANGED SINCE THE LAST FLUSH, THE SNAPSHOTS ARE KEPT AS THEY ARE
+    LOCK(cs_extension_caches);
+    CJournaledFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
+    flatdb1.Flush(mnodeman, true);
+    CJournaledFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
+    flatdb2.Flush(mnpayments, true);
+    CJournaledFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
+    if(flatdb3.Flush(governance, true) && pgovernancevotedb) {
+        // governance.dat and its journal now match the vote database
+        pgovernancevotedb->WriteInUse(false);
+    }
     CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
     flatdb4.Dump(netfulfilledman);
-    CFlatDB<CStakenodeMan> flatdb5("stakenodecache.dat", "magicStakenodeCache");
-    flatdb5.Dump(stakenodeman);
+    CJournaledFlatDB<CStakenodeMan> flatdb5("stakenodecache.dat", "magicStakenodeCache");
+    flatdb5.Flush(stakenodeman, true);
 }
 
 void Shutdown()
@@ -354,6 +402,8 @@ void Shutdown()
         pcoinsdbview.reset();
         pblocktree.reset();
     }
+    pgovernancevotedb.reset();
+    pcachejournal.reset();
     g_wallet_init_interface.Stop();
 
 #if ENABLE_ZMQ
@@ -559,6 +609,7 @@ void SetupServerArgs()
     gArgs.AddArg("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)", true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-maxmsgsigcachesize=<n>", strprintf("Limit the cache of verified masternode and stakenode message signatures to <n> MiB (default: %u)", DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxtxfee=<amt>", strprintf("Maximum total fees (in %s) to use in a single wallet transaction or raw transaction; setting this too low may abort large transactions (default: %s)",
         CURRENCY_UNIT, FormatMoney(DEFAULT_TRANSACTION_MAXFEE)), false, OptionsCategory::DEBUG_TEST);
@@ -602,6 +653,10 @@ void SetupServerArgs()
 
     gArgs.AddArg("-sporkkey", "Private key to send spork messages", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-staking", "Enable staking while working with wallet, default is 1", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-stakethreads=<n>", strprintf("Set the number of threads searching stake kernels (1 to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+        MAX_STAKE_THREADS, DEFAULT_STAKE_THREADS), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-instantsendvotethreads=<n>", strprintf("Set the number of threads checking InstantSend lock votes (1 to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+        MAX_INSTANTSEND_VOTE_THREADS, DEFAULT_INSTANTSEND_VOTE_THREADS), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-masternode=<n>", "Enable the client to act as a masternode (0-1, default: false", false, OptionsCategory::MASTERNODE);
     gArgs.AddArg("-mnconf=<file>", "Specify masternode configuration file (default: masternode.conf)", false, OptionsCategory::MASTERNODE);
     gArgs.AddArg("-mnconflock=<n>", "Lock masternodes from masternode configuration file (default: %u)", false, OptionsCategory::MASTERNODE);
@@ -1147,6 +1202,11 @@ bool AppInitParameterInteraction()
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
 
+    nStakeThreads = gArgs.GetArg("-stakethreads", DEFAULT_STAKE_THREADS);
+    if (nStakeThreads <= 0)
+        nStakeThreads += GetNumCores();
+    nStakeThreads = std::max(1, std::min(nStakeThreads, MAX_STAKE_THREADS));
+
     // block pruning; get the amount of disk space (in MiB) to allot for block & undo files
     int64_t nPruneArg = gArgs.GetArg("-prune", 0);
     if (nPruneArg < 0) {
@@ -1291,6 +1351,8 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string lyra2_algo = LYRA2AutoDetect();
+    LogPrintf("Using the '%s' Lyra2 implementation\n", lyra2_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1405,6 +1467,10 @@ bool AppInitPrivateSend()
     fEnableInstantSend = gArgs.GetBoolArg("-enableinstantsend", 1);
     nInstantSendDepth = gArgs.GetArg("-instantsenddepth", DEFAULT_INSTANTSEND_DEPTH);
     nInstantSendDepth = std::min(std::max(nInstantSendDepth, 0), 60);
+    nInstantSendVoteThreads = gArgs.GetArg("-instantsendvotethreads", DEFAULT_INSTANTSEND_VOTE_THREADS);
+    if (nInstantSendVoteThreads <= 0)
+        nInstantSendVoteThreads += GetNumCores();
+    nInstantSendVoteThreads = std::max(1, std::min(nInstantSendVoteThreads, MAX_INSTANTSEND_VOTE_THREADS));
 
     //lite mode disables all Masternode and Darksend related functionality
     fLiteMode = gArgs.GetBoolArg("-litemode", false);
@@ -1463,11 +1529,14 @@ bool AppInitMain()
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitMessageSignatureCache();
 
-    LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
+    LogPrintf("Using %u threads for script verification and header hashing\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadHeaderHashCheck);
+        }
     }
 
     // Start the lightweight task scheduler thread
@@ -1906,9 +1975,25 @@ bool AppInitMain()
     // GetMainSignals().UpdatedBlockTip(chainActive.Tip());
     pdsNotificationInterface->InitializeCurrentBlockTip();
 
-    // ********************************************************* Step 11d: start thread for galactrum extensions
+    // ********************************************************* Step 11d: start galactrum extension tasks
 
-    threadGroup.create_thread(boost::bind(net_processing_galactrum::ThreadProcessExtensions, g_connman.get()));
+    if (!fLiteMode) {
+        // extension maintenance gets a scheduler of its own so that it never holds up the main one
+        CScheduler::Function extensionLoop = boost::bind(&CScheduler::serviceQueue, &extensionScheduler);
+        for (int i = 0; i < net_processing_galactrum::EXTENSION_SCHEDULER_THREADS; i++)
+            threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "extensions", extensionLoop));
+        net_processing_galactrum::StartExtensions(extensionScheduler, g_connman.get());
+        // journal cache changes as they happen, rewrite the .dat files now and then
+        net_processing_galactrum::AddExtensionTask(extensionScheduler, "cachejournal", CACHE_JOURNAL_FLUSH_SECONDS * 1000,
+                                                   CACHE_JOURNAL_FLUSH_SECONDS * 1000, FlushExtensionsDataCaches);
+        net_processing_galactrum::AddExtensionTask(extensionScheduler, "cachesnapshot", CACHE_JOURNAL_SNAPSHOT_SECONDS * 1000,
+                                                   CACHE_JOURNAL_SNAPSHOT_SECONDS * 1000, SnapshotExtensionsDataCaches);
+
+        LogPrintf("Using %u threads for InstantSend vote checks\n", nInstantSendVoteThreads);
+        for (int i = 0; i < nInstantSendVoteThreads - 1; i++)
+            threadGroup.create_thread(&ThreadTxLockVoteCheck);
+        threadGroup.create_thread(boost::bind(ThreadProcessTxLockVotes, g_connman.get()));
+    }
 
     // ********************************************************* Step 12: start node
 
@@ -1996,6 +2081,9 @@ bool AppInitMain()
     g_wallet_init_interface.Start(scheduler);
     if(GetWallets().front() && gArgs.GetBoolArg("-staking", true))
     {
+        LogPrintf("Using %u threads for stake kernel search\n", nStakeThreads);
+        for (int i = 0; i < nStakeThreads - 1; i++)
+            threadGroup.create_thread(&ThreadStakeKernelCheck);
         threadGroup.create_thread(std::bind(&ThreadStakeMinter, boost::ref(chainparams), boost::ref(connman), GetWallets().front()));
     }
 
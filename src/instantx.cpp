@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <activemasternode.h>
+#include <checkqueue.h>
 #include <instantx.h>
 #include <key.h>
 #include <validation.h>
@@ -10,6 +11,7 @@
 #include <masternodeman.h>
 #include <messagesigner.h>
 #include <net.h>
+#include <net_processing.h>
 #include <protocol.h>
 #include <spork.h>
 #include <sync.h>
@@ -38,9 +40,61 @@ extern CTxMemPool mempool;
 bool fEnableInstantSend = true;
 int nInstantSendDepth = DEFAULT_INSTANTSEND_DEPTH;
 int nCompleteTXLocks;
+int nInstantSendVoteThreads = DEFAULT_INSTANTSEND_VOTE_THREADS;
 
 CInstantSend instantsend;
 
+namespace {
+
+/**
+ * Checks one lock vote: masternode, rank and signature. Never fails the
+ * batch, every vote gets its own result.
+ */
+class CTxLockVoteCheck
+{
+private:
+    const CTxLockVote* pvote;
+    char* pfValid;
+    CConnman* connman;
+
+public:
+    CTxLockVoteCheck() : pvote(nullptr), pfValid(nullptr), connman(nullptr) {}
+    CTxLockVoteCheck(const CTxLockVote* pvoteIn, char* pfValidIn, CConnman* connmanIn) :
+        pvote(pvoteIn), pfValid(pfValidIn), connman(connmanIn) {}
+
+    bool operator()()
+    {
+        *pfValid = pvote->IsValid(nullptr, *connman);
+        return true;
+    }
+
+    void swap(CTxLockVoteCheck& check)
+    {
+        std::swap(pvote, check.pvote);
+        std::swap(pfValid, check.pfValid);
+        std::swap(connman, check.connman);
+    }
+};
+
+CCheckQueue<CTxLockVoteCheck> txlockvotecheckqueue(16);
+
+} // namespace
+
+void ThreadTxLockVoteCheck()
+{
+    RenameThread("galactrum-isvch");
+    txlockvotecheckqueue.Thread();
+}
+
+void ThreadProcessTxLockVotes(CConnman* pConnman)
+{
+    RenameThread("galactrum-isvote");
+    while (true) {
+        boost::this_thread::interruption_point();
+        instantsend.ProcessPendingTxLockVotes(*pConnman);
+    }
+}
+
 static bool GetUTXOCoin(const COutPoint& outpoint, Coin& coin)
 {
     LOCK(cs_main);
@@ -91,22 +145,94 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
         // Ignore any InstantSend messages until masternode list is synced
         if(!masternodeSync.IsMasternodeListSynced()) return;
 
-        LOCK(cs_main);
-#ifdef ENABLE_WALLET
-        if (GetMainWallet())
-            LOCK(GetMainWallet()->cs_wallet);
-#endif
-        LOCK(cs_instantsend);
+        {
+            LOCK(cs_instantsend);
+            if(mapTxLockVotes.count(nVoteHash)) return;
+            AddTxLockVote(vote);
+        }
 
-        if(mapTxLockVotes.count(nVoteHash)) return;
-        mapTxLockVotes.insert(std::make_pair(nVoteHash, vote));
+        // ask the sender now, the vote checks run without it
+        if(!mnodeman.Has(vote.GetMasternodeOutpoint())) {
+            LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessMessage -- Unknown masternode %s\n", vote.GetMasternodeOutpoint().ToString());
+            mnodeman.AskForMN(pfrom, vote.GetMasternodeOutpoint(), connman);
+            return;
+        }
 
-        ProcessTxLockVote(pfrom, vote, connman);
+        // signature, rank and UTXO checks are done by ProcessPendingTxLockVotes
+        bool fQueued = false;
+        {
+            boost::unique_lock<boost::mutex> lock(mutexTxLockVotesPending);
+            if(vecTxLockVotesPending.size() < MAX_INSTANTSEND_PENDING_VOTES) {
+                vecTxLockVotesPending.push_back(vote);
+                fQueued = true;
+            }
+        }
+        if(!fQueued) {
+            // the vote checks are behind, forget the vote so that it can be asked for again later
+            LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessMessage -- too many pending votes, dropping vote %s, peer=%d\n", nVoteHash.ToString(), pfrom->GetId());
+            {
+                LOCK(cs_instantsend);
+                mapTxLockVotes.erase(nVoteHash);
+            }
+            LOCK(cs_main);
+            Misbehaving(pfrom->GetId(), 1);
+            return;
+        }
+        condTxLockVotesPending.notify_one();
 
         return;
     }
 }
 
+void CInstantSend::ProcessPendingTxLockVotes(CConnman& connman)
+{
+    std::vector<CTxLockVote> vecVotes;
+    {
+        boost::unique_lock<boost::mutex> lock(mutexTxLockVotesPending);
+        while (vecTxLockVotesPending.empty())
+            condTxLockVotesPending.wait(lock);
+        vecVotes.swap(vecTxLockVotesPending);
+    }
+
+    // Check the whole batch at once, holding none of cs_main, cs_wallet or
+    // cs_instantsend; IsValid() only takes them briefly for lookups.
+    int64_t nTimeStart = GetTimeMicros();
+    std::vector<char> vecValid(vecVotes.size(), 0);
+    if (nInstantSendVoteThreads <= 1 || vecVotes.size() < 2) {
+        for (size_t i = 0; i < vecVotes.size(); i++) {
+            CTxLockVoteCheck(&vecVotes[i], &vecValid[i], &connman)();
+        }
+    } else {
+        CCheckQueueControl<CTxLockVoteCheck> control(&txlockvotecheckqueue);
+        std::vector<CTxLockVoteCheck> vChecks;
+        vChecks.reserve(vecVotes.size());
+        for (size_t i = 0; i < vecVotes.size(); i++) {
+            vChecks.emplace_back(&vecVotes[i], &vecValid[i], &connman);
+        }
+        control.Add(vChecks);
+        control.Wait();
+    }
+    LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessPendingTxLockVotes -- checked %u votes in %.2fms\n",
+            vecVotes.size(), (GetTimeMicros() - nTimeStart) * 0.001);
+
+    LOCK2(cs_main, cs_instantsend);
+
+    for (size_t i = 0; i < vecVotes.size(); i++) {
+        if (!vecValid[i]) {
+            // could be because of missing MN
+            LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessPendingTxLockVotes -- Vote is invalid, txid=%s\n", vecVotes[i].GetTxHash().ToString());
+            continue;
+        }
+        ProcessTxLockVote(nullptr, vecVotes[i], connman, true);
+    }
+}
+
+size_t CInstantSend::GetPendingTxLockVoteCount()
+{
+    boost::unique_lock<boost::mutex> lock(mutexTxLockVotesPending);
+    return vecTxLockVotesPending.size();
+}
+
 bool CInstantSend::ProcessTxLockRequest(const CTxLockRequestRef& txLockRequest, CConnman& connman)
 {
     LOCK2(cs_main, cs_instantsend);
@@ -148,7 +274,7 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequestRef& txLockRequest,
     std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
     CTxLockCandidate& txLockCandidate = itLockCandidate->second;
     Vote(txLockCandidate, connman);
-    ProcessOrphanTxLockVotes(connman);
+    ProcessOrphanTxLockVotes(txHash, connman);
 
     // Masternodes will sometimes propagate votes before the transaction is known to the client.
     // If this just happened - lock inputs, resolve conflicting locks, update transaction status
@@ -279,7 +405,7 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
         // vote constructed sucessfully, let's store and relay it
         uint256 nVoteHash = vote.GetHash();
-        mapTxLockVotes.insert(std::make_pair(nVoteHash, vote));
+        AddTxLockVote(vote);
         if(itOutpointLock->second.AddVote(vote)) {
             LogPrintf("CInstantSend::Vote -- Vote created successfully, relaying: txHash=%s, outpoint=%s, vote=%s\n",
                     txHash.ToString(), itOutpointLock->first.ToString(), nVoteHash.ToString());
@@ -305,7 +431,7 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 }
 
 //received a consensus vote
-bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman& connman)
+bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman& connman, bool fValidated)
 {
     // cs_main, cs_wallet and cs_instantsend should be already locked
     AssertLockHeld(cs_main);
@@ -317,7 +443,7 @@ bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman&
 
     uint256 txHash = vote.GetTxHash();
 
-    if(!vote.IsValid(pfrom, connman)) {
+    if(!fValidated && !vote.IsValid(pfrom, connman)) {
         // could be because of missing MN
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- Vote is invalid, txid=%s\n", txHash.ToString());
         return false;
@@ -334,7 +460,7 @@ bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman&
         if(!mapTxLockVotesOrphan.count(vote.GetHash())) {
             // start timeout countdown after the very first vote
             CreateEmptyTxLockCandidate(txHash);
-            mapTxLockVotesOrphan[vote.GetHash()] = vote;
+            AddOrphanTxLockVote(vote);
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- Orphan vote: txid=%s  masternode=%s new\n",
                     txHash.ToString(), vote.GetMasternodeOutpoint().ToString());
             bool fReprocess = true;
@@ -362,19 +488,18 @@ bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman&
         // TODO: make sure this works good enough for multi-quorum
 
         int nMasternodeOrphanExpireTime = GetTime() + 60*10; // keep time data for 10 minutes
-        if(!mapMasternodeOrphanVotes.count(vote.GetMasternodeOutpoint())) {
-            mapMasternodeOrphanVotes[vote.GetMasternodeOutpoint()] = nMasternodeOrphanExpireTime;
-        } else {
-            int64_t nPrevOrphanVote = mapMasternodeOrphanVotes[vote.GetMasternodeOutpoint()];
+        std::map<COutPoint, int64_t>::iterator itMnOrphan = mapMasternodeOrphanVotes.find(vote.GetMasternodeOutpoint());
+        if(itMnOrphan != mapMasternodeOrphanVotes.end()) {
+            int64_t nPrevOrphanVote = itMnOrphan->second;
             if(nPrevOrphanVote > GetTime() && nPrevOrphanVote > GetAverageMasternodeOrphanVoteTime()) {
                 LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- masternode is spamming orphan Transaction Lock Votes: txid=%s  masternode=%s\n",
                         txHash.ToString(), vote.GetMasternodeOutpoint().ToString());
                 // Misbehaving(pfrom->id, 1);
                 return false;
             }
-            // not spamming, refresh
-            mapMasternodeOrphanVotes[vote.GetMasternodeOutpoint()] = nMasternodeOrphanExpireTime;
         }
+        // new or not spamming, refresh
+        SetMasternodeOrphanVoteTime(vote.GetMasternodeOutpoint(), nMasternodeOrphanExpireTime);
 
         return true;
     }
@@ -435,7 +560,7 @@ bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman&
     return true;
 }
 
-void CInstantSend::ProcessOrphanTxLockVotes(CConnman& connman)
+void CInstantSend::ProcessOrphanTxLockVotes(const uint256& txHash, CConnman& connman)
 {
     LOCK(cs_main);
 #ifdef ENABLE_WALLET
@@ -444,16 +569,103 @@ void CInstantSend::ProcessOrphanTxLockVotes(CConnman& connman)
 #endif
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.begin();
-    while(it != mapTxLockVotesOrphan.end()) {
-        if(ProcessTxLockVote(NULL, it->second, connman)) {
-            mapTxLockVotesOrphan.erase(it++);
-        } else {
-            ++it;
+    // only votes for this tx can stop being orphans now
+    for(const uint256& nVoteHash : GetOrphanTxLockVoteHashes(txHash)) {
+        std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.find(nVoteHash);
+        if(it == mapTxLockVotesOrphan.end()) continue;
+        CTxLockVote vote = it->second;
+        if(ProcessTxLockVote(NULL, vote, connman)) {
+            RemoveOrphanTxLockVote(nVoteHash);
         }
     }
 }
 
+void CInstantSend::AddTxLockVote(const CTxLockVote& vote)
+{
+    // cs_instantsend should be already locked
+    AssertLockHeld(cs_instantsend);
+
+    uint256 nVoteHash = vote.GetHash();
+    if(!mapTxLockVotes.insert(std::make_pair(nVoteHash, vote)).second) return;
+    setTxLockVotesFailTimes.emplace(vote.GetTimeCreated() + INSTANTSEND_FAILED_TIMEOUT_SECONDS, nVoteHash);
+}
+
+void CInstantSend::SetTxLockVoteConfirmedHeight(const uint256& nVoteHash, int nConfirmedHeight)
+{
+    // cs_instantsend should be already locked
+    AssertLockHeld(cs_instantsend);
+
+    std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.find(nVoteHash);
+    if(itVote == mapTxLockVotes.end()) return;
+    itVote->second.SetConfirmedHeight(nConfirmedHeight);
+    // an entry for an older height is skipped when it comes due
+    if(nConfirmedHeight != -1) {
+        setTxLockVotesExpiryHeights.emplace(nConfirmedHeight + Params().GetConsensus().nInstantSendKeepLock, nVoteHash);
+    }
+}
+
+void CInstantSend::AddOrphanTxLockVote(const CTxLockVote& vote)
+{
+    AssertLockHeld(cs_instantsend);
+
+    uint256 nVoteHash = vote.GetHash();
+    if(!mapTxLockVotesOrphan.emplace(nVoteHash, vote).second) return;
+    mapTxLockVotesOrphanByOutpoint[std::make_pair(vote.GetTxHash(), vote.GetOutpoint())].insert(nVoteHash);
+    setTxLockVotesOrphanTimeouts.emplace(vote.GetTimeCreated() + INSTANTSEND_LOCK_TIMEOUT_SECONDS, nVoteHash);
+}
+
+void CInstantSend::RemoveOrphanTxLockVote(const uint256& nVoteHash)
+{
+    AssertLockHeld(cs_instantsend);
+
+    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.find(nVoteHash);
+    if(it == mapTxLockVotesOrphan.end()) return;
+    const CTxLockVote& vote = it->second;
+
+    auto itIndex = mapTxLockVotesOrphanByOutpoint.find(std::make_pair(vote.GetTxHash(), vote.GetOutpoint()));
+    if(itIndex != mapTxLockVotesOrphanByOutpoint.end()) {
+        itIndex->second.erase(nVoteHash);
+        if(itIndex->second.empty())
+            mapTxLockVotesOrphanByOutpoint.erase(itIndex);
+    }
+    setTxLockVotesOrphanTimeouts.erase(std::make_pair(vote.GetTimeCreated() + INSTANTSEND_LOCK_TIMEOUT_SECONDS, nVoteHash));
+    mapTxLockVotesOrphan.erase(it);
+}
+
+std::vector<uint256> CInstantSend::GetOrphanTxLockVoteHashes(const uint256& txHash)
+{
+    AssertLockHeld(cs_instantsend);
+
+    // (txHash, null outpoint) sorts before every outpoint spent by txHash
+    std::vector<uint256> vecVoteHashes;
+    auto it = mapTxLockVotesOrphanByOutpoint.lower_bound(std::make_pair(txHash, COutPoint(uint256(), 0)));
+    for(; it != mapTxLockVotesOrphanByOutpoint.end() && it->first.first == txHash; ++it) {
+        vecVoteHashes.insert(vecVoteHashes.end(), it->second.begin(), it->second.end());
+    }
+    return vecVoteHashes;
+}
+
+void CInstantSend::SetMasternodeOrphanVoteTime(const COutPoint& outpoint, int64_t nTime)
+{
+    AssertLockHeld(cs_instantsend);
+
+    RemoveMasternodeOrphanVoteTime(outpoint);
+    mapMasternodeOrphanVotes.emplace(outpoint, nTime);
+    setMasternodeOrphanVoteTimes.emplace(nTime, outpoint);
+    nMasternodeOrphanVoteTimeSum += nTime;
+}
+
+void CInstantSend::RemoveMasternodeOrphanVoteTime(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs_instantsend);
+
+    std::map<COutPoint, int64_t>::iterator it = mapMasternodeOrphanVotes.find(outpoint);
+    if(it == mapMasternodeOrphanVotes.end()) return;
+    setMasternodeOrphanVoteTimes.erase(std::make_pair(it->second, outpoint));
+    nMasternodeOrphanVoteTimeSum -= it->second;
+    mapMasternodeOrphanVotes.erase(it);
+}
+
 bool CInstantSend::IsEnoughOrphanVotesForTx(const CTxLockRequestRef &txLockRequest)
 {
     // There could be a situation when we already have quite a lot of votes
@@ -471,18 +683,8 @@ bool CInstantSend::IsEnoughOrphanVotesForTxAndOutPoint(const uint256& txHash, co
 {
     // Scan orphan votes to check if this outpoint has enough orphan votes to be locked in some tx.
     LOCK2(cs_main, cs_instantsend);
-    int nCountVotes = 0;
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.begin();
-    while(it != mapTxLockVotesOrphan.end()) {
-        if(it->second.GetTxHash() == txHash && it->second.GetOutpoint() == outpoint) {
-            nCountVotes++;
-            if(nCountVotes >= COutPointLock::SIGNATURES_REQUIRED) {
-                return true;
-            }
-        }
-        ++it;
-    }
-    return false;
+    auto it = mapTxLockVotesOrphanByOutpoint.find(std::make_pair(txHash, outpoint));
+    return it != mapTxLockVotesOrphanByOutpoint.end() && (int)it->second.size() >= COutPointLock::SIGNATURES_REQUIRED;
 }
 
 void CInstantSend::TryToFinalizeLockCandidate(const CTxLockCandidate& txLockCandidate)
@@ -503,6 +705,11 @@ void CInstantSend::TryToFinalizeLockCandidate(const CTxLockCandidate& txLockCand
         if(ResolveConflicts(txLockCandidate)) {
             LockTransactionInputs(txLockCandidate);
             UpdateLockedTransaction(txLockCandidate);
+            if(IsLockedInstantSendTransaction(txHash)) {
+                dequeLockLatencies.push_back(GetTimeMicros() - txLockCandidate.GetTimeCreatedMicros());
+                if(dequeLockLatencies.size() > INSTANTSEND_LATENCY_SAMPLES)
+                    dequeLockLatencies.pop_front();
+            }
         }
     }
 }
@@ -651,15 +858,7 @@ int64_t CInstantSend::GetAverageMasternodeOrphanVoteTime()
     // NOTE: should never actually call this function when mapMasternodeOrphanVotes is empty
     if(mapMasternodeOrphanVotes.empty()) return 0;
 
-    std::map<COutPoint, int64_t>::iterator it = mapMasternodeOrphanVotes.begin();
-    int64_t total = 0;
-
-    while(it != mapMasternodeOrphanVotes.end()) {
-        total+= it->second;
-        ++it;
-    }
-
-    return total / mapMasternodeOrphanVotes.size();
+    return nMasternodeOrphanVoteTimeSum / (int64_t)mapMasternodeOrphanVotes.size();
 }
 
 void CInstantSend::CheckAndRemove()
@@ -690,53 +889,56 @@ void CInstantSend::CheckAndRemove()
         }
     }
 
-    // remove expired votes
-    std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsExpired(nCachedBlockHeight)) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
-                    itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToString());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
-        }
-    }
-
-    // remove timed out orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.IsTimedOut()) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
-                    itOrphanVote->second.GetTxHash().ToString(), itOrphanVote->second.GetMasternodeOutpoint().ToString());
-            mapTxLockVotes.erase(itOrphanVote->first);
-            mapTxLockVotesOrphan.erase(itOrphanVote++);
-        } else {
-            ++itOrphanVote;
+    // remove timed out orphan votes, oldest first
+    int64_t nNow = GetTime();
+    while(!setTxLockVotesOrphanTimeouts.empty() && setTxLockVotesOrphanTimeouts.begin()->first < nNow) {
+        uint256 nVoteHash = setTxLockVotesOrphanTimeouts.begin()->second;
+        std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.find(nVoteHash);
+        if(itOrphanVote == mapTxLockVotesOrphan.end()) {
+            // should never happen, the index is kept in sync with the map
+            setTxLockVotesOrphanTimeouts.erase(setTxLockVotesOrphanTimeouts.begin());
+            continue;
         }
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
+                itOrphanVote->second.GetTxHash().ToString(), itOrphanVote->second.GetMasternodeOutpoint().ToString());
+        mapTxLockVotes.erase(nVoteHash);
+        RemoveOrphanTxLockVote(nVoteHash);
     }
 
-    // remove invalid votes and votes for failed lock attempts
-    itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
+    // remove votes for failed lock attempts, oldest first
+    while(!setTxLockVotesFailTimes.empty() && setTxLockVotesFailTimes.begin()->first < nNow) {
+        uint256 nVoteHash = setTxLockVotesFailTimes.begin()->second;
+        setTxLockVotesFailTimes.erase(setTxLockVotesFailTimes.begin());
+        std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.find(nVoteHash);
+        if(itVote == mapTxLockVotes.end()) continue; // removed already
         if(itVote->second.IsFailed()) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing vote for failed lock attempt: txid=%s  masternode=%s\n",
                     itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToString());
-            mapTxLockVotes.erase(itVote++);
+            mapTxLockVotes.erase(itVote);
         } else {
-            ++itVote;
+            // the tx is locked, look again once the lock could be gone
+            setTxLockVotesFailTimes.emplace(std::max(nNow, itVote->second.GetTimeCreated()) + INSTANTSEND_FAILED_TIMEOUT_SECONDS, nVoteHash);
         }
     }
 
-    // remove timed out masternode orphan votes (DOS protection)
-    std::map<COutPoint, int64_t>::iterator itMasternodeOrphan = mapMasternodeOrphanVotes.begin();
-    while(itMasternodeOrphan != mapMasternodeOrphanVotes.end()) {
-        if(itMasternodeOrphan->second < GetTime()) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan masternode vote: masternode=%s\n",
-                    itMasternodeOrphan->first.ToString());
-            mapMasternodeOrphanVotes.erase(itMasternodeOrphan++);
-        } else {
-            ++itMasternodeOrphan;
-        }
+    // remove expired votes, lowest height first
+    while(!setTxLockVotesExpiryHeights.empty() && setTxLockVotesExpiryHeights.begin()->first < nCachedBlockHeight) {
+        uint256 nVoteHash = setTxLockVotesExpiryHeights.begin()->second;
+        setTxLockVotesExpiryHeights.erase(setTxLockVotesExpiryHeights.begin());
+        std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.find(nVoteHash);
+        // the vote could be gone or confirmed at another height since
+        if(itVote == mapTxLockVotes.end() || !itVote->second.IsExpired(nCachedBlockHeight)) continue;
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
+                itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToString());
+        mapTxLockVotes.erase(itVote);
+    }
+
+    // remove timed out masternode orphan votes (DOS protection), oldest first
+    while(!setMasternodeOrphanVoteTimes.empty() && setMasternodeOrphanVoteTimes.begin()->first < nNow) {
+        COutPoint outpointMasternode = setMasternodeOrphanVoteTimes.begin()->second;
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan masternode vote: masternode=%s\n",
+                outpointMasternode.ToString());
+        RemoveMasternodeOrphanVoteTime(outpointMasternode);
     }
     LogPrintf("CInstantSend::CheckAndRemove -- %s\n", ToString());
 }
@@ -906,15 +1108,11 @@ void CInstantSend::SyncTransaction(const CTransactionRef &tx, const CBlockIndex
             // Check corresponding lock votes
             std::vector<CTxLockVote> vVotes = itOutpointLock->second.GetVotes();
             std::vector<CTxLockVote>::iterator itVote = vVotes.begin();
-            std::map<uint256, CTxLockVote>::iterator it;
             while(itVote != vVotes.end()) {
                 uint256 nVoteHash = itVote->GetHash();
                 LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
                         txHash.ToString(), nHeightNew, nVoteHash.ToString());
-                it = mapTxLockVotes.find(nVoteHash);
-                if(it != mapTxLockVotes.end()) {
-                    it->second.SetConfirmedHeight(nHeightNew);
-                }
+                SetTxLockVoteConfirmedHeight(nVoteHash, nHeightNew);
                 ++itVote;
             }
             ++itOutpointLock;
@@ -922,17 +1120,19 @@ void CInstantSend::SyncTransaction(const CTransactionRef &tx, const CBlockIndex
     }
 
     // check orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.GetTxHash() == txHash) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
-                    txHash.ToString(), nHeightNew, itOrphanVote->first.ToString());
-            mapTxLockVotes[itOrphanVote->first].SetConfirmedHeight(nHeightNew);
-        }
-        ++itOrphanVote;
+    for(const uint256& nVoteHash : GetOrphanTxLockVoteHashes(txHash)) {
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
+                txHash.ToString(), nHeightNew, nVoteHash.ToString());
+        SetTxLockVoteConfirmedHeight(nVoteHash, nHeightNew);
     }
 }
 
+std::vector<int64_t> CInstantSend::GetLockLatencies()
+{
+    LOCK(cs_instantsend);
+    return std::vector<int64_t>(dequeLockLatencies.begin(), dequeLockLatencies.end());
+}
+
 std::string CInstantSend::ToString()
 {
     LOCK(cs_instantsend);
@@ -1059,10 +1259,19 @@ uint256 CTxLockVote::GetHash() const
     return ss.GetHash();
 }
 
+uint256 CTxLockVote::GetSignatureHash() const
+{
+    return GetHash();
+}
+
+std::string CTxLockVote::GetStrMessage() const
+{
+    return txHash.ToString() + outpoint.ToStringShort();
+}
+
 bool CTxLockVote::CheckSignature() const
 {
     std::string strError;
-    std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
 
     masternode_info_t infoMn;
 
@@ -1071,9 +1280,25 @@ bool CTxLockVote::CheckSignature() const
         return false;
     }
 
-    if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode.GetID(), vchMasternodeSignature, strMessage, strError)) {
-        LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
-        return false;
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
+
+        if(!CHashSigner::VerifyHash(hash, infoMn.pubKeyMasternode, vchMasternodeSignature, strError)) {
+            // could be a vote signed before the spork, try the old format
+            std::string strMessage = GetStrMessage();
+
+            if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
+                LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
+                return false;
+            }
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
+            LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
+            return false;
+        }
     }
 
     return true;
@@ -1082,16 +1307,31 @@ bool CTxLockVote::CheckSignature() const
 bool CTxLockVote::Sign()
 {
     std::string strError;
-    std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
 
-    if(!CMessageSigner::SignMessage(strMessage, vchMasternodeSignature, activeMasternode.keyMasternode, CPubKey::InputScriptType::SPENDP2PKH)) {
-        LogPrintf("CTxLockVote::Sign -- SignMessage() failed\n");
-        return false;
-    }
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
 
-    if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode.GetID(), vchMasternodeSignature, strMessage, strError)) {
-        LogPrintf("CTxLockVote::Sign -- VerifyMessage() failed, error: %s\n", strError);
-        return false;
+        if(!CHashSigner::SignHash(hash, activeMasternode.keyMasternode, CPubKey::InputScriptType::SPENDP2PKH, vchMasternodeSignature)) {
+            LogPrintf("CTxLockVote::Sign -- SignHash() failed\n");
+            return false;
+        }
+
+        if(!CHashSigner::VerifyHash(hash, activeMasternode.pubKeyMasternode, vchMasternodeSignature, strError)) {
+            LogPrintf("CTxLockVote::Sign -- VerifyHash() failed, error: %s\n", strError);
+            return false;
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::SignMessage(strMessage, vchMasternodeSignature, activeMasternode.keyMasternode, CPubKey::InputScriptType::SPENDP2PKH)) {
+            LogPrintf("CTxLockVote::Sign -- SignMessage() failed\n");
+            return false;
+        }
+
+        if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
+            LogPrintf("CTxLockVote::Sign -- VerifyMessage() failed, error: %s\n", strError);
+            return false;
+        }
     }
 
     return true;
@@ -8,6 +8,11 @@
 #include <net.h>
 #include <primitives/transaction.h>
 
+#include <deque>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
 class CTxLockVote;
 class COutPointLock;
 class CTxLockRequest;
@@ -37,9 +42,20 @@ static const int INSTANTSEND_LOCK_TIMEOUT_SECONDS   = 15;
 // must be greater than INSTANTSEND_LOCK_TIMEOUT_SECONDS
 static const int INSTANTSEND_FAILED_TIMEOUT_SECONDS = 60;
 
+//! -instantsendvotethreads default (number of threads checking lock votes)
+static const int DEFAULT_INSTANTSEND_VOTE_THREADS   = 2;
+//! Maximum number of threads checking lock votes
+static const int MAX_INSTANTSEND_VOTE_THREADS       = 16;
+//! Votes waiting for the vote check threads, new ones are dropped beyond this.
+//! Far more than the votes of the transactions locked in a block's time.
+static const size_t MAX_INSTANTSEND_PENDING_VOTES   = 10000;
+//! How many lock completion times to keep for latency percentiles
+static const size_t INSTANTSEND_LATENCY_SAMPLES     = 1000;
+
 extern bool fEnableInstantSend;
 extern int nInstantSendDepth;
 extern int nCompleteTXLocks;
+extern int nInstantSendVoteThreads;
 
 typedef std::shared_ptr<CTxLockRequest> CTxLockRequestRef;
 static inline CTxLockRequestRef MakeLockRequestRef() { return std::make_shared<CTxLockRequest>(); }
@@ -56,6 +72,12 @@ private:
     std::map<uint256, CTxLockRequestRef> mapLockRequestRejected; // tx hash - tx
     std::map<uint256, CTxLockVote> mapTxLockVotes; // vote hash - vote
     std::map<uint256, CTxLockVote> mapTxLockVotesOrphan; // vote hash - vote
+    // orphan votes by tx and voted outpoint, so a lock request only touches its own votes
+    std::map<std::pair<uint256, COutPoint>, std::set<uint256> > mapTxLockVotesOrphanByOutpoint; // (tx hash, utxo) - vote hashes
+    std::set<std::pair<int64_t, uint256> > setTxLockVotesOrphanTimeouts; // (time out, vote hash), oldest first
+    // when to look at mapTxLockVotes entries again, so CheckAndRemove does not scan all votes
+    std::set<std::pair<int64_t, uint256> > setTxLockVotesFailTimes; // (time the vote fails unless locked, vote hash), oldest first
+    std::set<std::pair<int, uint256> > setTxLockVotesExpiryHeights; // (last height the vote is kept, vote hash), lowest first
 
     std::map<uint256, CTxLockCandidate> mapTxLockCandidates; // tx hash - lock candidate
 
@@ -64,18 +86,39 @@ private:
 
     //track masternodes who voted with no txreq (for DOS protection)
     std::map<COutPoint, int64_t> mapMasternodeOrphanVotes; // mn outpoint - time
+    std::set<std::pair<int64_t, COutPoint> > setMasternodeOrphanVoteTimes; // (time, mn outpoint), oldest first
+    int64_t nMasternodeOrphanVoteTimeSum = 0; // sum of mapMasternodeOrphanVotes times
+
+    // votes received from the network, waiting to be checked without cs_main
+    boost::mutex mutexTxLockVotesPending;
+    boost::condition_variable condTxLockVotesPending;
+    std::vector<CTxLockVote> vecTxLockVotesPending;
+
+    // microseconds from the first request or vote for a tx until its lock completed
+    std::deque<int64_t> dequeLockLatencies;
 
     bool CreateTxLockCandidate(const CTxLockRequestRef& txLockRequest);
     void CreateEmptyTxLockCandidate(const uint256& txHash);
     void Vote(CTxLockCandidate& txLockCandidate, CConnman& connman);
 
-    //process consensus vote message
-    bool ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman& connman);
-    void ProcessOrphanTxLockVotes(CConnman& connman);
+    //process consensus vote message, fValidated skips vote.IsValid() for votes checked already
+    bool ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman& connman, bool fValidated = false);
+    void ProcessOrphanTxLockVotes(const uint256& txHash, CConnman& connman);
     bool IsEnoughOrphanVotesForTx(const CTxLockRequestRef& txLockRequest);
     bool IsEnoughOrphanVotesForTxAndOutPoint(const uint256& txHash, const COutPoint& outpoint);
     int64_t GetAverageMasternodeOrphanVoteTime();
 
+    // keep mapTxLockVotes and its fail time and expiry height queues in sync
+    void AddTxLockVote(const CTxLockVote& vote);
+    void SetTxLockVoteConfirmedHeight(const uint256& nVoteHash, int nConfirmedHeight);
+    // keep mapTxLockVotesOrphan and its indexes in sync
+    void AddOrphanTxLockVote(const CTxLockVote& vote);
+    void RemoveOrphanTxLockVote(const uint256& nVoteHash);
+    std::vector<uint256> GetOrphanTxLockVoteHashes(const uint256& txHash);
+    // keep mapMasternodeOrphanVotes, its time index and the sum of times in sync
+    void SetMasternodeOrphanVoteTime(const COutPoint& outpoint, int64_t nTime);
+    void RemoveMasternodeOrphanVoteTime(const COutPoint& outpoint);
+
     void TryToFinalizeLockCandidate(const CTxLockCandidate& txLockCandidate);
     void LockTransactionInputs(const CTxLockCandidate& txLockCandidate);
     //update UI and notify external script if any
@@ -91,6 +134,11 @@ public:
 
     bool ProcessTxLockRequest(const CTxLockRequestRef &txLockRequest, CConnman& connman);
 
+    // wait for votes from the network, check their signatures and masternodes
+    // on the vote check threads and apply the valid ones
+    void ProcessPendingTxLockVotes(CConnman& connman);
+    size_t GetPendingTxLockVoteCount();
+
     bool AlreadyHave(const uint256& hash);
 
     void AcceptLockRequest(const CTxLockRequestRef &txLockRequest);
@@ -119,9 +167,19 @@ public:
     void UpdatedBlockTip(const CBlockIndex *pindex);
     void SyncTransaction(const CTransactionRef& tx, const CBlockIndex* pindex);
 
+    // lock completion times of the most recent locks, in microseconds
+    std::vector<int64_t> GetLockLatencies();
+
     std::string ToString();
+
+    friend struct CInstantSendTest;
 };
 
+/** Run an instance of the lock vote check thread */
+void ThreadTxLockVoteCheck();
+/** Run the thread feeding network lock votes through the vote checks */
+void ThreadProcessTxLockVotes(CConnman* pConnman);
+
 class CTxLockRequest : public CTransaction
 {
 private:
@@ -184,6 +242,10 @@ public:
     }
 
     uint256 GetHash() const;
+    /// Hash signed once SPORK_6_NEW_SIGS is active; covers the voting masternode too
+    uint256 GetSignatureHash() const;
+    /// Text message signed before SPORK_6_NEW_SIGS
+    std::string GetStrMessage() const;
 
     uint256 GetTxHash() const { return txHash; }
     COutPoint GetOutpoint() const { return outpoint; }
@@ -194,6 +256,7 @@ public:
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
     bool IsFailed() const;
+    int64_t GetTimeCreated() const { return nTimeCreated; }
 
     bool Sign();
     bool CheckSignature() const;
@@ -234,11 +297,13 @@ class CTxLockCandidate
 private:
     int nConfirmedHeight; // when corresponding tx is 0-confirmed or conflicted, nConfirmedHeight is -1
     int64_t nTimeCreated;
+    int64_t nTimeCreatedMicros;
 
 public:
     CTxLockCandidate(const CTxLockRequestRef& txLockRequestIn) :
         nConfirmedHeight(-1),
         nTimeCreated(GetTime()),
+        nTimeCreatedMicros(GetTimeMicros()),
         txLockRequest(txLockRequestIn),
         mapOutPointLocks()
         {}
@@ -259,6 +324,7 @@ public:
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
+    int64_t GetTimeCreatedMicros() const { return nTimeCreatedMicros; }
 
     void Relay(CConnman& connman) const;
 };
@@ -6,6 +6,7 @@
 #include <boost/assign/list_of.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <crypto/common.h>
 #include <db.h>
 #include <kernel.h>
 #include <script/interpreter.h>
@@ -384,54 +385,93 @@ bool stakeTargetHit(uint256 hashProofOfStake, int64_t nValueIn, arith_uint256 bn
 //
 bool CheckStakeKernelHash(unsigned int nBits, const CBlock& blockFrom, unsigned int nTxPrevOffset, const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake, bool fPrintProofOfStake)
 {
-    nTxPrevOffset = 336;
-    auto txPrevTime = blockFrom.GetBlockTime();
+    return CheckStakeKernelHash(nBits, blockFrom.GetHash(), blockFrom.GetBlockTime(), txPrev->vout[prevout.n].nValue,
+                                prevout, nTimeTx, hashProofOfStake, fPrintProofOfStake);
+}
+
+bool CheckStakeKernelHash(unsigned int nBits, const uint256& hashBlockFrom, unsigned int nTimeBlockFrom, CAmount nValueIn, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake, bool fPrintProofOfStake)
+{
+    CStakeKernelContext kernel;
+    if (!kernel.Init(hashBlockFrom, nTimeBlockFrom, nValueIn, prevout, fPrintProofOfStake))
+        return false;
+    return kernel.CheckHash(nBits, nTimeTx, hashProofOfStake, fPrintProofOfStake);
+}
+
+CStakeKernelContext::CStakeKernelContext()
+    : nStakeModifier(0),
+      nStakeModifierHeight(0),
+      nStakeModifierTime(0),
+      nHeightBlockFrom(0),
+      nTimeBlockFrom(0),
+      nValueIn(0),
+      nPrevoutIndex(0)
+{}
+
+bool CStakeKernelContext::Init(const uint256& hashBlockFrom, unsigned int nTimeBlockFromIn, CAmount nValueInIn, const COutPoint& prevout, bool fPrintProofOfStake)
+{
+    BlockMap::const_iterator mi = mapBlockIndex.find(hashBlockFrom);
+    if (mi == mapBlockIndex.end())
+        return error("CStakeKernelContext::Init() : block not indexed");
+
+    nHeightBlockFrom = mi->second->nHeight;
+    nTimeBlockFrom = nTimeBlockFromIn;
+    nValueIn = nValueInIn;
+    nPrevoutIndex = prevout.n;
+
+    // the v0.3 modifier does not depend on the kernel timestamp
+    if (!GetKernelStakeModifier(hashBlockFrom, nTimeBlockFrom, nStakeModifier, nStakeModifierHeight, nStakeModifierTime, fPrintProofOfStake))
+        return error("Failed to get kernel stake modifier");
+
+    unsigned int nTxPrevOffset = 336;
+    // txPrev time has always been hashed as the 64-bit block time
+    int64_t txPrevTime = nTimeBlockFrom;
+    CDataStream ss(SER_GETHASH, 0);
+    ss << nStakeModifier;
+    ss << nTimeBlockFrom << nTxPrevOffset << txPrevTime << nPrevoutIndex;
+    hasherPrefix.Reset().Write((const unsigned char*)ss.data(), ss.size());
+    return true;
+}
+
+bool CStakeKernelContext::CheckHash(unsigned int nBits, unsigned int nTimeTx, uint256& hashProofOfStake, bool fPrintProofOfStake) const
+{
+    unsigned int nTxPrevOffset = 336;
+    int64_t txPrevTime = nTimeBlockFrom;
     if (nTimeTx < txPrevTime)  // Transaction timestamp violation
         return error("CheckStakeKernelHash() : nTime violation");
 
     auto nStakeMinAge = Params().GetConsensus().nStakeMinAge;
     auto nStakeMaxAge = Params().GetConsensus().nStakeMaxAge;
-    unsigned int nTimeBlockFrom = blockFrom.GetBlockTime();
     if (nTimeBlockFrom + nStakeMinAge > nTimeTx) // Min age requirement
         return error("CheckStakeKernelHash() : min age violation");
 
     arith_uint256 bnTargetPerCoinDay;
     bnTargetPerCoinDay.SetCompact(nBits);
-    CAmount nValueIn = txPrev->vout[prevout.n].nValue;
     // v0.3 protocol kernel hash weight starts from 0 at the 30-day min age
     // this change increases active coins participating the hash and helps
     // to secure the network when proof-of-stake difficulty is low
     int64_t nTimeWeight = std::min<int64_t>(nTimeTx - txPrevTime, nStakeMaxAge - nStakeMinAge);
     arith_uint256 bnCoinDayWeight = nValueIn * nTimeWeight / COIN / 200;
 
-    // Calculate hash
-    CDataStream ss(SER_GETHASH, 0);
-    uint64_t nStakeModifier = 0;
-    int nStakeModifierHeight = 0;
-    int64_t nStakeModifierTime = 0;
-
-    if (!GetKernelStakeModifier(blockFrom.GetHash(), nTimeTx, nStakeModifier, nStakeModifierHeight, nStakeModifierTime, fPrintProofOfStake))
-        return error("Failed to get kernel stake modifier");
-
-    ss << nStakeModifier;
-
-    ss << nTimeBlockFrom << nTxPrevOffset << txPrevTime << prevout.n << nTimeTx;
-    hashProofOfStake = Hash(ss.begin(), ss.end());
+    // Calculate hash: only nTimeTx is left to absorb
+    unsigned char vchTimeTx[4];
+    WriteLE32(vchTimeTx, nTimeTx);
+    CHash256 hasher(hasherPrefix);
+    hasher.Write(vchTimeTx, sizeof(vchTimeTx)).Finalize(hashProofOfStake.begin());
     if (fPrintProofOfStake)
     {
         LogPrint(BCLog::KERNEL, "%s : using modifier 0x%016" PRI64x" at height=%d timestamp=%s for block from height=%d timestamp=%s\n",
                  __func__,
                  nStakeModifier, nStakeModifierHeight,
                  DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nStakeModifierTime).c_str(),
-                 mapBlockIndex[blockFrom.GetHash()]->nHeight,
-                DateTimeStrFormat("%Y-%m-%d %H:%M:%S", blockFrom.GetBlockTime()).c_str());
+                 nHeightBlockFrom,
+                DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTimeBlockFrom).c_str());
 
         LogPrint(BCLog::KERNEL, "%s : check protocol=%s modifier=0x%016" PRI64x" nTimeBlockFrom=%u nTxPrevOffset=%u nTimeTxPrev=%u nPrevout=%u nTimeTx=%u hashProof=%s\n",
                  __func__,
                  "0.5",
                  nStakeModifier,
                  nTimeBlockFrom, nTxPrevOffset,
-                 txPrevTime, prevout.n, nTimeTx,
+                 txPrevTime, nPrevoutIndex, nTimeTx,
                  hashProofOfStake.ToString().c_str());
     }
 
@@ -445,18 +485,42 @@ bool CheckStakeKernelHash(unsigned int nBits, const CBlock& blockFrom, unsigned
                  __func__,
                  nStakeModifier, nStakeModifierHeight,
                  DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nStakeModifierTime).c_str(),
-                 mapBlockIndex[blockFrom.GetHash()]->nHeight,
-                DateTimeStrFormat("%Y-%m-%d %H:%M:%S", blockFrom.GetBlockTime()).c_str());
+                 nHeightBlockFrom,
+                DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTimeBlockFrom).c_str());
         LogPrint(BCLog::KERNEL, "%s : Generated pass protocol=%s modifier=0x%016" PRI64x" nTimeBlockFrom=%u nTxPrevOffset=%u nTimeTxPrev=%u nPrevout=%u nTimeTx=%u hashProof=%s\n",
                  __func__,
                  "0.5",
                  nStakeModifier,
-                 nTimeBlockFrom, nTxPrevOffset, txPrevTime, prevout.n, nTimeTx,
+                 nTimeBlockFrom, nTxPrevOffset, txPrevTime, nPrevoutIndex, nTimeTx,
                  hashProofOfStake.ToString().c_str());
     }
     return true;
 }
 
+bool CStakeKernelContext::Search(unsigned int nBits, unsigned int& nTimeTx, unsigned int nHashDrift, int64_t nTimeMin, uint64_t& nAttempts, const std::atomic<bool>* pfStop) const
+{
+    uint256 hashProofOfStake;
+    for (unsigned int i = 0; i < nHashDrift; ++i)
+    {
+        if (pfStop && *pfStop)
+            return false;
+
+        unsigned int nTryTime = nTimeTx - i;
+        ++nAttempts;
+        if (CheckHash(nBits, nTryTime, hashProofOfStake))
+        {
+            //Double check that this will pass time requirements
+            if (nTryTime <= nTimeMin) {
+                LogPrintf("CStakeKernelContext::Search() : kernel found, but it is too far in the past \n");
+                continue;
+            }
+            nTimeTx = nTryTime;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool CheckKernelScript(CScript scriptVin, CScript scriptVout)
 {
     auto extractKeyID = [](CScript scriptPubKey) {
@@ -483,6 +547,37 @@ bool CheckKernelScript(CScript scriptVin, CScript scriptVout)
     return extractKeyID(scriptVin) == extractKeyID(scriptVout);
 }
 
+bool GetStakeKernelInput(const COutPoint& prevout, CTxOut& txoutPrev, const CBlockIndex*& pindexFrom)
+{
+    LOCK(cs_main);
+
+    // The coin's height locates its block on the active chain, which carries
+    // everything the kernel needs without touching the txindex or block files.
+    const Coin& coin = pcoinsTip->AccessCoin(prevout);
+    if (!coin.IsSpent() && coin.nHeight <= chainActive.Height()) {
+        txoutPrev = coin.out;
+        pindexFrom = chainActive[coin.nHeight];
+        return true;
+    }
+
+    // Not in the UTXO set (a block off the active chain, or one being
+    // re-checked after its kernel was spent); fall back to the txindex.
+    uint256 hashBlock;
+    CTransactionRef txPrev;
+    if (!GetTransaction(prevout.hash, txPrev, Params().GetConsensus(), hashBlock, true))
+        return error("GetStakeKernelInput() : INFO: read txPrev failed");
+    if (prevout.n >= txPrev->vout.size())
+        return error("GetStakeKernelInput() : prevout out of range");
+
+    BlockMap::iterator it = mapBlockIndex.find(hashBlock);
+    if (it == mapBlockIndex.end())
+        return error("GetStakeKernelInput() : read block failed");
+
+    txoutPrev = txPrev->vout[prevout.n];
+    pindexFrom = it->second;
+    return true;
+}
+
 // Check kernel hash target and coinstake signature
 bool CheckProofOfStake(const CBlock &block, uint256& hashProofOfStake)
 {
@@ -493,16 +588,11 @@ bool CheckProofOfStake(const CBlock &block, uint256& hashProofOfStake)
     // Kernel (input 0) must match the stake hash target per coin age (nBits)
     const CTxIn& txin = tx->vin[0];
 
-    // First try finding the previous transaction in database
-    uint256 hashBlock;
-    CTransactionRef txPrev;
+    CTxOut prevTxOut;
+    const CBlockIndex* pindexFrom = nullptr;
+    if (!GetStakeKernelInput(txin.prevout, prevTxOut, pindexFrom))
+        return error("CheckProofOfStake() : INFO: kernel input %s not found", txin.prevout.ToString());
 
-    const auto &cons = Params().GetConsensus();
-
-    if (!GetTransaction(txin.prevout.hash, txPrev, cons, hashBlock, true))
-        return error("CheckProofOfStake() : INFO: read txPrev failed");
-
-    CTxOut prevTxOut = txPrev->vout[txin.prevout.n];
     //verify signature and script, don't check script if it's tpos block, signature check will happen in different place
     if (!block.IsTPoSBlock() &&
             !VerifyScript(txin.scriptSig, prevTxOut.scriptPubKey,
@@ -512,23 +602,11 @@ bool CheckProofOfStake(const CBlock &block, uint256& hashProofOfStake)
         return error("CheckProofOfStake() : VerifySignature failed on coinstake %s", tx->GetHash().ToString().c_str());
     }
 
-    CBlockIndex* pindex = NULL;
-    BlockMap::iterator it = mapBlockIndex.find(hashBlock);
-    if (it != mapBlockIndex.end())
-        pindex = it->second;
-    else
-        return error("CheckProofOfStake() : read block failed");
-
-    // Read block header
-    CBlock blockprev;
-    if (!ReadBlockFromDisk(blockprev, pindex->GetBlockPos(), cons))
-        return error("CheckProofOfStake(): INFO: failed to find block");
-
     if(!CheckKernelScript(prevTxOut.scriptPubKey, tx->vout[1].scriptPubKey))
         return error("CheckProofOfStake() : INFO: check kernel script failed on coinstake %s, hashProof=%s \n", tx->GetHash().ToString().c_str(), hashProofOfStake.ToString().c_str());
 
     unsigned int nTime = block.nTime;
-    if (!CheckStakeKernelHash(block.nBits, blockprev, /*postx->nTxOffset + */sizeof(CBlock), txPrev, txin.prevout, nTime, hashProofOfStake, true))
+    if (!CheckStakeKernelHash(block.nBits, pindexFrom->GetBlockHash(), pindexFrom->GetBlockTime(), prevTxOut.nValue, txin.prevout, nTime, hashProofOfStake, true))
         return error("CheckProofOfStake() : INFO: check kernel failed on coinstake %s, hashProof=%s \n", tx->GetHash().ToString().c_str(), hashProofOfStake.ToString().c_str()); // may occur during initial download or if behind on block chain sync
 
     return true;
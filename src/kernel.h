@@ -5,10 +5,14 @@
 #define BITCOIN_KERNEL_H
 
 #include <uint256.h>
+#include <hash.h>
 #include <streams.h>
 #include <arith_uint256.h>
+#include <amount.h>
 #include <primitives/transaction.h>
 
+#include <atomic>
+
 class CBlock;
 class CWallet;
 class COutPoint;
@@ -32,6 +36,47 @@ bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeMod
 bool CheckStakeKernelHash(unsigned int nBits, const CBlock& blockFrom, unsigned int nTxPrevOffset,
                           const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTimeTx,
                           uint256& hashProofOfStake, bool fPrintProofOfStake = false);
+bool CheckStakeKernelHash(unsigned int nBits, const uint256& hashBlockFrom, unsigned int nTimeBlockFrom, CAmount nValueIn,
+                          const COutPoint& prevout, unsigned int nTimeTx,
+                          uint256& hashProofOfStake, bool fPrintProofOfStake = false);
+
+// The parts of a stake kernel hash that do not depend on the kernel's
+// timestamp: the stake modifier, the block-from time, the staked value and a
+// hasher that has already absorbed everything up to nTimeTx. Stays valid while
+// the active chain is unchanged, as the modifier is selected on chainActive.
+class CStakeKernelContext
+{
+public:
+    CStakeKernelContext();
+
+    bool Init(const uint256& hashBlockFrom, unsigned int nTimeBlockFrom, CAmount nValueIn,
+              const COutPoint& prevout, bool fPrintProofOfStake = false);
+    // Same result as CheckStakeKernelHash for this coin at nTimeTx
+    bool CheckHash(unsigned int nBits, unsigned int nTimeTx, uint256& hashProofOfStake,
+                   bool fPrintProofOfStake = false) const;
+
+    // Try the nHashDrift timestamps ending at nTimeTx, newest first, for a
+    // kernel later than nTimeMin; sets nTimeTx on success. Gives up early once
+    // *pfStop is set, e.g. by another thread that found a kernel.
+    bool Search(unsigned int nBits, unsigned int& nTimeTx, unsigned int nHashDrift, int64_t nTimeMin,
+                uint64_t& nAttempts, const std::atomic<bool>* pfStop = nullptr) const;
+
+    unsigned int GetBlockFromTime() const { return nTimeBlockFrom; }
+
+private:
+    uint64_t nStakeModifier;
+    int nStakeModifierHeight;
+    int64_t nStakeModifierTime;
+    int nHeightBlockFrom;
+    unsigned int nTimeBlockFrom;
+    CAmount nValueIn;
+    unsigned int nPrevoutIndex;
+    CHash256 hasherPrefix;
+};
+
+// Find the output spent by a stake kernel and the block that created it,
+// from the UTXO set where possible and the txindex otherwise
+bool GetStakeKernelInput(const COutPoint& prevout, CTxOut& txoutPrev, const CBlockIndex*& pindexFrom);
 
 // Check kernel hash target and coinstake signature
 // Sets hashProofOfStake on success return
@@ -222,9 +222,56 @@ std::string GetRequiredPaymentsString(int nBlockHeight)
 
 void CMasternodePayments::Clear()
 {
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
-    mapMasternodeBlocks.clear();
-    mapMasternodePaymentVotes.clear();
+    LOCK(cs_mapMasternodeBlocks);
+    window.Clear();
+    journalBlocks.MarkAllDirty();
+}
+
+void CMasternodePayments::SetJournalBaseline()
+{
+    LOCK(cs_mapMasternodeBlocks);
+    journalBlocks.SetBaseline(window);
+}
+
+int CMasternodePayments::WriteJournal(CCacheJournalDB& db, bool fSync)
+{
+    CDBBatch batch(db);
+    int nRecords;
+    {
+        LOCK(cs_mapMasternodeBlocks);
+        // heights the window moved past were dropped without being marked
+        journalBlocks.MarkDirtyBefore(window.GetFirstHeight());
+        nRecords = journalBlocks.WriteChanges(batch, window);
+    }
+    bool fWritten = db.WriteBatch(batch, fSync);
+    LOCK(cs_mapMasternodeBlocks);
+    if(!fWritten) {
+        journalBlocks.Abort();
+        return -1;
+    }
+    journalBlocks.Commit();
+    return nRecords;
+}
+
+bool CMasternodePayments::ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    std::vector<std::pair<int, std::unique_ptr<CMasternodePaymentBlock> > > vBlocks;
+    if(!journalBlocks.ReadEntries(db, hashSnapshot, vBlocks)) return false;
+
+    for(const auto& block : vBlocks) {
+        if(block.second) {
+            window.SetBlock(block.first, *block.second);
+        } else {
+            window.EraseBlock(block.first);
+        }
+    }
+    return true;
+}
+
+void CMasternodePayments::ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    journalBlocks.Reset(batch, db, hashSnapshot);
 }
 
 bool CMasternodePayments::CanVote(COutPoint outMasternode, int nBlockHeight)
@@ -325,24 +372,28 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
         // Ignore any payments messages until masternode list is synced
         if(!masternodeSync.IsMasternodeListSynced()) return;
 
+        // Only votes in range are remembered, the window has no room for the others
+        int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
+        if(vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > nCachedBlockHeight + MNPAYMENTS_FUTURE_BLOCKS) {
+            LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, nCachedBlockHeight);
+            return;
+        }
+
         {
-            LOCK(cs_mapMasternodePaymentVotes);
-            if(mapMasternodePaymentVotes.count(nHash)) {
+            LOCK(cs_mapMasternodeBlocks);
+            if(window.HasVote(nHash)) {
                 LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- hash=%s, nHeight=%d seen\n", nHash.ToString(), nCachedBlockHeight);
                 return;
             }
 
             // Avoid processing same vote multiple times
-            mapMasternodePaymentVotes[nHash] = vote;
             // but first mark vote as non-verified,
             // AddPaymentVote() below should take care of it if vote is actually ok
-            mapMasternodePaymentVotes[nHash].MarkAsNotVerified();
-        }
-
-        int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
-        if(vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > nCachedBlockHeight+20) {
-            LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, nCachedBlockHeight);
-            return;
+            CMasternodePaymentVote voteSeen(vote);
+            voteSeen.MarkAsNotVerified();
+            if(window.AddVote(voteSeen)) {
+                journalBlocks.MarkDirty(vote.nBlockHeight);
+            }
         }
 
         std::string strError = "";
@@ -395,21 +446,50 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
     }
 }
 
-bool CMasternodePaymentVote::Sign()
+uint256 CMasternodePaymentVote::GetSignatureHash() const
 {
-    std::string strError;
-    std::string strMessage = vinMasternode.prevout.ToStringShort() +
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << vinMasternode.prevout;
+    ss << nBlockHeight;
+    ss << *(CScriptBase*)(&payee);
+    return ss.GetHash();
+}
+
+std::string CMasternodePaymentVote::GetStrMessage() const
+{
+    return vinMasternode.prevout.ToStringShort() +
             boost::lexical_cast<std::string>(nBlockHeight) +
             ScriptToAsmStr(payee);
+}
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, activeMasternode.keyMasternode, CPubKey::InputScriptType::SPENDP2PKH)) {
-        LogPrintf("CMasternodePaymentVote::Sign -- SignMessage() failed\n");
-        return false;
-    }
+bool CMasternodePaymentVote::Sign()
+{
+    std::string strError;
 
-    if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode.GetID(), vchSig, strMessage, strError)) {
-        LogPrintf("CMasternodePaymentVote::Sign -- VerifyMessage() failed, error: %s\n", strError);
-        return false;
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
+
+        if(!CHashSigner::SignHash(hash, activeMasternode.keyMasternode, CPubKey::InputScriptType::SPENDP2PKH, vchSig)) {
+            LogPrintf("CMasternodePaymentVote::Sign -- SignHash() failed\n");
+            return false;
+        }
+
+        if(!CHashSigner::VerifyHash(hash, activeMasternode.pubKeyMasternode, vchSig, strError)) {
+            LogPrintf("CMasternodePaymentVote::Sign -- VerifyHash() failed, error: %s\n", strError);
+            return false;
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::SignMessage(strMessage, vchSig, activeMasternode.keyMasternode, CPubKey::InputScriptType::SPENDP2PKH)) {
+            LogPrintf("CMasternodePaymentVote::Sign -- SignMessage() failed\n");
+            return false;
+        }
+
+        if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode, vchSig, strMessage, strError)) {
+            LogPrintf("CMasternodePaymentVote::Sign -- VerifyMessage() failed, error: %s\n", strError);
+            return false;
+        }
     }
 
     return true;
@@ -417,8 +497,11 @@ bool CMasternodePaymentVote::Sign()
 
 bool CMasternodePayments::GetBlockPayee(int nBlockHeight, CScript& payee)
 {
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].GetBestPayee(payee);
+    LOCK(cs_mapMasternodeBlocks);
+
+    const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(nBlockHeight);
+    if(pblockPayees) {
+        return pblockPayees->GetBestPayee(payee);
     }
 
     return false;
@@ -438,7 +521,8 @@ bool CMasternodePayments::IsScheduled(const CMasternode& mn, int nNotBlockHeight
     CScript payee;
     for(int64_t h = nCachedBlockHeight; h <= nCachedBlockHeight + 8; h++){
         if(h == nNotBlockHeight) continue;
-        if(mapMasternodeBlocks.count(h) && mapMasternodeBlocks.at(h).GetBestPayee(payee) && mnpayee == payee) {
+        const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(h);
+        if(pblockPayees && pblockPayees->GetBestPayee(payee) && mnpayee == payee) {
             return true;
         }
     }
@@ -451,27 +535,57 @@ bool CMasternodePayments::AddPaymentVote(const CMasternodePaymentVote& vote)
     uint256 blockHash = uint256();
     if(!GetBlockHash(blockHash, vote.nBlockHeight - 101)) return false;
 
+    LOCK(cs_mapMasternodeBlocks);
+
     if(HasVerifiedPaymentVote(vote.GetHash())) return false;
 
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+    if(!window.AddVote(vote)) return false;
+    journalBlocks.MarkDirty(vote.nBlockHeight);
+    return true;
+}
+
+bool CMasternodePayments::HasPaymentVote(const uint256& hashIn)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return window.HasVote(hashIn);
+}
 
-    mapMasternodePaymentVotes[vote.GetHash()] = vote;
+bool CMasternodePayments::HasVerifiedPaymentVote(uint256 hashIn)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    const CMasternodePaymentVote* pvote = window.GetVote(hashIn);
+    return pvote && pvote->IsVerified();
+}
 
-    if(!mapMasternodeBlocks.count(vote.nBlockHeight)) {
-        CMasternodeBlockPayees blockPayees(vote.nBlockHeight);
-        mapMasternodeBlocks[vote.nBlockHeight] = blockPayees;
-    }
+bool CMasternodePayments::GetVerifiedPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    const CMasternodePaymentVote* pvote = window.GetVote(hashIn);
+    if(!pvote || !pvote->IsVerified()) return false;
+    voteRet = *pvote;
+    return true;
+}
 
-    mapMasternodeBlocks[vote.nBlockHeight].AddPayee(vote);
+bool CMasternodePayments::HasPaymentBlock(int nBlockHeight)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return window.GetBlockPayees(nBlockHeight) != nullptr;
+}
 
+bool CMasternodePayments::GetBlockPayees(int nBlockHeight, CMasternodeBlockPayees& payeesRet)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(nBlockHeight);
+    if(!pblockPayees) return false;
+    payeesRet = *pblockPayees;
     return true;
 }
 
-bool CMasternodePayments::HasVerifiedPaymentVote(uint256 hashIn)
+bool CMasternodePayments::HasPayeeWithVotes(int nBlockHeight, const CScript& payee, int nVotesReq)
 {
-    LOCK(cs_mapMasternodePaymentVotes);
-    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.find(hashIn);
-    return it != mapMasternodePaymentVotes.end() && it->second.IsVerified();
+    LOCK(cs_mapMasternodeBlocks);
+    const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(nBlockHeight);
+    return pblockPayees && pblockPayees->HasPayeeWithVotes(payee, nVotesReq);
 }
 
 void CMasternodeBlockPayees::AddPayee(const CMasternodePaymentVote& vote)
@@ -587,12 +701,156 @@ std::string CMasternodeBlockPayees::GetRequiredPaymentsString() const
     return strRequiredPayments;
 }
 
+CMasternodePaymentWindow::CMasternodePaymentWindow(int nSize) :
+    vecSlots(nSize),
+    mapVoteIndex(),
+    nLastHeight(-1),
+    nBlockCount(0)
+{}
+
+void CMasternodePaymentWindow::Clear()
+{
+    for(CMasternodePaymentBlock& block : vecSlots) {
+        block = CMasternodePaymentBlock();
+    }
+    mapVoteIndex.clear();
+    nLastHeight = -1;
+    nBlockCount = 0;
+}
+
+void CMasternodePaymentWindow::Reserve(int nSize)
+{
+    if(nSize <= GetSize()) return;
+
+    // grow by a quarter at least, the limit follows the masternode count
+    std::vector<CMasternodePaymentBlock> vecSlotsOld(std::max(nSize, GetSize() + GetSize() / 4));
+    vecSlots.swap(vecSlotsOld);
+    // every height of the window lands in a slot of its own again,
+    // the index is by height and stays as it is
+    for(CMasternodePaymentBlock& block : vecSlotsOld) {
+        if(block.IsEmpty()) continue;
+        GetSlot(block.payees.nBlockHeight) = std::move(block);
+    }
+}
+
+void CMasternodePaymentWindow::ClearSlot(CMasternodePaymentBlock& block)
+{
+    if(block.IsEmpty()) return;
+    for(const CMasternodePaymentVote& vote : block.vecVotes) {
+        mapVoteIndex.erase(vote.GetHash());
+    }
+    if(block.HasPayees()) --nBlockCount;
+    block = CMasternodePaymentBlock();
+}
+
+void CMasternodePaymentWindow::IndexSlot(int nHeight)
+{
+    const CMasternodePaymentBlock& block = GetSlot(nHeight);
+    for(size_t i = 0; i < block.vecVotes.size(); i++) {
+        mapVoteIndex[block.vecVotes[i].GetHash()] = std::make_pair(nHeight, i);
+    }
+}
+
+void CMasternodePaymentWindow::MoveEnd(int nHeight)
+{
+    if(nHeight - nLastHeight >= GetSize()) {
+        // nothing of the window is left
+        for(CMasternodePaymentBlock& block : vecSlots) {
+            ClearSlot(block);
+        }
+    } else {
+        // the slots of the heights leaving the window are the ones the new heights get
+        for(int h = nLastHeight + 1; h <= nHeight; h++) {
+            ClearSlot(GetSlot(h));
+        }
+    }
+    nLastHeight = nHeight;
+}
+
+bool CMasternodePaymentWindow::AddVote(const CMasternodePaymentVote& vote)
+{
+    int nHeight = vote.nBlockHeight;
+    if(nHeight < 0 || nHeight < GetFirstHeight()) return false;
+    if(nHeight > nLastHeight) MoveEnd(nHeight);
+
+    CMasternodePaymentBlock& block = GetSlot(nHeight);
+    if(block.IsEmpty()) {
+        block.payees = CMasternodeBlockPayees(nHeight);
+    }
+
+    uint256 nHash = vote.GetHash();
+    auto it = mapVoteIndex.find(nHash);
+    bool fCount = vote.IsVerified();
+    if(it != mapVoteIndex.end()) {
+        CMasternodePaymentVote& voteOld = block.vecVotes[it->second.second];
+        fCount = fCount && !voteOld.IsVerified();
+        voteOld = vote;
+    } else {
+        mapVoteIndex.emplace(nHash, std::make_pair(nHeight, block.vecVotes.size()));
+        block.vecVotes.push_back(vote);
+    }
+
+    if(fCount) {
+        if(!block.HasPayees()) ++nBlockCount;
+        block.payees.AddPayee(vote);
+    }
+    return true;
+}
+
+const CMasternodePaymentVote* CMasternodePaymentWindow::GetVote(const uint256& nHash) const
+{
+    auto it = mapVoteIndex.find(nHash);
+    if(it == mapVoteIndex.end()) return nullptr;
+    return &GetSlot(it->second.first).vecVotes[it->second.second];
+}
+
+const CMasternodePaymentBlock* CMasternodePaymentWindow::GetBlock(int nHeight) const
+{
+    if(nHeight < 0 || nHeight < GetFirstHeight() || nHeight > nLastHeight) return nullptr;
+    const CMasternodePaymentBlock& block = GetSlot(nHeight);
+    return block.IsEmpty() ? nullptr : &block;
+}
+
+const CMasternodeBlockPayees* CMasternodePaymentWindow::GetBlockPayees(int nHeight) const
+{
+    const CMasternodePaymentBlock* pblock = GetBlock(nHeight);
+    return pblock && pblock->HasPayees() ? &pblock->payees : nullptr;
+}
+
+void CMasternodePaymentWindow::SetBlock(int nHeight, const CMasternodePaymentBlock& block)
+{
+    if(nHeight < 0 || nHeight < GetFirstHeight()) return;
+    if(nHeight > nLastHeight) MoveEnd(nHeight);
+
+    CMasternodePaymentBlock& blockSlot = GetSlot(nHeight);
+    ClearSlot(blockSlot);
+    if(block.IsEmpty()) return;
+
+    blockSlot = block;
+    blockSlot.payees.nBlockHeight = nHeight;
+    if(blockSlot.HasPayees()) ++nBlockCount;
+    IndexSlot(nHeight);
+}
+
+void CMasternodePaymentWindow::EraseBlock(int nHeight)
+{
+    if(GetBlock(nHeight)) ClearSlot(GetSlot(nHeight));
+}
+
+void CMasternodePaymentWindow::Prune(int nFirstHeight)
+{
+    for(int h = std::max(0, GetFirstHeight()); h < nFirstHeight && h <= nLastHeight; h++) {
+        ClearSlot(GetSlot(h));
+    }
+}
+
 std::string CMasternodePayments::GetRequiredPaymentsString(int nBlockHeight)
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].GetRequiredPaymentsString();
+    const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(nBlockHeight);
+    if(pblockPayees) {
+        return pblockPayees->GetRequiredPaymentsString();
     }
 
     return "Unknown";
@@ -602,8 +860,9 @@ bool CMasternodePayments::IsTransactionValid(const CTransactionRef& txNew, int n
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].IsTransactionValid(txNew);
+    const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(nBlockHeight);
+    if(pblockPayees) {
+        return pblockPayees->IsTransactionValid(txNew);
     }
 
     return true;
@@ -613,22 +872,12 @@ void CMasternodePayments::CheckAndRemove()
 {
     if(!masternodeSync.IsBlockchainSynced()) return;
 
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
-
-    int nLimit = GetStorageLimit();
-
-    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.begin();
-    while(it != mapMasternodePaymentVotes.end()) {
-        CMasternodePaymentVote vote = (*it).second;
+    LOCK(cs_mapMasternodeBlocks);
 
-        if(nCachedBlockHeight - vote.nBlockHeight > nLimit) {
-            LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::CheckAndRemove -- Removing old Masternode payment: nBlockHeight=%d\n", vote.nBlockHeight);
-            mapMasternodePaymentVotes.erase(it++);
-            mapMasternodeBlocks.erase(vote.nBlockHeight);
-        } else {
-            ++it;
-        }
-    }
+    // the window only moves with new votes, drop what fell out of the limit since
+    window.Reserve(GetWindowSize());
+    window.Prune(nCachedBlockHeight - GetStorageLimit());
+    journalBlocks.MarkDirtyBefore(nCachedBlockHeight - GetStorageLimit());
     LogPrintf("CMasternodePayments::CheckAndRemove -- %s\n", ToString());
 }
 
@@ -768,27 +1017,21 @@ void CMasternodePayments::CheckPreviousBlockVotes(int nPrevBlockHeight)
         return;
     }
 
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+    LOCK(cs_mapMasternodeBlocks);
+
+    const CMasternodePaymentBlock* pblock = window.GetBlock(nPrevBlockHeight);
 
     for (int i = 0; i < MNPAYMENTS_SIGNATURES_TOTAL && i < (int)mns.size(); i++) {
         auto mn = mns[i];
         CScript payee;
         bool found = false;
 
-        if (mapMasternodeBlocks.count(nPrevBlockHeight)) {
-            for (auto &p : mapMasternodeBlocks[nPrevBlockHeight].vecPayees) {
-                for (auto &voteHash : p.GetVoteHashes()) {
-                    if (!mapMasternodePaymentVotes.count(voteHash)) {
-                        debugStr += strprintf("CMasternodePayments::CheckPreviousBlockVotes --   could not find vote %s\n",
-                                              voteHash.ToString());
-                        continue;
-                    }
-                    auto vote = mapMasternodePaymentVotes[voteHash];
-                    if (vote.vinMasternode.prevout == mn.second.outpoint) {
-                        payee = vote.payee;
-                        found = true;
-                        break;
-                    }
+        if (pblock) {
+            for (const auto& vote : pblock->vecVotes) {
+                if (vote.IsVerified() && vote.vinMasternode.prevout == mn.second.outpoint) {
+                    payee = vote.payee;
+                    found = true;
+                    break;
                 }
             }
         }
@@ -834,19 +1077,37 @@ bool CMasternodePaymentVote::CheckSignature(const CPubKey& pubKeyMasternode, int
     // do not ban by default
     nDos = 0;
 
-    std::string strMessage = vinMasternode.prevout.ToStringShort() +
-            boost::lexical_cast<std::string>(nBlockHeight) +
-            ScriptToAsmStr(payee);
-
     std::string strError = "";
-    if (!CMessageSigner::VerifyMessage(pubKeyMasternode.GetID(), vchSig, strMessage, strError)) {
-        // Only ban for future block vote when we are already synced.
-        // Otherwise it could be the case when MN which signed this vote is using another key now
-        // and we have no idea about the old one.
-        if(masternodeSync.IsMasternodeListSynced() && nBlockHeight > nValidationHeight) {
-            nDos = 20;
+
+    if (sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
+
+        if (!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
+            // could be a vote signed before the spork, try the old format
+            std::string strMessage = GetStrMessage();
+
+            if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+                // Only ban for future block vote when we are already synced.
+                // Otherwise it could be the case when MN which signed this vote is using another key now
+                // and we have no idea about the old one.
+                if(masternodeSync.IsMasternodeListSynced() && nBlockHeight > nValidationHeight) {
+                    nDos = 20;
+                }
+                return error("CMasternodePaymentVote::CheckSignature -- Got bad Masternode payment signature, masternode=%s, error: %s", vinMasternode.prevout.ToString().c_str(), strError);
+            }
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+            // Only ban for future block vote when we are already synced.
+            // Otherwise it could be the case when MN which signed this vote is using another key now
+            // and we have no idea about the old one.
+            if(masternodeSync.IsMasternodeListSynced() && nBlockHeight > nValidationHeight) {
+                nDos = 20;
+            }
+            return error("CMasternodePaymentVote::CheckSignature -- Got bad Masternode payment signature, masternode=%s, error: %s", vinMasternode.prevout.ToString().c_str(), strError);
         }
-        return error("CMasternodePaymentVote::CheckSignature -- Got bad Masternode payment signature, masternode=%s, error: %s", vinMasternode.prevout.ToString().c_str(), strError);
     }
 
     return true;
@@ -873,9 +1134,10 @@ void CMasternodePayments::Sync(CNode* pnode, CConnman& connman)
 
     int nInvCount = 0;
 
-    for(int h = nCachedBlockHeight; h < nCachedBlockHeight + 20; h++) {
-        if(mapMasternodeBlocks.count(h)) {
-            for(CMasternodePayee& payee : mapMasternodeBlocks[h].vecPayees) {
+    for(int h = nCachedBlockHeight; h < nCachedBlockHeight + MNPAYMENTS_FUTURE_BLOCKS; h++) {
+        const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(h);
+        if(pblockPayees) {
+            for(const CMasternodePayee& payee : pblockPayees->vecPayees) {
                 std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
                 for(const uint256& hash : vecVoteHashes) {
                     if(!HasVerifiedPaymentVote(hash)) continue;
@@ -903,7 +1165,7 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
     const CBlockIndex *pindex = chainActive.Tip();
 
     while(nCachedBlockHeight - pindex->nHeight < nLimit) {
-        if(!mapMasternodeBlocks.count(pindex->nHeight)) {
+        if(!window.GetBlockPayees(pindex->nHeight)) {
             // We have no idea about this block height, let's ask
             vToFetch.push_back(CInv(MSG_MASTERNODE_PAYMENT_BLOCK, pindex->GetBlockHash()));
             // We should not violate GETDATA rules
@@ -918,12 +1180,11 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
         pindex = pindex->pprev;
     }
 
-    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.begin();
-
-    while(it != mapMasternodeBlocks.end()) {
+    for(const auto& entry : window) {
+        if(!entry.second.HasPayees()) continue;
         int nTotalVotes = 0;
         bool fFound = false;
-        for(const CMasternodePayee& payee : it->second.vecPayees) {
+        for(const CMasternodePayee& payee : entry.second.payees.vecPayees) {
             if(payee.GetVoteCount() >= MNPAYMENTS_SIGNATURES_REQUIRED) {
                 fFound = true;
                 break;
@@ -934,21 +1195,20 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
         // or no clear winner was found but there are at least avg number of votes
         if(fFound || nTotalVotes >= (MNPAYMENTS_SIGNATURES_TOTAL + MNPAYMENTS_SIGNATURES_REQUIRED)/2) {
             // so just move to the next block
-            ++it;
             continue;
         }
         // DEBUG
         // Let's see why this failed
-        for(const CMasternodePayee& payee : it->second.vecPayees) {
+        for(const CMasternodePayee& payee : entry.second.payees.vecPayees) {
             CTxDestination address1;
             ExtractDestination(payee.GetPayee(), address1);
             LogPrint(BCLog::MNPAYMENTS, "payee %s votes %d\n", EncodeDestination(address1), payee.GetVoteCount());
         }
-        LogPrint(BCLog::MNPAYMENTS, "block %d votes total %d\n", it->first, nTotalVotes);
+        LogPrint(BCLog::MNPAYMENTS, "block %d votes total %d\n", entry.first, nTotalVotes);
         // END DEBUG
         // Low data block found, let's try to sync it
         uint256 hash;
-        if(GetBlockHash(hash, it->first)) {
+        if(GetBlockHash(hash, entry.first)) {
             vToFetch.push_back(CInv(MSG_MASTERNODE_PAYMENT_BLOCK, hash));
         }
         // We should not violate GETDATA rules
@@ -958,7 +1218,6 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
             // Start filling new batch
             vToFetch.clear();
         }
-        ++it;
     }
     // Ask for the rest of it
     if(!vToFetch.empty()) {
@@ -971,8 +1230,8 @@ std::string CMasternodePayments::ToString() const
 {
     std::ostringstream info;
 
-    info << "Votes: " << (int)mapMasternodePaymentVotes.size() <<
-            ", Blocks: " << (int)mapMasternodeBlocks.size();
+    info << "Votes: " << window.GetVoteCount() <<
+            ", Blocks: " << window.GetBlockCount();
 
     return info.str();
 }
@@ -984,11 +1243,28 @@ bool CMasternodePayments::IsEnoughData()
     return GetBlockCount() > nStorageLimit && GetVoteCount() > nStorageLimit * nAverageVotes;
 }
 
+int CMasternodePayments::GetBlockCount()
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return window.GetBlockCount();
+}
+
+int CMasternodePayments::GetVoteCount()
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return window.GetVoteCount();
+}
+
 int CMasternodePayments::GetStorageLimit()
 {
     return std::max(int(mnodeman.size() * nStorageCoeff), nMinBlocksToStore);
 }
 
+int CMasternodePayments::GetWindowSize()
+{
+    return GetStorageLimit() + MNPAYMENTS_FUTURE_BLOCKS + 1;
+}
+
 void CMasternodePayments::UpdatedBlockTip(const CBlockIndex *pindex, CConnman& connman)
 {
     if(!pindex) return;
@@ -996,6 +1272,12 @@ void CMasternodePayments::UpdatedBlockTip(const CBlockIndex *pindex, CConnman& c
     nCachedBlockHeight = pindex->nHeight;
     LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::UpdatedBlockTip -- nCachedBlockHeight=%d\n", nCachedBlockHeight);
 
+    {
+        // more masternodes keep more blocks
+        LOCK(cs_mapMasternodeBlocks);
+        window.Reserve(GetWindowSize());
+    }
+
     int nFutureBlock = nCachedBlockHeight + 10;
 
     CheckPreviousBlockVotes(nFutureBlock - 1);
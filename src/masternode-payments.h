@@ -6,12 +6,16 @@
 #define MASTERNODE_PAYMENTS_H
 
 #include <util.h>
+#include <cache-journal.h>
 #include <core_io.h>
 #include <key.h>
 #include <masternode.h>
 #include <net_processing.h>
+#include <txmempool.h>
 #include <utilstrencodings.h>
 
+#include <unordered_map>
+
 class CMasternodePayments;
 class CMasternodePaymentVote;
 class CMasternodeBlockPayees;
@@ -19,6 +23,8 @@ class TPoSContract;
 
 static const int MNPAYMENTS_SIGNATURES_REQUIRED         = 6;
 static const int MNPAYMENTS_SIGNATURES_TOTAL            = 10;
+//! votes are accepted for up to this many blocks past the tip
+static const int MNPAYMENTS_FUTURE_BLOCKS               = 20;
 
 //! minimum peer version that can receive and send masternode payment messages,
 //  vote for masternode and be elected as a payment winner
@@ -28,8 +34,10 @@ static const int MIN_MASTERNODE_PAYMENT_PROTO_VERSION_1 = 70206;
 static const int MIN_MASTERNODE_PAYMENT_PROTO_VERSION_2 = 70208;
 
 extern CCriticalSection cs_vecPayees;
+// guards the payment vote window
 extern CCriticalSection cs_mapMasternodeBlocks;
-extern CCriticalSection cs_mapMasternodePayeeVotes;
+// guards the last votes of the masternodes
+extern CCriticalSection cs_mapMasternodePaymentVotes;
 
 extern CMasternodePayments mnpayments;
 
@@ -149,18 +157,168 @@ public:
         return ss.GetHash();
     }
 
+    /// Hash of the serialized fields, signed once SPORK_6_NEW_SIGS is active
+    uint256 GetSignatureHash() const;
+    /// Text message signed before SPORK_6_NEW_SIGS
+    std::string GetStrMessage() const;
+
     bool Sign();
     bool CheckSignature(const CPubKey& pubKeyMasternode, int nValidationHeight, int &nDos);
 
     bool IsValid(CNode* pnode, int nValidationHeight, std::string& strError, CConnman& connman);
     void Relay(CConnman& connman);
 
-    bool IsVerified() { return !vchSig.empty(); }
+    bool IsVerified() const { return !vchSig.empty(); }
     void MarkAsNotVerified() { vchSig.clear(); }
 
     std::string ToString() const;
 };
 
+// Payment votes of one block height and the payees they vote for
+class CMasternodePaymentBlock
+{
+public:
+    CMasternodeBlockPayees payees;
+    // every vote seen for the height, only the verified ones count for payees
+    std::vector<CMasternodePaymentVote> vecVotes;
+
+    CMasternodePaymentBlock() :
+        payees(),
+        vecVotes()
+        {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(payees);
+        READWRITE(vecVotes);
+    }
+
+    bool IsEmpty() const { return vecVotes.empty(); }
+    bool HasPayees() const { return !payees.vecPayees.empty(); }
+};
+
+/**
+ * Payment votes of a sliding window of block heights
+ *
+ * Height h is kept in slot h % size of a ring, the votes next to the payees
+ * they vote for, with an index from vote hash to slot. The window ends at the
+ * highest height voted for, a vote past the end moves the window and recycles
+ * the slots left behind, so votes expire a block at a time.
+ *
+ * Serialized the way mnpayments.dat stored the votes and payees before: the
+ * votes by hash, then the payees by height.
+ */
+class CMasternodePaymentWindow
+{
+private:
+    // height and position in the slot of a vote
+    typedef std::pair<int, size_t> vote_pos_t;
+
+    std::vector<CMasternodePaymentBlock> vecSlots;
+    std::unordered_map<uint256, vote_pos_t, SaltedTxidHasher> mapVoteIndex;
+    int nLastHeight;
+    int nBlockCount;
+
+    CMasternodePaymentBlock& GetSlot(int nHeight) { return vecSlots[nHeight % vecSlots.size()]; }
+    const CMasternodePaymentBlock& GetSlot(int nHeight) const { return vecSlots[nHeight % vecSlots.size()]; }
+
+    void ClearSlot(CMasternodePaymentBlock& block);
+    void IndexSlot(int nHeight);
+    /// Move the end of the window to nHeight
+    void MoveEnd(int nHeight);
+
+public:
+    /// Iterates the heights with votes in ascending order as (height, block) pairs
+    class const_iterator
+    {
+    private:
+        const CMasternodePaymentWindow* pwindow;
+        int nHeight;
+
+        void SkipEmpty() { while(nHeight <= pwindow->nLastHeight && pwindow->GetSlot(nHeight).IsEmpty()) ++nHeight; }
+
+    public:
+        const_iterator(const CMasternodePaymentWindow* pwindowIn, int nHeightIn) : pwindow(pwindowIn), nHeight(nHeightIn) { SkipEmpty(); }
+
+        std::pair<int, const CMasternodePaymentBlock&> operator*() const { return {nHeight, pwindow->GetSlot(nHeight)}; }
+        const_iterator& operator++() { ++nHeight; SkipEmpty(); return *this; }
+        bool operator==(const const_iterator& other) const { return nHeight == other.nHeight; }
+        bool operator!=(const const_iterator& other) const { return nHeight != other.nHeight; }
+    };
+
+    explicit CMasternodePaymentWindow(int nSize);
+
+    const_iterator begin() const { return const_iterator(this, std::max(0, GetFirstHeight())); }
+    const_iterator end() const { return const_iterator(this, nLastHeight + 1); }
+
+    void Clear();
+    /// Grow the window to at least nSize heights
+    void Reserve(int nSize);
+
+    int GetSize() const { return vecSlots.size(); }
+    int GetFirstHeight() const { return nLastHeight - GetSize() + 1; }
+    int GetBlockCount() const { return nBlockCount; }
+    int GetVoteCount() const { return mapVoteIndex.size(); }
+
+    /// Add a vote or replace the one with the same hash, a verified vote is
+    /// counted for its payee. Returns false if the height is before the window.
+    bool AddVote(const CMasternodePaymentVote& vote);
+    bool HasVote(const uint256& nHash) const { return mapVoteIndex.count(nHash); }
+    const CMasternodePaymentVote* GetVote(const uint256& nHash) const;
+
+    /// Votes and payees of a height, nullptr if there is no vote for it
+    const CMasternodePaymentBlock* GetBlock(int nHeight) const;
+    /// Payees of a height, nullptr if there is no verified vote for it
+    const CMasternodeBlockPayees* GetBlockPayees(int nHeight) const;
+    void SetBlock(int nHeight, const CMasternodePaymentBlock& block);
+    void EraseBlock(int nHeight);
+
+    /// Drop the heights before nFirstHeight
+    void Prune(int nFirstHeight);
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        WriteCompactSize(s, mapVoteIndex.size());
+        for(const auto& entry : mapVoteIndex) {
+            s << entry.first << GetSlot(entry.second.first).vecVotes[entry.second.second];
+        }
+        WriteCompactSize(s, nBlockCount);
+        for(const auto& entry : *this) {
+            if(!entry.second.HasPayees()) continue;
+            s << entry.first << entry.second.payees;
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        Clear();
+        // the payees follow from the verified votes, the others were only seen
+        uint64_t nVotes = ReadCompactSize(s);
+        for(uint64_t i = 0; i < nVotes; i++) {
+            uint256 nHash;
+            CMasternodePaymentVote vote;
+            s >> nHash >> vote;
+            if(vote.IsVerified()) AddVote(vote);
+        }
+        uint64_t nBlocks = ReadCompactSize(s);
+        for(uint64_t i = 0; i < nBlocks; i++) {
+            int nHeight;
+            CMasternodeBlockPayees payees;
+            s >> nHeight >> payees;
+        }
+    }
+};
+
+/** The block of a height of the window, for CCacheJournalTable */
+inline const CMasternodePaymentBlock* FindJournalEntry(const CMasternodePaymentWindow& window, int nHeight)
+{
+    return window.GetBlock(nHeight);
+}
+
 //
 // Masternode Payments Class
 // Keeps track of who should get paid for which blocks
@@ -177,26 +335,45 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    // votes of the stored blocks and the blocks to come
+    CMasternodePaymentWindow window;
+
+    CCacheJournalTable<int, CMasternodePaymentBlock> journalBlocks;
+
 public:
-    std::map<uint256, CMasternodePaymentVote> mapMasternodePaymentVotes;
-    std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
     std::map<COutPoint, int> mapMasternodesLastVote;
     std::map<COutPoint, int> mapMasternodesDidNotVote;
 
-    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000) {}
+    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000), nCachedBlockHeight(0),
+                            window(nMinBlocksToStore + MNPAYMENTS_FUTURE_BLOCKS + 1),
+                            journalBlocks("mnpaymentblocks") {}
 
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(mapMasternodePaymentVotes);
-        READWRITE(mapMasternodeBlocks);
+        LOCK(cs_mapMasternodeBlocks);
+        if(ser_action.ForRead()) {
+            window.Reserve(GetWindowSize());
+        }
+        READWRITE(window);
     }
 
     void Clear();
 
+    /// Journal of the payment votes and blocks between snapshots, see CJournaledFlatDB
+    void SetJournalBaseline();
+    int WriteJournal(CCacheJournalDB& db, bool fSync);
+    bool ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot);
+    void ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot);
+
     bool AddPaymentVote(const CMasternodePaymentVote& vote);
+    bool HasPaymentVote(const uint256& hashIn);
     bool HasVerifiedPaymentVote(uint256 hashIn);
+    bool GetVerifiedPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet);
+    bool HasPaymentBlock(int nBlockHeight);
+    bool GetBlockPayees(int nBlockHeight, CMasternodeBlockPayees& payeesRet);
+    bool HasPayeeWithVotes(int nBlockHeight, const CScript& payee, int nVotesReq);
     bool ProcessBlock(int nBlockHeight, CConnman& connman);
     void CheckPreviousBlockVotes(int nPrevBlockHeight);
 
@@ -216,11 +393,13 @@ public:
     void FillBlockPayee(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutMasternodeRet);
     std::string ToString() const;
 
-    int GetBlockCount() { return mapMasternodeBlocks.size(); }
-    int GetVoteCount() { return mapMasternodePaymentVotes.size(); }
+    int GetBlockCount();
+    int GetVoteCount();
 
     bool IsEnoughData();
     int GetStorageLimit();
+    /// Heights the vote window spans, the stored blocks and the blocks to come
+    int GetWindowSize();
 
     void UpdatedBlockTip(const CBlockIndex *pindex, CConnman& connman);
 };
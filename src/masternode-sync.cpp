@@ -11,6 +11,7 @@
 #include <masternode-sync.h>
 #include <masternodeman.h>
 #include <netfulfilledman.h>
+#include <net_processing_galactrum.h>
 #include <spork.h>
 #include <ui_interface.h>
 #include <util.h>
@@ -32,6 +33,10 @@ void CMasternodeSync::Reset()
     nTimeAssetSyncStarted = GetTime();
     nTimeLastBumped = GetTime();
     nTimeLastFailure = 0;
+    nTimeListSyncStarted = 0;
+    nListSyncMillis = 0;
+    nListBytesAtStart = 0;
+    nListSyncBytes = 0;
 }
 
 void CMasternodeSync::BumpAssetLastTime(std::string strFuncName)
@@ -56,6 +61,11 @@ std::string CMasternodeSync::GetAssetName()
     }
 }
 
+static uint64_t GetListMessageBytes()
+{
+    return net_processing_galactrum::GetExtensionMessageBytes({NetMsgType::MNANNOUNCE, NetMsgType::MNPING, NetMsgType::SYNCSTATUSCOUNT});
+}
+
 void CMasternodeSync::SwitchToNextAsset(CConnman& connman)
 {
     switch(nRequestedMasternodeAssets)
@@ -73,9 +83,14 @@ void CMasternodeSync::SwitchToNextAsset(CConnman& connman)
             LogPrintf("CMasternodeSync::SwitchToNextAsset -- Completed %s in %llds\n", GetAssetName(), GetTime() - nTimeAssetSyncStarted);
             nRequestedMasternodeAssets = MASTERNODE_SYNC_LIST;
             LogPrintf("CMasternodeSync::SwitchToNextAsset -- Starting %s\n", GetAssetName());
+            nTimeListSyncStarted = GetTimeMillis();
+            nListBytesAtStart = GetListMessageBytes();
             break;
         case(MASTERNODE_SYNC_LIST):
             LogPrintf("CMasternodeSync::SwitchToNextAsset -- Completed %s in %llds\n", GetAssetName(), GetTime() - nTimeAssetSyncStarted);
+            nListSyncMillis = GetTimeMillis() - nTimeListSyncStarted;
+            nListSyncBytes = GetListMessageBytes() - nListBytesAtStart;
+            LogPrintf("CMasternodeSync::SwitchToNextAsset -- List sync received %d bytes\n", nListSyncBytes);
             nRequestedMasternodeAssets = MASTERNODE_SYNC_MNW;
             LogPrintf("CMasternodeSync::SwitchToNextAsset -- Starting %s\n", GetAssetName());
             break;
@@ -107,6 +122,18 @@ void CMasternodeSync::SwitchToNextAsset(CConnman& connman)
     BumpAssetLastTime("CMasternodeSync::SwitchToNextAsset");
 }
 
+int64_t CMasternodeSync::GetListSyncTime()
+{
+    if(nRequestedMasternodeAssets == MASTERNODE_SYNC_LIST) return GetTimeMillis() - nTimeListSyncStarted;
+    return nListSyncMillis;
+}
+
+uint64_t CMasternodeSync::GetListSyncBytes()
+{
+    if(nRequestedMasternodeAssets == MASTERNODE_SYNC_LIST) return GetListMessageBytes() - nListBytesAtStart;
+    return nListSyncBytes;
+}
+
 std::string CMasternodeSync::GetSyncStatus()
 {
     switch (masternodeSync.nRequestedMasternodeAssets) {
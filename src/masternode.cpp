@@ -12,6 +12,7 @@
 #include <masternodeman.h>
 #include <messagesigner.h>
 #include <script/standard.h>
+#include <spork.h>
 #include <util.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
@@ -68,11 +69,17 @@ bool CMasternode::UpdateFromNewBroadcast(CMasternodeBroadcast& mnb, CConnman& co
 {
     if(mnb.sigTime <= sigTime && !mnb.fRecovery) return false;
 
+    if(nProtocolVersion != mnb.nProtocolVersion) {
+        // protocol filters decide who is ranked
+        mnodeman.InvalidateRankCache();
+    }
+    mnodeman.RemoveFromIndexes(*this);
     pubKeyMasternode = mnb.pubKeyMasternode;
     sigTime = mnb.sigTime;
     vchSig = mnb.vchSig;
     nProtocolVersion = mnb.nProtocolVersion;
     addr = mnb.addr;
+    mnodeman.AddToIndexes(*this);
     nPoSeBanScore = 0;
     nPoSeBanHeight = 0;
     nTimeLastChecked = 0;
@@ -249,6 +256,24 @@ void CMasternode::Check(bool fForce)
     }
 }
 
+int64_t CMasternode::GetNextCheckTime() const
+{
+    LOCK(cs);
+    int64_t nNow = GetAdjustedTime();
+    int64_t nNextTime = 0;
+    auto fnDeadline = [&](int64_t nTime) {
+        if(nTime > nNow && (nNextTime == 0 || nTime < nNextTime)) nNextTime = nTime;
+    };
+    // the ping ages Check() compares with, see IsPingedWithin
+    if(lastPing != CMasternodePing()) {
+        fnDeadline(lastPing.sigTime + MASTERNODE_MIN_MNP_SECONDS);
+        fnDeadline(lastPing.sigTime + MASTERNODE_EXPIRATION_SECONDS);
+        fnDeadline(lastPing.sigTime + MASTERNODE_NEW_START_REQUIRED_SECONDS);
+    }
+    fnDeadline(nTimeLastWatchdogVote + MASTERNODE_WATCHDOG_MAX_SECONDS + 1);
+    return nNextTime;
+}
+
 bool CMasternode::IsEnabled() const
 {
     return nActiveState == MASTERNODE_ENABLED || IsWatchdogExpired();
@@ -330,45 +355,13 @@ std::string CMasternode::GetStatus() const
     return GetStateString();
 }
 
-void CMasternode::UpdateLastPaid(const CBlockIndex *pindex, int nMaxBlocksToScanBack)
+void CMasternode::UpdateLastPaid(int nBlockLastPaidIn, int64_t nTimeLastPaidIn)
 {
-    if(!pindex) return;
-
-    const CBlockIndex *BlockReading = pindex;
-
-    CScript mnpayee = GetScriptForDestination(pubKeyCollateralAddress.GetID());
-    // LogPrint(BCLog::MASTERNODE, "CMasternode::UpdateLastPaidBlock -- searching for block with payment to %s\n", outpoint.ToString());
-
-    LOCK(cs_mapMasternodeBlocks);
-
-    for (int i = 0; BlockReading && BlockReading->nHeight > nBlockLastPaid && i < nMaxBlocksToScanBack; i++) {
-        if(mnpayments.mapMasternodeBlocks.count(BlockReading->nHeight) &&
-            mnpayments.mapMasternodeBlocks[BlockReading->nHeight].HasPayeeWithVotes(mnpayee, 2))
-        {
-            CBlock block;
-            if(!ReadBlockFromDisk(block, BlockReading, Params().GetConsensus())) // shouldn't really happen
-                continue;
-
-            const auto& coinbaseTransaction = (BlockReading->nHeight > Params().GetConsensus().nLastPoWBlock ? block.vtx[1] : block.vtx[0]);
+    if (nBlockLastPaidIn <= nBlockLastPaid) return;
 
-            CAmount nMasternodePayment = GetMasternodePayment(BlockReading->nHeight, BlockReading->nMint);
-
-            for(const CTxOut &txout : coinbaseTransaction->vout)
-                if(mnpayee == txout.scriptPubKey && nMasternodePayment == txout.nValue) {
-                    nBlockLastPaid = BlockReading->nHeight;
-                    nTimeLastPaid = BlockReading->nTime;
-                    LogPrint(BCLog::MASTERNODE, "CMasternode::UpdateLastPaidBlock -- searching for block with payment to %s -- found new %d\n", outpoint.ToString(), nBlockLastPaid);
-                    return;
-                }
-        }
-
-        if (BlockReading->pprev == NULL) { assert(BlockReading); break; }
-        BlockReading = BlockReading->pprev;
-    }
-
-    // Last payment for this masternode wasn't found in latest mnpayments blocks
-    // or it was found in mnpayments blocks but wasn't found in the blockchain.
-    // LogPrint(BCLog::MASTERNODE, "CMasternode::UpdateLastPaidBlock -- searching for block with payment to %s -- keeping old %d\n", outpoint.ToString(), nBlockLastPaid);
+    nBlockLastPaid = nBlockLastPaidIn;
+    nTimeLastPaid = nTimeLastPaidIn;
+    LogPrint(BCLog::MASTERNODE, "CMasternode::UpdateLastPaid -- payment to %s found at %d\n", outpoint.ToString(), nBlockLastPaid);
 }
 
 #ifdef ENABLE_WALLET
@@ -549,6 +542,7 @@ bool CMasternodeBroadcast::Update(CMasternode* pmn, int& nDos, CConnman& connman
         LogPrintf("CMasternodeBroadcast::Update -- Got UPDATED Masternode entry: addr=%s\n", addr.ToString());
         if(pmn->UpdateFromNewBroadcast(*this, connman)) {
             pmn->Check();
+            mnodeman.ScheduleCheck(*pmn, true);
             Relay(connman);
         }
         masternodeSync.BumpAssetLastTime("CMasternodeBroadcast::Update");
@@ -634,25 +628,55 @@ bool CMasternodeBroadcast::CheckOutpoint(int& nDos)
     return true;
 }
 
+uint256 CMasternodeBroadcast::GetSignatureHash() const
+{
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << outpoint;
+    ss << addr;
+    ss << pubKeyCollateralAddress;
+    ss << pubKeyMasternode;
+    ss << sigTime;
+    ss << nProtocolVersion;
+    return ss.GetHash();
+}
+
+std::string CMasternodeBroadcast::GetStrMessage() const
+{
+    return addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
+                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
+                    boost::lexical_cast<std::string>(nProtocolVersion);
+}
+
 bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
 {
     std::string strError;
-    std::string strMessage;
 
     sigTime = GetAdjustedTime();
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                    boost::lexical_cast<std::string>(nProtocolVersion);
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyCollateralAddress, CPubKey::InputScriptType::SPENDP2PKH)) {
-        LogPrintf("CMasternodeBroadcast::Sign -- SignMessage() failed\n");
-        return false;
-    }
+        if(!CHashSigner::SignHash(hash, keyCollateralAddress, CPubKey::InputScriptType::SPENDP2PKH, vchSig)) {
+            LogPrintf("CMasternodeBroadcast::Sign -- SignHash() failed\n");
+            return false;
+        }
 
-    if(!CMessageSigner::VerifyMessage(pubKeyCollateralAddress.GetID(), vchSig, strMessage, strError)) {
-        LogPrintf("CMasternodeBroadcast::Sign -- VerifyMessage() failed, error: %s\n", strError);
-        return false;
+        if(!CHashSigner::VerifyHash(hash, pubKeyCollateralAddress, vchSig, strError)) {
+            LogPrintf("CMasternodeBroadcast::Sign -- VerifyHash() failed, error: %s\n", strError);
+            return false;
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::SignMessage(strMessage, vchSig, keyCollateralAddress, CPubKey::InputScriptType::SPENDP2PKH)) {
+            LogPrintf("CMasternodeBroadcast::Sign -- SignMessage() failed\n");
+            return false;
+        }
+
+        if(!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError)) {
+            LogPrintf("CMasternodeBroadcast::Sign -- VerifyMessage() failed, error: %s\n", strError);
+            return false;
+        }
     }
 
     return true;
@@ -660,20 +684,34 @@ bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
 
 bool CMasternodeBroadcast::CheckSignature(int& nDos)
 {
-    std::string strMessage;
     std::string strError = "";
     nDos = 0;
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                    boost::lexical_cast<std::string>(nProtocolVersion);
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
 
-    LogPrint(BCLog::MASTERNODE, "CMasternodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyCollateralAddress.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
+        if(!CHashSigner::VerifyHash(hash, pubKeyCollateralAddress, vchSig, strError)) {
+            // could be a broadcast signed before the spork, try the old format
+            std::string strMessage = GetStrMessage();
 
-    if(!CMessageSigner::VerifyMessage(pubKeyCollateralAddress.GetID(), vchSig, strMessage, strError)){
-        LogPrintf("CMasternodeBroadcast::CheckSignature -- Got bad Masternode announce signature, error: %s\n", strError);
-        nDos = 100;
-        return false;
+            LogPrint(BCLog::MASTERNODE, "CMasternodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyCollateralAddress.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
+
+            if(!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError)) {
+                LogPrintf("CMasternodeBroadcast::CheckSignature -- Got bad Masternode announce signature, error: %s\n", strError);
+                nDos = 100;
+                return false;
+            }
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        LogPrint(BCLog::MASTERNODE, "CMasternodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyCollateralAddress.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
+
+        if(!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError)){
+            LogPrintf("CMasternodeBroadcast::CheckSignature -- Got bad Masternode announce signature, error: %s\n", strError);
+            nDos = 100;
+            return false;
+        }
     }
 
     return true;
@@ -704,23 +742,53 @@ CMasternodePing::CMasternodePing(const COutPoint& outpoint)
     sigTime = GetAdjustedTime();
 }
 
+uint256 CMasternodePing::GetSignatureHash() const
+{
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << masternodeOutpoint;
+    ss << blockHash;
+    ss << sigTime;
+    ss << fSentinelIsCurrent;
+    ss << nSentinelVersion;
+    return ss.GetHash();
+}
+
+std::string CMasternodePing::GetStrMessage() const
+{
+    // TODO: add sentinel data
+    return CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+}
+
 bool CMasternodePing::Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode)
 {
     std::string strError;
-    std::string strMasterNodeSignMessage;
 
-    // TODO: add sentinel data
     sigTime = GetAdjustedTime();
-    std::string strMessage = CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode, CPubKey::InputScriptType::SPENDP2PKH)) {
-        LogPrintf("CMasternodePing::Sign -- SignMessage() failed\n");
-        return false;
-    }
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode.GetID(), vchSig, strMessage, strError)) {
-        LogPrintf("CMasternodePing::Sign -- VerifyMessage() failed, error: %s\n", strError);
-        return false;
+        if(!CHashSigner::SignHash(hash, keyMasternode, CPubKey::InputScriptType::SPENDP2PKH, vchSig)) {
+            LogPrintf("CMasternodePing::Sign -- SignHash() failed\n");
+            return false;
+        }
+
+        if(!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
+            LogPrintf("CMasternodePing::Sign -- VerifyHash() failed, error: %s\n", strError);
+            return false;
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode, CPubKey::InputScriptType::SPENDP2PKH)) {
+            LogPrintf("CMasternodePing::Sign -- SignMessage() failed\n");
+            return false;
+        }
+
+        if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+            LogPrintf("CMasternodePing::Sign -- VerifyMessage() failed, error: %s\n", strError);
+            return false;
+        }
     }
 
     return true;
@@ -728,16 +796,32 @@ bool CMasternodePing::Sign(const CKey& keyMasternode, const CPubKey& pubKeyMaste
 
 bool CMasternodePing::CheckSignature(CPubKey& pubKeyMasternode, int &nDos)
 {
-    // TODO: add sentinel data
-    std::string strMessage = CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
     std::string strError = "";
     nDos = 0;
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode.GetID(), vchSig, strMessage, strError)) {
-        LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", masternodeOutpoint.ToString(), strError);
-        nDos = 33;
-        return false;
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
+
+        if(!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
+            // could be a ping signed before the spork, try the old format
+            std::string strMessage = GetStrMessage();
+
+            if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+                LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", masternodeOutpoint.ToString(), strError);
+                nDos = 33;
+                return false;
+            }
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+            LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", masternodeOutpoint.ToString(), strError);
+            nDos = 33;
+            return false;
+        }
     }
+
     return true;
 }
 
@@ -842,6 +926,7 @@ bool CMasternodePing::CheckAndUpdate(CMasternode* pmn, bool fFromNewBroadcast, i
 
     // force update, ignoring cache
     pmn->Check(true);
+    mnodeman.ScheduleCheck(*pmn);
     // relay ping for nodes in ENABLED/EXPIRED/WATCHDOG_EXPIRED state only, skip everyone else
     if (!pmn->IsEnabled() && !pmn->IsExpired() && !pmn->IsWatchdogExpired()) return false;
 
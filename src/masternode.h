@@ -73,6 +73,11 @@ public:
 
     bool IsExpired() const { return GetAdjustedTime() - sigTime > MASTERNODE_NEW_START_REQUIRED_SECONDS; }
 
+    /// Hash of the serialized fields, signed once SPORK_6_NEW_SIGS is active
+    uint256 GetSignatureHash() const;
+    /// Text message signed before SPORK_6_NEW_SIGS
+    std::string GetStrMessage() const;
+
     bool Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode);
     bool CheckSignature(CPubKey& pubKeyMasternode, int &nDos);
     bool SimpleCheck(int& nDos);
@@ -185,7 +190,10 @@ public:
         READWRITE(vchSig);
         READWRITE(sigTime);
         READWRITE(nLastDsq);
-        READWRITE(nTimeLastChecked);
+        if(!(s.GetType() & SER_GETHASH)) {
+            // bookkeeping of Check(), the cache journal does not count it as a change
+            READWRITE(nTimeLastChecked);
+        }
         READWRITE(nTimeLastPaid);
         READWRITE(nTimeLastWatchdogVote);
         READWRITE(nActiveState);
@@ -220,6 +228,11 @@ public:
         return nTimeToCheckAt - lastPing.sigTime < nSeconds;
     }
 
+    /// Earliest adjusted time after now at which Check() can move this masternode
+    /// to another state on its own (ping or watchdog vote getting too old);
+    /// 0 if only a new ping, broadcast or chain change can change it
+    int64_t GetNextCheckTime() const;
+
     bool IsEnabled() const;
     bool IsPreEnabled() const { return nActiveState == MASTERNODE_PRE_ENABLED; }
     bool IsPoSeBanned() const { return nActiveState == MASTERNODE_POSE_BAN; }
@@ -259,7 +272,7 @@ public:
 
     int GetLastPaidTime() const { return nTimeLastPaid; }
     int GetLastPaidBlock() const { return nBlockLastPaid; }
-    void UpdateLastPaid(const CBlockIndex *pindex, int nMaxBlocksToScanBack);
+    void UpdateLastPaid(int nBlockLastPaidIn, int64_t nTimeLastPaidIn);
 
     // KEEP TRACK OF EACH GOVERNANCE ITEM INCASE THIS NODE GOES OFFLINE, SO WE CAN RECALC THEIR STATUS
     void AddGovernanceVote(uint256 nGovernanceObjectHash);
@@ -342,6 +355,11 @@ public:
     bool Update(CMasternode* pmn, int& nDos, CConnman& connman);
     bool CheckOutpoint(int& nDos);
 
+    /// Hash of the serialized fields, signed once SPORK_6_NEW_SIGS is active
+    uint256 GetSignatureHash() const;
+    /// Text message signed before SPORK_6_NEW_SIGS
+    std::string GetStrMessage() const;
+
     bool Sign(const CKey& keyCollateralAddress);
     bool CheckSignature(int& nDos);
     void Relay(CConnman& connman);
@@ -86,6 +86,7 @@ struct CompareByAddr
 CMasternodeMan::CMasternodeMan()
     : cs(),
       mapMasternodes(),
+      journalMasternodes("masternodes"),
       mAskedUsForMasternodeList(),
       mWeAskedForMasternodeList(),
       mWeAskedForMasternodeListEntry(),
@@ -97,10 +98,16 @@ CMasternodeMan::CMasternodeMan()
       fMasternodesRemoved(false),
       vecDirtyGovernanceObjectHashes(),
       nLastWatchdogVoteTime(0),
+      mapRankCache(RANK_CACHE_SIZE),
+      pListSnapshot(),
+      fListSnapshotDirty(false),
       mapSeenMasternodeBroadcast(),
       mapSeenMasternodePing(),
       nDsqCount(0)
-{}
+{
+    // readers never find the snapshot missing
+    PublishListSnapshot();
+}
 
 bool CMasternodeMan::Add(CMasternode &mn)
 {
@@ -110,7 +117,12 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.outpoint] = mn;
+    MarkChanged(mn.outpoint);
+    AddToIndexes(mn);
+    ScheduleCheck(mn, true);
     fMasternodesAdded = true;
+    InvalidateRankCache();
+    PublishListSnapshot();
     return true;
 }
 
@@ -153,6 +165,7 @@ bool CMasternodeMan::AllowMixing(const COutPoint &outpoint)
     nDsqCount++;
     pmn->nLastDsq = nDsqCount;
     pmn->fAllowMixingTx = true;
+    MarkChanged(outpoint);
 
     return true;
 }
@@ -165,6 +178,7 @@ bool CMasternodeMan::DisallowMixing(const COutPoint &outpoint)
         return false;
     }
     pmn->fAllowMixingTx = false;
+    MarkChanged(outpoint);
 
     return true;
 }
@@ -177,6 +191,8 @@ bool CMasternodeMan::PoSeBan(const COutPoint &outpoint)
         return false;
     }
     pmn->PoSeBan();
+    MarkChanged(outpoint);
+    ScheduleCheck(*pmn, true);
 
     return true;
 }
@@ -187,11 +203,75 @@ void CMasternodeMan::Check()
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Check -- nLastWatchdogVoteTime=%d, IsWatchdogActive()=%d\n", nLastWatchdogVoteTime, IsWatchdogActive());
 
-    for (auto& mnpair : mapMasternodes) {
-        mnpair.second.Check();
+    // only visit the masternodes whose state can have changed by now
+    int64_t nNow = GetAdjustedTime();
+    while (!setCheckQueue.empty() && setCheckQueue.begin()->first <= nNow) {
+        COutPoint outpoint = setCheckQueue.begin()->second;
+        UnscheduleCheck(outpoint);
+        CMasternode* pmn = Find(outpoint);
+        if (!pmn) continue;
+        CheckEntry(*pmn, true);
+        ScheduleCheck(*pmn);
+    }
+
+    if (fListSnapshotDirty) {
+        PublishListSnapshot();
     }
 }
 
+void CMasternodeMan::CheckEntry(CMasternode& mn, bool fForce)
+{
+    int nActiveStatePrev = mn.nActiveState;
+    int nPoSeBanScorePrev = mn.nPoSeBanScore;
+    int nPoSeBanHeightPrev = mn.nPoSeBanHeight;
+    mn.Check(fForce);
+    if (mn.nActiveState != nActiveStatePrev || mn.nPoSeBanScore != nPoSeBanScorePrev || mn.nPoSeBanHeight != nPoSeBanHeightPrev) {
+        MarkChanged(mn.outpoint);
+    }
+}
+
+void CMasternodeMan::ScheduleCheck(const CMasternode& mn, bool fNow)
+{
+    LOCK(cs);
+    UnscheduleCheck(mn.outpoint);
+
+    if(!fNow && mn.IsPoSeBanned()) {
+        // a ban ends at a height, UpdatedBlockTip moves it back in time
+        setCheckQueueBanned.emplace(mn.nPoSeBanHeight, mn.outpoint);
+        mapCheckScheduled.emplace(mn.outpoint, std::make_pair(true, (int64_t)mn.nPoSeBanHeight));
+        return;
+    }
+
+    int64_t nTime = fNow ? GetAdjustedTime() : mn.GetNextCheckTime();
+    // nothing to wait for, the next ping or broadcast or CheckAndRemove checks it
+    if(nTime == 0) return;
+    setCheckQueue.emplace(nTime, mn.outpoint);
+    mapCheckScheduled.emplace(mn.outpoint, std::make_pair(false, nTime));
+}
+
+void CMasternodeMan::UnscheduleCheck(const COutPoint& outpoint)
+{
+    LOCK(cs);
+    auto it = mapCheckScheduled.find(outpoint);
+    if(it == mapCheckScheduled.end()) return;
+    if(it->second.first) {
+        setCheckQueueBanned.erase(std::make_pair(it->second.second, outpoint));
+    } else {
+        setCheckQueue.erase(std::make_pair(it->second.second, outpoint));
+    }
+    mapCheckScheduled.erase(it);
+}
+
+bool CMasternodeMan::GetScheduledCheck(const COutPoint& outpoint, int64_t& nDueRet, bool& fHeightRet)
+{
+    LOCK(cs);
+    auto it = mapCheckScheduled.find(outpoint);
+    if(it == mapCheckScheduled.end()) return false;
+    fHeightRet = it->second.first;
+    nDueRet = it->second.second;
+    return true;
+}
+
 void CMasternodeMan::CheckAndRemove(CConnman& connman)
 {
     if(!masternodeSync.IsMasternodeListSynced()) return;
@@ -203,12 +283,19 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
         // in CheckMnbAndUpdateMasternodeList()
         LOCK2(cs_main, cs);
 
-        Check();
+        // Spent collateral, a new minimum protocol or the end of the list sync
+        // have no deadline to queue a check at, catch them on this pass over
+        // the whole list instead
+        for (auto& mnpair : mapMasternodes) {
+            CheckEntry(mnpair.second);
+            ScheduleCheck(mnpair.second);
+        }
 
         // Remove spent masternodes, prepare structures and make requests to reasure the state of inactive ones
         rank_pair_vec_t vecMasternodeRanks;
         // ask for up to MNB_RECOVERY_MAX_ASK_ENTRIES masternode entries at a time
         int nAskForMnbRecovery = MNB_RECOVERY_MAX_ASK_ENTRIES;
+        bool fRemoved = false;
         std::map<COutPoint, CMasternode>::iterator it = mapMasternodes.begin();
         while (it != mapMasternodes.end()) {
             CMasternodeBroadcast mnb = CMasternodeBroadcast(it->second);
@@ -223,8 +310,13 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
 
                 // and finally remove it from the list
                 it->second.FlagGovernanceItemsAsDirty();
+                RemoveFromIndexes(it->second);
+                UnscheduleCheck(it->first);
+                MarkChanged(it->first);
                 mapMasternodes.erase(it++);
                 fMasternodesRemoved = true;
+                fRemoved = true;
+                InvalidateRankCache();
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
                         masternodeSync.IsSynced() &&
@@ -259,6 +351,9 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
                 ++it;
             }
         }
+        if (fRemoved) {
+            PublishListSnapshot();
+        }
 
         // proces replies for MASTERNODE_NEW_START_REQUIRED masternodes
         LogPrint(BCLog::MASTERNODE, "CMasternodeMan::CheckAndRemove -- mMnbRecoveryGoodReplies size=%d\n", (int)mMnbRecoveryGoodReplies.size());
@@ -379,6 +474,14 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    journalMasternodes.MarkAllDirty();
+    mapIndexCollateralKey.clear();
+    mapIndexMasternodeKey.clear();
+    mapIndexAddr.clear();
+    setCheckQueue.clear();
+    setCheckQueueBanned.clear();
+    mapCheckScheduled.clear();
+    InvalidateRankCache();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -386,6 +489,95 @@ void CMasternodeMan::Clear()
     mapSeenMasternodePing.clear();
     nDsqCount = 0;
     nLastWatchdogVoteTime = 0;
+    PublishListSnapshot();
+}
+
+void CMasternodeMan::SetJournalBaseline()
+{
+    LOCK(cs);
+    journalMasternodes.SetBaseline(mapMasternodes);
+}
+
+int CMasternodeMan::WriteJournal(CCacheJournalDB& db, bool fSync)
+{
+    CDBBatch batch(db);
+    int nRecords;
+    {
+        LOCK(cs);
+        nRecords = journalMasternodes.WriteChanges(batch, mapMasternodes);
+    }
+    bool fWritten = db.WriteBatch(batch, fSync);
+    LOCK(cs);
+    if(!fWritten) {
+        journalMasternodes.Abort();
+        return -1;
+    }
+    journalMasternodes.Commit();
+    return nRecords;
+}
+
+bool CMasternodeMan::ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    LOCK(cs);
+    if(!journalMasternodes.Replay(db, hashSnapshot, mapMasternodes)) return false;
+    RebuildIndexes();
+    InvalidateRankCache();
+    PublishListSnapshot();
+    return true;
+}
+
+void CMasternodeMan::ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    journalMasternodes.Reset(batch, db, hashSnapshot);
+}
+
+void CMasternodeMan::AddToIndexes(const CMasternode& mn)
+{
+    LOCK(cs);
+    mapIndexCollateralKey[mn.pubKeyCollateralAddress.GetID()].insert(mn.outpoint);
+    mapIndexMasternodeKey[mn.pubKeyMasternode.GetID()].insert(mn.outpoint);
+    mapIndexAddr[mn.addr].insert(mn.outpoint);
+}
+
+template <typename Index, typename Key>
+static void EraseFromIndex(Index& index, const Key& key, const COutPoint& outpoint)
+{
+    auto it = index.find(key);
+    if (it == index.end())
+        return;
+    it->second.erase(outpoint);
+    if (it->second.empty())
+        index.erase(it);
+}
+
+void CMasternodeMan::RemoveFromIndexes(const CMasternode& mn)
+{
+    LOCK(cs);
+    EraseFromIndex(mapIndexCollateralKey, mn.pubKeyCollateralAddress.GetID(), mn.outpoint);
+    EraseFromIndex(mapIndexMasternodeKey, mn.pubKeyMasternode.GetID(), mn.outpoint);
+    EraseFromIndex(mapIndexAddr, mn.addr, mn.outpoint);
+}
+
+void CMasternodeMan::RebuildIndexes()
+{
+    LOCK(cs);
+    mapIndexCollateralKey.clear();
+    mapIndexMasternodeKey.clear();
+    mapIndexAddr.clear();
+    setCheckQueue.clear();
+    setCheckQueueBanned.clear();
+    mapCheckScheduled.clear();
+    // states read from disk may be stale, check everything once
+    for (const auto& mnpair : mapMasternodes) {
+        AddToIndexes(mnpair.second);
+        ScheduleCheck(mnpair.second, true);
+    }
+}
+
+void CMasternodeMan::InvalidateRankCache()
+{
+    LOCK(cs);
+    mapRankCache.Clear();
 }
 
 int CMasternodeMan::CountMasternodes(int nProtocolVersion) const
@@ -447,13 +639,100 @@ void CMasternodeMan::DsegUpdate(CNode* pnode, CConnman& connman)
         }
     }
 
-    connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::DSEG, COutPoint()));
+    if(!mapMasternodes.empty() && pnode->nVersion >= LIST_DIGEST_VERSION) {
+        // we have a list already (e.g. from mncache.dat), only ask for the buckets that differ
+        connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::MNLISTDIGEST, GetListDigests()));
+    } else {
+        connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::DSEG, COutPoint()));
+    }
     int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
     mWeAskedForMasternodeList[pnode->addr] = askAgain;
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::DsegUpdate -- asked %s for the list\n", pnode->addr.ToString());
 }
 
+bool CMasternodeMan::AllowListRequest(CNode* pfrom, const std::string& strCommand)
+{
+    LOCK(cs);
+
+    //local network
+    bool isLocal = (pfrom->addr.IsRFC1918() || pfrom->addr.IsLocal());
+
+    if(!isLocal && Params().NetworkIDString() == CBaseChainParams::MAIN) {
+        std::map<CNetAddr, int64_t>::iterator it = mAskedUsForMasternodeList.find(pfrom->addr);
+        if (it != mAskedUsForMasternodeList.end() && it->second > GetTime()) {
+            Misbehaving(pfrom->GetId(), 34);
+            LogPrintf("%s -- peer already asked me for the list, peer=%d\n", strCommand, pfrom->GetId());
+            return false;
+        }
+        int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
+        mAskedUsForMasternodeList[pfrom->addr] = askAgain;
+    }
+    return true;
+}
+
+bool CMasternodeMan::IsRelayedInList(const CMasternode& mn)
+{
+    if (mn.addr.IsRFC1918() || mn.addr.IsLocal()) return false; // do not send local network masternode
+    if (mn.IsUpdateRequired()) return false; // do not send outdated masternodes
+    return true;
+}
+
+void CMasternodeMan::PushListEntryInvs(CNode* pfrom, const CMasternode& mn)
+{
+    LOCK(cs);
+
+    LogPrint(BCLog::MASTERNODE, "CMasternodeMan::PushListEntryInvs -- Sending Masternode entry: masternode=%s  addr=%s\n", mn.outpoint.ToString(), mn.addr.ToString());
+    CMasternodeBroadcast mnb = CMasternodeBroadcast(mn);
+    CMasternodePing mnp = mn.lastPing;
+    uint256 hashMNB = mnb.GetHash();
+    uint256 hashMNP = mnp.GetHash();
+    pfrom->PushInventory(CInv(MSG_MASTERNODE_ANNOUNCE, hashMNB));
+    pfrom->PushInventory(CInv(MSG_MASTERNODE_PING, hashMNP));
+
+    mapSeenMasternodeBroadcast.insert(std::make_pair(hashMNB, std::make_pair(GetTime(), mnb)));
+    mapSeenMasternodePing.insert(std::make_pair(hashMNP, mnp));
+}
+
+void CMasternodeMan::PushListEntryPingInv(CNode* pfrom, const CMasternode& mn)
+{
+    LOCK(cs);
+
+    CMasternodePing mnp = mn.lastPing;
+    uint256 hashMNP = mnp.GetHash();
+    pfrom->PushInventory(CInv(MSG_MASTERNODE_PING, hashMNP));
+
+    mapSeenMasternodePing.insert(std::make_pair(hashMNP, mnp));
+}
+
+std::vector<uint256> CMasternodeMan::GetListDigests()
+{
+    LOCK(cs);
+
+    // entries come in outpoint order, so both sides hash each bucket in the same order
+    std::vector<CHashWriter> vecWriters(LIST_DIGEST_BUCKETS, CHashWriter(SER_GETHASH, PROTOCOL_VERSION));
+    for (const auto& mnpair : mapMasternodes) {
+        const CMasternode& mn = mnpair.second;
+        if (!IsRelayedInList(mn)) continue;
+        // the fields of the broadcast hash, pings are sent for every bucket
+        vecWriters[GetListDigestBucket(mnpair.first)] << mn.outpoint << mn.pubKeyCollateralAddress << mn.sigTime;
+    }
+
+    std::vector<uint256> vecDigests;
+    vecDigests.reserve(LIST_DIGEST_BUCKETS);
+    for (CHashWriter& writer : vecWriters) {
+        vecDigests.push_back(writer.GetHash());
+    }
+    return vecDigests;
+}
+
+void CMasternodeMan::PublishListSnapshot()
+{
+    LOCK(cs);
+    std::atomic_store(&pListSnapshot, std::make_shared<const CMasternodeListSnapshot>(mapMasternodes));
+    fListSnapshotDirty = false;
+}
+
 CMasternode* CMasternodeMan::Find(const COutPoint &outpoint)
 {
     LOCK(cs);
@@ -488,9 +767,14 @@ bool CMasternodeMan::GetMasternodeInfo(const COutPoint& outpoint, masternode_inf
 bool CMasternodeMan::GetMasternodeInfo(const CPubKey& pubKeyMasternode, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnInfoRet = mnpair.second.GetInfo();
+    auto itIndex = mapIndexMasternodeKey.find(pubKeyMasternode.GetID());
+    if (itIndex == mapIndexMasternodeKey.end()) {
+        return false;
+    }
+    for (const auto& outpoint : itIndex->second) {
+        auto it = mapMasternodes.find(outpoint);
+        if (it != mapMasternodes.end() && it->second.pubKeyMasternode == pubKeyMasternode) {
+            mnInfoRet = it->second.GetInfo();
             return true;
         }
     }
@@ -500,10 +784,21 @@ bool CMasternodeMan::GetMasternodeInfo(const CPubKey& pubKeyMasternode, masterno
 bool CMasternodeMan::GetMasternodeInfo(const CScript& payee, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (auto& mnpair : mapMasternodes) {
-        CScript scriptCollateralAddress = GetScriptForDestination(mnpair.second.pubKeyCollateralAddress.GetID());
+    CTxDestination dest;
+    const CKeyID* keyID;
+    if (!ExtractDestination(payee, dest) || !(keyID = boost::get<CKeyID>(&dest))) {
+        return false;
+    }
+    auto itIndex = mapIndexCollateralKey.find(*keyID);
+    if (itIndex == mapIndexCollateralKey.end()) {
+        return false;
+    }
+    for (const auto& outpoint : itIndex->second) {
+        auto it = mapMasternodes.find(outpoint);
+        if (it == mapMasternodes.end()) continue;
+        CScript scriptCollateralAddress = GetScriptForDestination(it->second.pubKeyCollateralAddress.GetID());
         if (scriptCollateralAddress == payee) {
-            mnInfoRet = mnpair.second.GetInfo();
+            mnInfoRet = it->second.GetInfo();
             return true;
         }
     }
@@ -666,6 +961,32 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     return !vecMasternodeScoresRet.empty();
 }
 
+CMasternodeMan::ranks_ptr_t CMasternodeMan::GetRanksForBlock(const uint256& nBlockHash, int nMinProtocol)
+{
+    AssertLockHeld(cs);
+
+    std::pair<uint256, int> key(nBlockHash, nMinProtocol);
+    ranks_ptr_t pranks;
+    if (mapRankCache.GetAndRefresh(key, pranks))
+        return pranks;
+
+    score_pair_vec_t vecMasternodeScores;
+    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+        return nullptr;
+
+    std::shared_ptr<CMasternodeRanks> pranksNew = std::make_shared<CMasternodeRanks>();
+    pranksNew->vecOutpoints.reserve(vecMasternodeScores.size());
+    pranksNew->mapRanks.reserve(vecMasternodeScores.size());
+    for (auto& scorePair : vecMasternodeScores) {
+        pranksNew->vecOutpoints.push_back(scorePair.second->outpoint);
+        pranksNew->mapRanks.emplace(scorePair.second->outpoint, pranksNew->vecOutpoints.size());
+    }
+
+    pranks = pranksNew;
+    mapRankCache.Insert(key, pranks);
+    return pranks;
+}
+
 bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet, int nBlockHeight, int nMinProtocol)
 {
     nRankRet = -1;
@@ -682,20 +1003,16 @@ bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet,
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    ranks_ptr_t pranks = GetRanksForBlock(nBlockHash, nMinProtocol);
+    if (!pranks)
         return false;
 
-    int nRank = 0;
-    for (auto& scorePair : vecMasternodeScores) {
-        nRank++;
-        if(scorePair.second->outpoint == outpoint) {
-            nRankRet = nRank;
-            return true;
-        }
-    }
+    auto it = pranks->mapRanks.find(outpoint);
+    if (it == pranks->mapRanks.end())
+        return false;
 
-    return false;
+    nRankRet = it->second;
+    return true;
 }
 
 bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight, int nMinProtocol)
@@ -714,14 +1031,17 @@ bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMast
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    ranks_ptr_t pranks = GetRanksForBlock(nBlockHash, nMinProtocol);
+    if (!pranks)
         return false;
 
+    vecMasternodeRanksRet.reserve(pranks->vecOutpoints.size());
     int nRank = 0;
-    for (auto& scorePair : vecMasternodeScores) {
+    for (const auto& outpoint : pranks->vecOutpoints) {
         nRank++;
-        vecMasternodeRanksRet.push_back(std::make_pair(nRank, *scorePair.second));
+        CMasternode* pmn = Find(outpoint);
+        if (pmn)
+            vecMasternodeRanksRet.push_back(std::make_pair(nRank, *pmn));
     }
 
     return true;
@@ -835,7 +1155,10 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         if(pmn && pmn->IsNewStartRequired()) return;
 
         int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        bool fUpdated = mnp.CheckAndUpdate(pmn, false, nDos, connman);
+        // a rejected ping can still have checked the masternode
+        if(pmn) MarkChanged(pmn->outpoint);
+        if(fUpdated) return;
 
         if(nDos > 0) {
             // if anything significant failed, mark that node
@@ -863,39 +1186,17 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         LOCK(cs);
 
         if (masternodeOutpoint.IsNull()) { //only should ask for this once
-            //local network
-            bool isLocal = (pfrom->addr.IsRFC1918() || pfrom->addr.IsLocal());
-
-            if(!isLocal && Params().NetworkIDString() == CBaseChainParams::MAIN) {
-                std::map<CNetAddr, int64_t>::iterator it = mAskedUsForMasternodeList.find(pfrom->addr);
-                if (it != mAskedUsForMasternodeList.end() && it->second > GetTime()) {
-                    Misbehaving(pfrom->GetId(), 34);
-                    LogPrintf("DSEG -- peer already asked me for the list, peer=%d\n", pfrom->GetId());
-                    return;
-                }
-                int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
-                mAskedUsForMasternodeList[pfrom->addr] = askAgain;
-            }
+            if (!AllowListRequest(pfrom, "DSEG")) return;
         } //else, asking for a specific node which is ok
 
         int nInvCount = 0;
 
         for (auto& mnpair : mapMasternodes) {
             if (!masternodeOutpoint.IsNull() && masternodeOutpoint != mnpair.second.outpoint) continue; // asked for specific vin but we are not there yet
-            if (mnpair.second.addr.IsRFC1918() || mnpair.second.addr.IsLocal()) continue; // do not send local network masternode
-            if (mnpair.second.IsUpdateRequired()) continue; // do not send outdated masternodes
-
-            LogPrint(BCLog::MASTERNODE, "DSEG -- Sending Masternode entry: masternode=%s  addr=%s\n", mnpair.first.ToString(), mnpair.second.addr.ToString());
-            CMasternodeBroadcast mnb = CMasternodeBroadcast(mnpair.second);
-            CMasternodePing mnp = mnpair.second.lastPing;
-            uint256 hashMNB = mnb.GetHash();
-            uint256 hashMNP = mnp.GetHash();
-            pfrom->PushInventory(CInv(MSG_MASTERNODE_ANNOUNCE, hashMNB));
-            pfrom->PushInventory(CInv(MSG_MASTERNODE_PING, hashMNP));
-            nInvCount++;
+            if (!IsRelayedInList(mnpair.second)) continue;
 
-            mapSeenMasternodeBroadcast.insert(std::make_pair(hashMNB, std::make_pair(GetTime(), mnb)));
-            mapSeenMasternodePing.insert(std::make_pair(hashMNP, mnp));
+            PushListEntryInvs(pfrom, mnpair.second);
+            nInvCount++;
 
             if (masternodeOutpoint == mnpair.first) {
                 LogPrint(BCLog::MASTERNODE, "DSEG -- Sent 1 Masternode inv to peer %d\n", pfrom->GetId());
@@ -911,6 +1212,48 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         // smth weird happen - someone asked us for vin we have no idea about?
         LogPrint(BCLog::MASTERNODE, "DSEG -- No invs sent to peer %d\n", pfrom->GetId());
 
+    } else if (strCommand == NetMsgType::MNLISTDIGEST) { //Get the Masternode list entries in the buckets that differ from ours
+        if (!masternodeSync.IsSynced()) return;
+
+        std::vector<uint256> vecDigests;
+        vRecv >> vecDigests;
+
+        if (vecDigests.size() != LIST_DIGEST_BUCKETS) {
+            LogPrintf("MNLISTDIGEST -- invalid number of buckets %d, peer=%d\n", vecDigests.size(), pfrom->GetId());
+            Misbehaving(pfrom->GetId(), 20);
+            return;
+        }
+
+        LOCK(cs);
+
+        if (!AllowListRequest(pfrom, "MNLISTDIGEST")) return;
+
+        std::vector<uint256> vecOurDigests = GetListDigests();
+        int nInvCount = 0;
+        int nBucketsDiffer = 0;
+        for (int i = 0; i < LIST_DIGEST_BUCKETS; i++) {
+            if (vecDigests[i] != vecOurDigests[i]) nBucketsDiffer++;
+        }
+
+        int nPingCount = 0;
+        for (auto& mnpair : mapMasternodes) {
+            if (!IsRelayedInList(mnpair.second)) continue;
+
+            int nBucket = GetListDigestBucket(mnpair.first);
+            if (vecDigests[nBucket] == vecOurDigests[nBucket]) {
+                // the peer has this entry, but its ping could be stale
+                PushListEntryPingInv(pfrom, mnpair.second);
+                nPingCount++;
+                continue;
+            }
+
+            PushListEntryInvs(pfrom, mnpair.second);
+            nInvCount++;
+        }
+
+        connman.PushMessage(pfrom, CNetMsgMaker(pfrom->GetSendVersion()).Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_LIST, nInvCount));
+        LogPrint(BCLog::MASTERNODE, "MNLISTDIGEST -- Sent %d Masternode invs from %d differing buckets and %d ping invs to peer %d\n", nInvCount, nBucketsDiffer, nPingCount, pfrom->GetId());
+
     } else if (strCommand == NetMsgType::MNVERIFY) { // Masternode Verify
 
         // Need LOCK2 here to ensure consistent locking order because the all functions below call GetBlockHash which locks cs_main
@@ -1024,31 +1367,29 @@ void CMasternodeMan::CheckSameAddr()
     if(!masternodeSync.IsSynced() || mapMasternodes.empty()) return;
 
     std::vector<CMasternode*> vBan;
-    std::vector<CMasternode*> vSortedByAddr;
 
     {
         LOCK(cs);
 
-        CMasternode* pprevMasternode = NULL;
-        CMasternode* pverifiedMasternode = NULL;
-
-        for (auto& mnpair : mapMasternodes) {
-            vSortedByAddr.push_back(&mnpair.second);
-        }
-
-        std::sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
-
-        for(CMasternode* pmn : vSortedByAddr) {
-            // check only (pre)enabled masternodes
-            if(!pmn->IsEnabled() && !pmn->IsPreEnabled()) continue;
-            // initial step
-            if(!pprevMasternode) {
-                pprevMasternode = pmn;
-                pverifiedMasternode = pmn->IsPoSeVerified() ? pmn : NULL;
-                continue;
-            }
-            // second+ step
-            if(pmn->addr == pprevMasternode->addr) {
+        // only addresses shared by several masternodes can produce duplicates
+        for (const auto& addrpair : mapIndexAddr) {
+            if (addrpair.second.size() < 2) continue;
+
+            CMasternode* pprevMasternode = NULL;
+            CMasternode* pverifiedMasternode = NULL;
+
+            for (const auto& outpoint : addrpair.second) {
+                CMasternode* pmn = Find(outpoint);
+                if (!pmn || pmn->addr != addrpair.first) continue;
+                // check only (pre)enabled masternodes
+                if(!pmn->IsEnabled() && !pmn->IsPreEnabled()) continue;
+                // initial step
+                if(!pprevMasternode) {
+                    pprevMasternode = pmn;
+                    pverifiedMasternode = pmn->IsPoSeVerified() ? pmn : NULL;
+                    continue;
+                }
+                // second+ step
                 if(pverifiedMasternode) {
                     // another masternode with the same ip is verified, ban this one
                     vBan.push_back(pmn);
@@ -1058,10 +1399,8 @@ void CMasternodeMan::CheckSameAddr()
                     // and keep a reference to be able to ban following masternodes with the same ip
                     pverifiedMasternode = pmn;
                 }
-            } else {
-                pverifiedMasternode = pmn->IsPoSeVerified() ? pmn : NULL;
+                pprevMasternode = pmn;
             }
-            pprevMasternode = pmn;
         }
     }
 
@@ -1069,6 +1408,8 @@ void CMasternodeMan::CheckSameAddr()
     for(CMasternode* pmn : vBan) {
         LogPrintf("CMasternodeMan::CheckSameAddr -- increasing PoSe ban score for masternode %s\n", pmn->outpoint.ToString());
         pmn->IncreasePoSeBanScore();
+        MarkChanged(pmn->outpoint);
+        ScheduleCheck(*pmn, true);
     }
 }
 
@@ -1127,7 +1468,7 @@ void CMasternodeMan::SendVerifyReply(CNode* pnode, CMasternodeVerification& mnv,
 
     std::string strError;
 
-    if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode.GetID(), mnv.vchSig1, strMessage, strError)) {
+    if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode, mnv.vchSig1, strMessage, strError)) {
         LogPrintf("MasternodeMan::SendVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
         return;
     }
@@ -1185,11 +1526,12 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         std::string strMessage1 = strprintf("%s%d%s", pnode->addr.ToString(false), mnv.nonce, blockHash.ToString());
         for (auto& mnpair : mapMasternodes) {
             if(CAddress(mnpair.second.addr, NODE_NETWORK) == pnode->addr) {
-                if(CMessageSigner::VerifyMessage(mnpair.second.pubKeyMasternode.GetID(), mnv.vchSig1, strMessage1, strError)) {
+                if(CMessageSigner::VerifyMessage(mnpair.second.pubKeyMasternode, mnv.vchSig1, strMessage1, strError)) {
                     // found it!
                     prealMasternode = &mnpair.second;
                     if(!mnpair.second.IsPoSeVerified()) {
                         mnpair.second.DecreasePoSeBanScore();
+                        MarkChanged(mnpair.first);
                     }
                     netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
 
@@ -1209,7 +1551,7 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
 
                     std::string strError;
 
-                    if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode.GetID(), mnv.vchSig2, strMessage2, strError)) {
+                    if(!CMessageSigner::VerifyMessage(activeMasternode.pubKeyMasternode, mnv.vchSig2, strMessage2, strError)) {
                         LogPrintf("MasternodeMan::ProcessVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
                         return;
                     }
@@ -1236,6 +1578,8 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         // increase ban score for everyone else
         for(CMasternode* pmn : vpMasternodesToBan) {
             pmn->IncreasePoSeBanScore();
+            MarkChanged(pmn->outpoint);
+            ScheduleCheck(*pmn, true);
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyReply -- increased PoSe ban score for %s addr %s, new score %d\n",
                      prealMasternode->outpoint.ToString(), pnode->addr.ToString(), pmn->nPoSeBanScore);
         }
@@ -1316,18 +1660,19 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
             return;
         }
 
-        if(!CMessageSigner::VerifyMessage(pmn1->pubKeyMasternode.GetID(), mnv.vchSig1, strMessage1, strError)) {
+        if(!CMessageSigner::VerifyMessage(pmn1->pubKeyMasternode, mnv.vchSig1, strMessage1, strError)) {
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- VerifyMessage() for masternode1 failed, error: %s\n", strError);
             return;
         }
 
-        if(!CMessageSigner::VerifyMessage(pmn2->pubKeyMasternode.GetID(), mnv.vchSig2, strMessage2, strError)) {
+        if(!CMessageSigner::VerifyMessage(pmn2->pubKeyMasternode, mnv.vchSig2, strMessage2, strError)) {
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- VerifyMessage() for masternode2 failed, error: %s\n", strError);
             return;
         }
 
         if(!pmn1->IsPoSeVerified()) {
             pmn1->DecreasePoSeBanScore();
+            MarkChanged(pmn1->outpoint);
         }
         mnv.Relay();
 
@@ -1336,12 +1681,18 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
 
         // increase ban score for everyone else with the same addr
         int nCount = 0;
-        for (auto& mnpair : mapMasternodes) {
-            if(mnpair.second.addr != mnv.addr || mnpair.first == mnv.vin1.prevout) continue;
-            mnpair.second.IncreasePoSeBanScore();
-            nCount++;
-            LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
-                     mnpair.first.ToString(), mnpair.second.addr.ToString(), mnpair.second.nPoSeBanScore);
+        auto itAddr = mapIndexAddr.find(mnv.addr);
+        if (itAddr != mapIndexAddr.end()) {
+            for (const auto& outpoint : itAddr->second) {
+                CMasternode* pmn = Find(outpoint);
+                if(!pmn || pmn->addr != mnv.addr || outpoint == mnv.vin1.prevout) continue;
+                pmn->IncreasePoSeBanScore();
+                MarkChanged(outpoint);
+                ScheduleCheck(*pmn, true);
+                nCount++;
+                LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
+                         outpoint.ToString(), pmn->addr.ToString(), pmn->nPoSeBanScore);
+            }
         }
         if(nCount)
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- PoSe score increased for %d fake masternodes, addr %s\n",
@@ -1378,6 +1729,8 @@ void CMasternodeMan::UpdateMasternodeList(CMasternodeBroadcast mnb, CConnman& co
     } else {
         CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
         if(pmn->UpdateFromNewBroadcast(mnb, connman)) {
+            MarkChanged(mnb.outpoint);
+            ScheduleCheck(*pmn, true);
             masternodeSync.BumpAssetLastTime("CMasternodeMan::UpdateMasternodeList - seen");
             mapSeenMasternodeBroadcast.erase(mnbOld.GetHash());
         }
@@ -1440,7 +1793,10 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         CMasternode* pmn = Find(mnb.outpoint);
         if(pmn) {
             CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-            if(!mnb.Update(pmn, nDos, connman)) {
+            // even a rejected broadcast can have checked the masternode
+            bool fUpdated = mnb.Update(pmn, nDos, connman);
+            MarkChanged(mnb.outpoint);
+            if(!fUpdated) {
                 LogPrint(BCLog::MASTERNODE, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- Update() failed, masternode=%s\n", mnb.outpoint.ToString());
                 return false;
             }
@@ -1478,25 +1834,98 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
     return true;
 }
 
+void CMasternodeMan::AddBlockPayees(const CBlock& block, const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs);
+
+    CBlockPayees& payees = mapBlockPayees[pindex->nHeight];
+    payees.blockHash = pindex->GetBlockHash();
+    payees.nTime = pindex->nTime;
+    payees.vecPayees.clear();
+
+    size_t nPaymentTx = pindex->nHeight > Params().GetConsensus().nLastPoWBlock ? 1 : 0;
+    if (block.vtx.size() <= nPaymentTx)
+        return;
+
+    CAmount nMasternodePayment = GetMasternodePayment(pindex->nHeight, pindex->nMint);
+    for (const CTxOut& txout : block.vtx[nPaymentTx]->vout) {
+        if (txout.nValue == nMasternodePayment)
+            payees.vecPayees.push_back(txout.scriptPubKey);
+    }
+}
+
+void CMasternodeMan::BlockConnected(const CBlock& block, const CBlockIndex* pindex)
+{
+    if(fLiteMode) return;
+
+    LOCK(cs);
+    AddBlockPayees(block, pindex);
+
+    // Anything above this height belonged to a chain we have left
+    mapBlockPayees.erase(mapBlockPayees.upper_bound(pindex->nHeight), mapBlockPayees.end());
+    mapBlockPayees.erase(mapBlockPayees.begin(), mapBlockPayees.lower_bound(pindex->nHeight - mnpayments.GetStorageLimit()));
+}
+
+void CMasternodeMan::BlockDisconnected(const CBlock& block)
+{
+    if(fLiteMode) return;
+
+    LOCK(cs);
+    uint256 hash = block.GetHash();
+    for (auto it = mapBlockPayees.rbegin(); it != mapBlockPayees.rend(); ++it) {
+        if (it->second.blockHash == hash) {
+            mapBlockPayees.erase(std::next(it).base());
+            return;
+        }
+    }
+}
+
 void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
 {
     LOCK2(cs_main, cs);
 
-    if(fLiteMode || !masternodeSync.IsWinnersListSynced() || mapMasternodes.empty()) return;
+    if(fLiteMode || !masternodeSync.IsWinnersListSynced() || mapMasternodes.empty() || !pindex) return;
 
-    static bool IsFirstRun = true;
-    // Do full scan on first run or if we are not a masternode
-    // (MNs should update this info on every block, so limited scan should be enough for them)
-    int nMaxBlocksToScanBack = (IsFirstRun || !fMasterNode) ? mnpayments.GetStorageLimit() : LAST_PAID_SCAN_BLOCKS;
+    int nMaxBlocksToScanBack = mnpayments.GetStorageLimit();
 
-    // LogPrint(BCLog::MNPAYMENTS, "CMasternodeMan::UpdateLastPaid -- nHeight=%d, nMaxBlocksToScanBack=%d, IsFirstRun=%s\n",
-    //                         nCachedBlockHeight, nMaxBlocksToScanBack, IsFirstRun ? "true" : "false");
+    // Bring the payee index in line with the active chain, reading only
+    // blocks that were connected before we started tracking them
+    const CBlockIndex* pindexReading = pindex;
+    for (int i = 0; pindexReading && i < nMaxBlocksToScanBack; i++, pindexReading = pindexReading->pprev) {
+        auto it = mapBlockPayees.find(pindexReading->nHeight);
+        if (it != mapBlockPayees.end() && it->second.blockHash == pindexReading->GetBlockHash())
+            continue;
+        if (!mnpayments.HasPaymentBlock(pindexReading->nHeight)) {
+            if (it != mapBlockPayees.end())
+                mapBlockPayees.erase(it);
+            continue;
+        }
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindexReading, Params().GetConsensus())) // shouldn't really happen
+            continue;
+        AddBlockPayees(block, pindexReading);
+    }
 
-    for (auto& mnpair: mapMasternodes) {
-        mnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+    // Latest block paying each payee, from one pass over the window
+    std::map<CScript, std::pair<int, int64_t> > mapLastPaid;
+    {
+        auto itEnd = mapBlockPayees.upper_bound(pindex->nHeight);
+        auto itBegin = mapBlockPayees.upper_bound(pindex->nHeight - nMaxBlocksToScanBack);
+        for (auto it = std::reverse_iterator<decltype(itEnd)>(itEnd); it != std::reverse_iterator<decltype(itBegin)>(itBegin); ++it) {
+            for (const CScript& payee : it->second.vecPayees) {
+                if (!mapLastPaid.count(payee) && mnpayments.HasPayeeWithVotes(it->first, payee, 2))
+                    mapLastPaid.emplace(payee, std::make_pair(it->first, it->second.nTime));
+            }
+        }
     }
 
-    IsFirstRun = false;
+    for (auto& mnpair: mapMasternodes) {
+        auto it = mapLastPaid.find(GetScriptForDestination(mnpair.second.pubKeyCollateralAddress.GetID()));
+        if (it == mapLastPaid.end()) continue;
+        int nBlockLastPaidPrev = mnpair.second.nBlockLastPaid;
+        mnpair.second.UpdateLastPaid(it->second.first, it->second.second);
+        if (mnpair.second.nBlockLastPaid != nBlockLastPaidPrev) MarkChanged(mnpair.first);
+    }
 }
 
 void CMasternodeMan::UpdateWatchdogVoteTime(const COutPoint& outpoint, uint64_t nVoteTime)
@@ -1507,7 +1936,9 @@ void CMasternodeMan::UpdateWatchdogVoteTime(const COutPoint& outpoint, uint64_t
         return;
     }
     pmn->UpdateWatchdogVoteTime(nVoteTime);
+    MarkChanged(outpoint);
     nLastWatchdogVoteTime = GetTime();
+    ScheduleCheck(*pmn);
 }
 
 bool CMasternodeMan::IsWatchdogActive()
@@ -1525,6 +1956,7 @@ bool CMasternodeMan::AddGovernanceVote(const COutPoint& outpoint, uint256 nGover
         return false;
     }
     pmn->AddGovernanceVote(nGovernanceObjectHash);
+    MarkChanged(outpoint);
     return true;
 }
 
@@ -1532,16 +1964,24 @@ void CMasternodeMan::RemoveGovernanceObject(uint256 nGovernanceObjectHash)
 {
     LOCK(cs);
     for(auto& mnpair : mapMasternodes) {
+        if(!mnpair.second.mapGovernanceObjectsVotedOn.count(nGovernanceObjectHash)) continue;
         mnpair.second.RemoveGovernanceObject(nGovernanceObjectHash);
+        MarkChanged(mnpair.first);
     }
 }
 
 void CMasternodeMan::CheckMasternode(const CPubKey& pubKeyMasternode, bool fForce)
 {
     LOCK2(cs_main, cs);
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnpair.second.Check(fForce);
+    auto itIndex = mapIndexMasternodeKey.find(pubKeyMasternode.GetID());
+    if (itIndex == mapIndexMasternodeKey.end()) {
+        return;
+    }
+    for (const auto& outpoint : itIndex->second) {
+        CMasternode* pmn = Find(outpoint);
+        if (pmn && pmn->pubKeyMasternode == pubKeyMasternode) {
+            CheckEntry(*pmn, fForce);
+            ScheduleCheck(*pmn);
             return;
         }
     }
@@ -1562,12 +2002,14 @@ void CMasternodeMan::SetMasternodeLastPing(const COutPoint& outpoint, const CMas
         return;
     }
     pmn->lastPing = mnp;
+    MarkChanged(outpoint);
     // if masternode uses sentinel ping instead of watchdog
     // we shoud update nTimeLastWatchdogVote here if sentinel
     // ping flag is actual
     if(mnp.fSentinelIsCurrent) {
         UpdateWatchdogVoteTime(mnp.masternodeOutpoint, mnp.sigTime);
     }
+    ScheduleCheck(*pmn, true);
     mapSeenMasternodePing.insert(std::make_pair(mnp.GetHash(), mnp));
 
     CMasternodeBroadcast mnb(*pmn);
@@ -1582,6 +2024,20 @@ void CMasternodeMan::UpdatedBlockTip(const CBlockIndex *pindex)
     nCachedBlockHeight = pindex->nHeight;
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::UpdatedBlockTip -- nCachedBlockHeight=%d\n", nCachedBlockHeight);
 
+    {
+        LOCK(cs);
+        // PoSe bans that end with this block
+        while (!setCheckQueueBanned.empty() && setCheckQueueBanned.begin()->first <= nCachedBlockHeight) {
+            COutPoint outpoint = setCheckQueueBanned.begin()->second;
+            CMasternode* pmn = Find(outpoint);
+            if (pmn) {
+                ScheduleCheck(*pmn, true);
+            } else {
+                UnscheduleCheck(outpoint);
+            }
+        }
+    }
+
     CheckSameAddr();
 
     if(fMasterNode) {
@@ -5,16 +5,32 @@
 #ifndef MASTERNODEMAN_H
 #define MASTERNODEMAN_H
 
+#include <cache-journal.h>
+#include <cachemap.h>
 #include <masternode.h>
 #include <sync.h>
 
+#include <memory>
+#include <unordered_map>
+
 using namespace std;
 
 class CMasternodeMan;
 class CConnman;
+class CBlock;
 
 extern CMasternodeMan mnodeman;
 
+/** The masternode list as of one moment, shared by its readers and never changed */
+struct CMasternodeListSnapshot
+{
+    const std::map<COutPoint, CMasternode> mapMasternodes;
+
+    explicit CMasternodeListSnapshot(const std::map<COutPoint, CMasternode>& mapMasternodesIn) :
+        mapMasternodes(mapMasternodesIn)
+        {}
+};
+
 class CMasternodeMan
 {
 public:
@@ -22,13 +38,19 @@ public:
     typedef std::vector<score_pair_t> score_pair_vec_t;
     typedef std::pair<int, CMasternode> rank_pair_t;
     typedef std::vector<rank_pair_t> rank_pair_vec_t;
+    typedef std::shared_ptr<const CMasternodeListSnapshot> list_snapshot_ptr_t;
 
 private:
     static const std::string SERIALIZATION_VERSION_STRING;
 
     static const int DSEG_UPDATE_SECONDS        = 3 * 60 * 60;
 
-    static const int LAST_PAID_SCAN_BLOCKS      = 100;
+    /// Buckets of the list digest, by the first byte of the collateral txid
+    static const int LIST_DIGEST_BUCKETS        = 256;
+
+    static const int RANK_CACHE_SIZE            = 32;
+
+    /// Age after which the next reader takes a new list snapshot
 
     static const int MIN_POSE_PROTO_VERSION     = 70203;
     static const int MAX_POSE_CONNECTIONS       = 10;
@@ -50,6 +72,7 @@ private:
 
     // map to hold all MNs
     std::map<COutPoint, CMasternode> mapMasternodes;
+    CCacheJournalTable<COutPoint, CMasternode> journalMasternodes;
     // who's asked for the Masternode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForMasternodeList;
     // who we asked for the Masternode list and the last time
@@ -74,11 +97,83 @@ private:
 
     int64_t nLastWatchdogVoteTime;
 
+    /// Masternode order for one block hash and minimum protocol version
+    struct CMasternodeRanks {
+        /// best score first
+        std::vector<COutPoint> vecOutpoints;
+        /// 1-based rank by outpoint
+        std::unordered_map<COutPoint, int, SaltedOutpointHasher> mapRanks;
+    };
+    typedef std::shared_ptr<const CMasternodeRanks> ranks_ptr_t;
+
+    /// Secondary indexes into mapMasternodes by collateral key, masternode key
+    /// and address; lookups re-check the indexed field against the entry
+    std::unordered_map<CKeyID, std::set<COutPoint>, SaltedKeyIDHasher> mapIndexCollateralKey;
+    std::unordered_map<CKeyID, std::set<COutPoint>, SaltedKeyIDHasher> mapIndexMasternodeKey;
+    std::map<CService, std::set<COutPoint> > mapIndexAddr;
+
+    void RebuildIndexes();
+
+    /// Masternodes ordered by the adjusted time of their next state deadline,
+    /// and PoSe-banned ones by the height their ban ends. Each masternode is in
+    /// at most one of the queues, at the place mapCheckScheduled records.
+    std::set<std::pair<int64_t, COutPoint> > setCheckQueue;
+    std::set<std::pair<int64_t, COutPoint> > setCheckQueueBanned;
+    std::map<COutPoint, std::pair<bool, int64_t> > mapCheckScheduled;
+
+    void UnscheduleCheck(const COutPoint& outpoint);
+
+    /// The entry was added, changed in place or is about to be erased, the
+    /// next journal flush writes it and the next snapshot has it
+    void MarkChanged(const COutPoint& outpoint)
+    {
+        journalMasternodes.MarkDirty(outpoint);
+        fListSnapshotDirty = true;
+    }
+    /// Check an entry and mark it changed if its state or ban score did
+    void CheckEntry(CMasternode& mn, bool fForce = false);
+
+    /// Recently used rank tables, dropped whenever the masternode list changes
+    CacheMap<std::pair<uint256, int>, ranks_ptr_t> mapRankCache;
+
+    /// Latest list snapshot, only accessed with std::atomic_load/atomic_store
+    list_snapshot_ptr_t pListSnapshot;
+    /// Entries changed in place since the snapshot was published
+    bool fListSnapshotDirty;
+
+    /// Copy the list into a new snapshot for GetListSnapshot(). Called right
+    /// away when masternodes join or leave the list, for changed fields by
+    /// the next Check().
+    void PublishListSnapshot();
+
+    /// Masternode payment candidates of one active chain block
+    struct CBlockPayees {
+        uint256 blockHash;
+        int64_t nTime;
+        std::vector<CScript> vecPayees;
+    };
+
+    /// Payment candidates by height over the payments storage window, so
+    /// last-paid updates need no block reads; maintained on connect/disconnect
+    std::map<int, CBlockPayees> mapBlockPayees;
+
+    void AddBlockPayees(const CBlock& block, const CBlockIndex* pindex);
+
     friend class CMasternodeSync;
     /// Find an entry
     CMasternode* Find(const COutPoint& outpoint);
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
+    ranks_ptr_t GetRanksForBlock(const uint256& nBlockHash, int nMinProtocol);
+
+    static int GetListDigestBucket(const COutPoint& outpoint) { return *outpoint.hash.begin(); }
+    /// Rate limit full list and list digest requests per peer
+    bool AllowListRequest(CNode* pfrom, const std::string& strCommand);
+    /// Whether a masternode is sent to peers syncing the list
+    static bool IsRelayedInList(const CMasternode& mn);
+    void PushListEntryInvs(CNode* pfrom, const CMasternode& mn);
+    /// Only the ping inv, for entries the peer already has
+    void PushListEntryPingInv(CNode* pfrom, const CMasternode& mn);
 
 public:
     // Keep track of all broadcasts I've seen
@@ -106,6 +201,10 @@ public:
         }
 
         READWRITE(mapMasternodes);
+        if(ser_action.ForRead()) {
+            RebuildIndexes();
+            PublishListSnapshot();
+        }
         READWRITE(mAskedUsForMasternodeList);
         READWRITE(mWeAskedForMasternodeList);
         READWRITE(mWeAskedForMasternodeListEntry);
@@ -119,6 +218,9 @@ public:
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
+        if(ser_action.ForRead()) {
+            mapRankCache.Clear();
+        }
     }
 
     CMasternodeMan();
@@ -134,8 +236,14 @@ public:
     bool AllowMixing(const COutPoint &outpoint);
     bool DisallowMixing(const COutPoint &outpoint);
 
-    /// Check all Masternodes
+    /// Check the Masternodes whose state deadline has come
     void Check();
+    /// Queue the next check of a masternode at its next state deadline, or
+    /// right away when something other than time changed it (fNow)
+    void ScheduleCheck(const CMasternode& mn, bool fNow = false);
+    /// When the next check of a masternode is due: an adjusted time, or with
+    /// fHeightRet set the height its PoSe ban ends. False if none is queued.
+    bool GetScheduledCheck(const COutPoint& outpoint, int64_t& nDueRet, bool& fHeightRet);
 
     /// Check all Masternodes and remove inactive
     void CheckAndRemove(CConnman& connman);
@@ -145,6 +253,20 @@ public:
     /// Clear Masternode vector
     void Clear();
 
+    /// Journal of the masternode list between snapshots, see CJournaledFlatDB
+    void SetJournalBaseline();
+    int WriteJournal(CCacheJournalDB& db, bool fSync);
+    bool ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot);
+    void ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot);
+
+    /// Forget cached ranks, must be called whenever scores or membership can change
+    void InvalidateRankCache();
+
+    /// Keep the secondary indexes in step with a listed masternode whose
+    /// keys or address are about to change (Remove) or just changed (Add)
+    void AddToIndexes(const CMasternode& mn);
+    void RemoveFromIndexes(const CMasternode& mn);
+
     /// Count Masternodes filtered by nProtocolVersion.
     /// Masternode nProtocolVersion should match or be above the one specified in param here.
     int CountMasternodes(int nProtocolVersion = -1) const;
@@ -157,6 +279,11 @@ public:
 
     void DsegUpdate(CNode* pnode, CConnman& connman);
 
+    /// Digest of the masternodes we would send to a syncing peer, per bucket.
+    /// A peer that sends its own gets the entries of the buckets that differ
+    /// and the pings of all the others.
+    std::vector<uint256> GetListDigests();
+
     /// Versions of Find that are safe to use from outside the class
     bool Get(const COutPoint& outpoint, CMasternode& masternodeRet);
     bool Has(const COutPoint& outpoint);
@@ -173,7 +300,9 @@ public:
     /// Find a random entry
     masternode_info_t FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion = -1);
 
-    std::map<COutPoint, CMasternode> GetFullMasternodeMap() { return mapMasternodes; }
+    /// The current set of masternodes, with their fields as of the last
+    /// Check(). Readers share the snapshot without taking cs or copying.
+    list_snapshot_ptr_t GetListSnapshot() const { return std::atomic_load(&pListSnapshot); }
 
     bool GetMasternodeRanks(rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight = -1, int nMinProtocol = 0);
     bool GetMasternodeRank(const COutPoint &outpoint, int& nRankRet, int nBlockHeight = -1, int nMinProtocol = 0);
@@ -202,6 +331,8 @@ public:
     bool IsMnbRecoveryRequested(const uint256& hash) { return mMnbRecoveryRequests.count(hash); }
 
     void UpdateLastPaid(const CBlockIndex* pindex);
+    void BlockConnected(const CBlock& block, const CBlockIndex* pindex);
+    void BlockDisconnected(const CBlock& block);
 
     void AddDirtyGovernanceObjectHash(const uint256& nHash)
     {
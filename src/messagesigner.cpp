@@ -6,9 +6,85 @@
 #include <key_io.h>
 #include <hash.h>
 #include <validation.h> // For strMessageMagic
+#include <random.h>
+#include <script/sigcache.h> // For SignatureCacheHasher
 #include <tinyformat.h>
+#include <util.h>
 #include <utilstrencodings.h>
-#include <key_io.h>
+
+#include <cuckoocache.h>
+
+#include <atomic>
+
+#include <boost/thread.hpp>
+
+namespace {
+/**
+ * Cache of successfully verified (hash, signer, signature) triples, so that
+ * broadcasts and pings seen again on relay, in dseg replies or during
+ * recovery are not verified a second time.
+ */
+class CMessageSignatureCache
+{
+private:
+    //! Entries are SHA256(nonce || hash || signer || signature)
+    uint256 nonce;
+    CuckooCache::cache<uint256, SignatureCacheHasher> setValid;
+    boost::shared_mutex cs_msgsigcache;
+
+public:
+    std::atomic<uint64_t> nHits{0};
+    std::atomic<uint64_t> nMisses{0};
+
+    CMessageSignatureCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    // Signers are told apart by a type byte: 0 for a public key, 1 for the
+    // script of an address
+    void ComputeEntry(uint256& entry, const uint256& hash, unsigned char nSignerType, const unsigned char* pSigner, size_t nSignerSize, const std::vector<unsigned char>& vchSig)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(&nSignerType, 1).Write(pSigner, nSignerSize).Write(vchSig.data(), vchSig.size()).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_msgsigcache);
+        bool fHit = setValid.contains(entry, false);
+        ++(fHit ? nHits : nMisses);
+        return fHit;
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_msgsigcache);
+        setValid.insert(entry);
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_msgsigcache);
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CMessageSignatureCache messageSignatureCache;
+} // namespace
+
+void InitMessageSignatureCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxmsgsigcachesize", DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE)), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = messageSignatureCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for message signature cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+void GetMessageSignatureCacheStats(uint64_t& nHitsRet, uint64_t& nMissesRet)
+{
+    nHitsRet = messageSignatureCache.nHits;
+    nMissesRet = messageSignatureCache.nMisses;
+}
 
 bool CMessageSigner::GetKeysFromSecret(const std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {   
@@ -41,6 +117,15 @@ bool CMessageSigner::VerifyMessage(const CTxDestination &address, const std::vec
     return CHashSigner::VerifyHash(ss.GetHash(), address, vchSig, strErrorRet);
 }
 
+bool CMessageSigner::VerifyMessage(const CPubKey &pubkey, const std::vector<unsigned char>& vchSig, const std::string strMessage, std::string& strErrorRet)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << strMessageMagic;
+    ss << strMessage;
+
+    return CHashSigner::VerifyHash(ss.GetHash(), pubkey, vchSig, strErrorRet);
+}
+
 bool CHashSigner::SignHash(const uint256& hash, const CKey &key, CPubKey::InputScriptType scriptType, std::vector<unsigned char>& vchSigRet)
 {
     return key.SignCompact(hash, vchSigRet, scriptType);
@@ -48,6 +133,12 @@ bool CHashSigner::SignHash(const uint256& hash, const CKey &key, CPubKey::InputS
 
 bool CHashSigner::VerifyHash(const uint256& hash, const CTxDestination &address, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
 {
+    CScript scriptAddress = GetScriptForDestination(address);
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, 1, scriptAddress.data(), scriptAddress.size(), vchSig);
+    if (messageSignatureCache.Get(entry))
+        return true;
+
     CPubKey pubkeyFromSig;
     CPubKey::InputScriptType inputScriptType;
     if(!pubkeyFromSig.RecoverCompact(hash, vchSig, inputScriptType)) {
@@ -84,5 +175,24 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CTxDestination &address,
         return false;
     }
 
+    messageSignatureCache.Set(entry);
+    return true;
+}
+
+bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey &pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
+{
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, 0, pubkey.begin(), pubkey.size(), vchSig);
+    if (messageSignatureCache.Get(entry))
+        return true;
+
+    if (!pubkey.VerifyCompact(hash, vchSig)) {
+        strErrorRet = strprintf("Signature doesn't match public key: keyID=%s, hash=%s, vchSig=%s",
+                    pubkey.GetID().ToString(), hash.ToString(),
+                    EncodeBase64(vchSig.data(), vchSig.size()));
+        return false;
+    }
+
+    messageSignatureCache.Set(entry);
     return true;
 }
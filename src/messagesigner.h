@@ -8,6 +8,11 @@
 #include <key.h>
 #include <script/standard.h>
 
+//! Default for -maxmsgsigcachesize, in MiB. 32k entries hold the broadcasts
+//! and pings of a few thousand masternodes and stakenodes plus the votes
+//! relayed between two pings; nothing is allocated before init sizes it.
+static const unsigned int DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE = 1;
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
@@ -20,6 +25,9 @@ public:
     /// Verify the message signature, returns true if succcessful
     static bool VerifyMessage(const CTxDestination &address, const std::vector<unsigned char>& vchSig,
                               const std::string strMessage, std::string& strErrorRet);
+    /// Verify the message signature of a known public key, returns true if succcessful
+    static bool VerifyMessage(const CPubKey &pubkey, const std::vector<unsigned char>& vchSig,
+                              const std::string strMessage, std::string& strErrorRet);
 };
 
 /** Helper class for signing hashes and checking their signatures
@@ -31,6 +39,13 @@ public:
     static bool SignHash(const uint256& hash, const CKey &key, CPubKey::InputScriptType scriptType, std::vector<unsigned char>& vchSigRet);
     /// Verify the hash signature, returns true if succcessful
     static bool VerifyHash(const uint256& hash, const CTxDestination &address, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+    /// Verify the hash signature against a known public key instead of its address, returns true if succcessful
+    static bool VerifyHash(const uint256& hash, const CPubKey &pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
 };
 
+/** Size the cache of verified message signatures from -maxmsgsigcachesize */
+void InitMessageSignatureCache();
+/** Number of signature verifications answered by / missing the cache */
+void GetMessageSignatureCacheStats(uint64_t& nHitsRet, uint64_t& nMissesRet);
+
 #endif
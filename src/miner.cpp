@@ -724,11 +724,32 @@ void static GalactrumMiner(const CChainParams& chainparams, CConnman& connman,
             {
                 unsigned int nHashesDone = 0;
 
+                // Hash LYRA2RE2_MAX_LANES consecutive nonces per pass; the lanes share
+                // everything but the nonce, so the batch also shares blake256's first block.
+                unsigned char vchHeaders[LYRA2RE2_MAX_LANES][80];
+                const unsigned char* inputs[LYRA2RE2_MAX_LANES];
+                uint256 hashes[LYRA2RE2_MAX_LANES];
                 uint256 hash;
                 while (true)
                 {
-                    hash = pblock->GetHash();
-                    if (UintToArith256(hash) <= hashTarget)
+                    bool fFound = false;
+                    for (size_t i = 0; i < LYRA2RE2_MAX_LANES; i++) {
+                        uint32_t nNonceLane = pblock->nNonce + i;
+                        memcpy(vchHeaders[i], BEGIN(pblock->nVersion), 80);
+                        memcpy(vchHeaders[i] + 76, &nNonceLane, sizeof(nNonceLane));
+                        inputs[i] = vchHeaders[i];
+                    }
+                    lyra2re2_hash_lanes(inputs, 80, hashes, LYRA2RE2_MAX_LANES);
+                    for (size_t i = 0; i < LYRA2RE2_MAX_LANES; i++) {
+                        if (UintToArith256(hashes[i]) <= hashTarget) {
+                            pblock->nNonce += i;
+                            pblock->SetCachedHash(hashes[i]);
+                            hash = hashes[i];
+                            fFound = true;
+                            break;
+                        }
+                    }
+                    if (fFound)
                     {
                         // Found a solution
                         SetThreadPriority(THREAD_PRIORITY_NORMAL);
@@ -744,9 +765,9 @@ void static GalactrumMiner(const CChainParams& chainparams, CConnman& connman,
 
                         break;
                     }
-                    pblock->nNonce += 1;
-                    nHashesDone += 1;
-                    if ((pblock->nNonce & 0xFF) == 0)
+                    pblock->nNonce += LYRA2RE2_MAX_LANES;
+                    nHashesDone += LYRA2RE2_MAX_LANES;
+                    if ((pblock->nNonce & 0xFF) < LYRA2RE2_MAX_LANES)
                         break;
                 }
 
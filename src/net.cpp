@@ -713,6 +713,7 @@ void CNode::copyStats(CNodeStats &stats)
     {
         LOCK(cs_vRecv);
         X(mapRecvBytesPerMsgCmd);
+        X(mapRecvTimePerMsgCmd);
         X(nRecvBytes);
     }
     X(fWhitelisted);
@@ -565,6 +565,7 @@ public:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdSize mapRecvTimePerMsgCmd;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -697,6 +698,8 @@ protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    // microseconds spent processing received extension messages, by command
+    mapMsgCmdSize mapRecvTimePerMsgCmd;
 
 public:
     uint256 hashContinue;
@@ -881,6 +884,12 @@ public:
 
     void copyStats(CNodeStats &stats);
 
+    void AddRecvProcessingTime(const std::string& strCommand, int64_t nTimeMicros)
+    {
+        LOCK(cs_vRecv);
+        mapRecvTimePerMsgCmd[strCommand] += nTimeMicros;
+    }
+
     ServiceFlags GetLocalServices() const
     {
         return nLocalServices;
@@ -2942,13 +2942,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         // message would be undesirable as we transmit it ourselves.
     }
 
-    else {
+    else if (!net_processing_galactrum::ProcessExtension(pfrom, strCommand, vRecv, connman)) {
         const auto &allMessages = getAllNetMessageTypes();
-        if(std::find(std::begin(allMessages), std::end(allMessages), strCommand) != std::end(allMessages))
-        {
-            net_processing_galactrum::ProcessExtension(pfrom, strCommand, vRecv, connman);
-        }
-        else
+        if(std::find(std::begin(allMessages), std::end(allMessages), strCommand) == std::end(allMessages))
         {
             // Ignore unknown commands for extensibility
             LogPrint(BCLog::NET, "Unknown command \"%s\" from peer=%d\n", SanitizeString(strCommand), pfrom->GetId());
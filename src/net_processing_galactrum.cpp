@@ -14,6 +14,9 @@
 #include <stakenode/activestakenode.h>
 #include <instantx.h>
 #include <init.h>
+#include <scheduler.h>
+#include <list>
+#include <atomic>
 #include <boost/thread.hpp>
 
 namespace LegacyInvMsg {
@@ -80,13 +83,14 @@ static const MapSporkHandlers &GetMapGetDataHandlers()
                     });
         ADD_HANDLER(MSG_MASTERNODE_PAYMENT_BLOCK, {
                         BlockMap::iterator mi = mapBlockIndex.find(hash);
-                        LOCK(cs_mapMasternodeBlocks);
-                        if (mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.count(mi->second->nHeight)) {
-                            for(const CMasternodePayee& payee : mnpayments.mapMasternodeBlocks[mi->second->nHeight].vecPayees) {
+                        CMasternodeBlockPayees blockPayees;
+                        if (mi != mapBlockIndex.end() && mnpayments.GetBlockPayees(mi->second->nHeight, blockPayees)) {
+                            for(const CMasternodePayee& payee : blockPayees.vecPayees) {
                                 std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
                                 for(const uint256& hash : vecVoteHashes) {
-                                    if(mnpayments.HasVerifiedPaymentVote(hash)) {
-                                        return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, mnpayments.mapMasternodePaymentVotes[hash]);
+                                    CMasternodePaymentVote vote;
+                                    if(mnpayments.GetVerifiedPaymentVote(hash, vote)) {
+                                        return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, vote);
                                     }
                                 }
                             }
@@ -94,8 +98,9 @@ static const MapSporkHandlers &GetMapGetDataHandlers()
                         return {};
                     });
         ADD_HANDLER(MSG_MASTERNODE_PAYMENT_VOTE, {
-                        if(mnpayments.HasVerifiedPaymentVote(hash)) {
-                            return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, mnpayments.mapMasternodePaymentVotes[hash]);
+                        CMasternodePaymentVote vote;
+                        if(mnpayments.GetVerifiedPaymentVote(hash, vote)) {
+                            return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, vote);
                         }
                         return {};
                     });
@@ -178,85 +183,252 @@ bool net_processing_galactrum::ProcessGetData(CNode *pfrom, const Consensus::Par
     return false;
 }
 
-void net_processing_galactrum::ProcessExtension(CNode *pfrom, const std::string &strCommand, CDataStream &vRecv, CConnman *connman)
+namespace {
+
+using ExtensionMessageHandler = std::function<void(CNode*, const std::string&, CDataStream&, CConnman&)>;
+
+/** The manager handling one extension command, with totals over all peers */
+struct CExtensionMessageRoute
+{
+    ExtensionMessageHandler handler;
+    std::atomic<uint64_t> nMessages{0};
+    std::atomic<uint64_t> nBytes{0};
+    std::atomic<int64_t> nTimeMicros{0};
+};
+
+using MapExtensionMessageRoutes = std::map<std::string, CExtensionMessageRoute>;
+
+// Built once on first use and never modified afterwards, so lookups need no lock
+MapExtensionMessageRoutes& GetMapExtensionMessageRoutes()
 {
-    mnodeman.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-    mnpayments.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-    stakenodeman.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-    instantsend.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-    sporkManager.ProcessSpork(pfrom, strCommand, vRecv, connman);
-    masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
-    stakenodeSync.ProcessMessage(pfrom, strCommand, vRecv);
-    governance.ProcessMessage(pfrom, strCommand, vRecv, *connman);
+    static MapExtensionMessageRoutes routes = [] {
+        MapExtensionMessageRoutes routesRet;
+        auto addRoute = [&routesRet](std::initializer_list<const char*> commands, const ExtensionMessageHandler& handler) {
+            for (const char* command : commands) {
+                assert(!routesRet.count(command));
+                routesRet[command].handler = handler;
+            }
+        };
+
+        addRoute({NetMsgType::MNANNOUNCE, NetMsgType::MNPING, NetMsgType::DSEG, NetMsgType::MNLISTDIGEST, NetMsgType::MNVERIFY},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     mnodeman.ProcessMessage(pfrom, strCommand, vRecv, connman);
+                 });
+        addRoute({NetMsgType::MASTERNODEPAYMENTSYNC, NetMsgType::MASTERNODEPAYMENTVOTE},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     mnpayments.ProcessMessage(pfrom, strCommand, vRecv, connman);
+                 });
+        addRoute({NetMsgType::STAKENODEANNOUNCE, NetMsgType::STAKENODEPING, NetMsgType::STAKENODESEG, NetMsgType::STAKENODELISTDIGEST,
+                  NetMsgType::STAKENODEVERIFY},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     stakenodeman.ProcessMessage(pfrom, strCommand, vRecv, connman);
+                 });
+        addRoute({NetMsgType::TXLOCKVOTE},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     instantsend.ProcessMessage(pfrom, strCommand, vRecv, connman);
+                 });
+        addRoute({NetMsgType::SPORK, NetMsgType::GETSPORKS},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     sporkManager.ProcessSpork(pfrom, strCommand, vRecv, &connman);
+                 });
+        addRoute({NetMsgType::SYNCSTATUSCOUNT},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
+                 });
+        addRoute({NetMsgType::MERCHANTSYNCSTATUSCOUNT},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     stakenodeSync.ProcessMessage(pfrom, strCommand, vRecv);
+                 });
+        addRoute({NetMsgType::MNGOVERNANCESYNC, NetMsgType::MNGOVERNANCEOBJECT, NetMsgType::MNGOVERNANCEOBJECTVOTE},
+                 [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+                     governance.ProcessMessage(pfrom, strCommand, vRecv, connman);
+                 });
+
+        return routesRet;
+    }();
+
+    return routes;
 }
 
-void net_processing_galactrum::ThreadProcessExtensions(CConnman *pConnman)
+} // namespace
+
+bool net_processing_galactrum::ProcessExtension(CNode *pfrom, const std::string &strCommand, CDataStream &vRecv, CConnman *connman)
 {
-    if(fLiteMode) return; // disable all Galactrum specific functionality
+    auto &routes = GetMapExtensionMessageRoutes();
+    auto it = routes.find(strCommand);
+    if(it == std::end(routes)) return false; // e.g. PrivateSend messages, which no manager handles here
+
+    CExtensionMessageRoute &route = it->second;
+    // counted like the per peer received bytes, header included
+    uint64_t nBytes = vRecv.size() + CMessageHeader::HEADER_SIZE;
+
+    int64_t nTimeStart = GetTimeMicros();
+    route.handler(pfrom, strCommand, vRecv, *connman);
+    int64_t nTime = GetTimeMicros() - nTimeStart;
+
+    route.nMessages++;
+    route.nBytes += nBytes;
+    route.nTimeMicros += nTime;
+    pfrom->AddRecvProcessingTime(strCommand, nTime);
+    return true;
+}
+
+std::vector<net_processing_galactrum::ExtensionMessageStats> net_processing_galactrum::GetExtensionMessageStats()
+{
+    std::vector<ExtensionMessageStats> vStats;
+    for (const auto &routePair : GetMapExtensionMessageRoutes()) {
+        const CExtensionMessageRoute &route = routePair.second;
+        vStats.push_back(ExtensionMessageStats{routePair.first, route.nMessages, route.nBytes, route.nTimeMicros});
+    }
+    return vStats;
+}
+
+uint64_t net_processing_galactrum::GetExtensionMessageBytes(const std::vector<std::string>& vCommands)
+{
+    const auto& mapRoutes = GetMapExtensionMessageRoutes();
+    uint64_t nBytes = 0;
+    for (const std::string& strCommand : vCommands) {
+        auto it = mapRoutes.find(strCommand);
+        if (it != mapRoutes.end()) nBytes += it->second.nBytes;
+    }
+    return nBytes;
+}
+
+namespace {
+
+struct CExtensionTask
+{
+    std::string strName;
+    std::function<void()> func;
+    int64_t nIntervalMillis;
+    uint64_t nRuns;
+    int64_t nLastMicros;
+    int64_t nMaxMicros;
+    int64_t nTotalMicros;
+};
 
-    static bool fOneThread;
-    if(fOneThread) return;
-    fOneThread = true;
+CCriticalSection cs_extension_tasks;
+// tasks are only ever appended, so the scheduler can keep pointers to them
+std::list<CExtensionTask> listExtensionTasks;
 
-    // Make this thread recognisable as the PrivateSend thread
-    RenameThread("galactrum-ps");
+void RunExtensionTask(CScheduler* scheduler, CExtensionTask* task)
+{
+    if(ShutdownRequested()) return;
 
-    unsigned int nTick = 0;
+    int64_t nTimeStart = GetTimeMicros();
+    task->func();
+    int64_t nTime = GetTimeMicros() - nTimeStart;
 
-    auto &connman = *pConnman;
-    while (!ShutdownRequested())
     {
-        boost::this_thread::interruption_point();
-        MilliSleep(1000);
-
-        // try to sync from all available nodes, one step at a time
-        masternodeSync.ProcessTick(connman);
-        stakenodeSync.ProcessTick(connman);
-
-        if(!ShutdownRequested()) {
-
-            nTick++;
-
-            if(masternodeSync.IsBlockchainSynced()) {
-                // make sure to check all masternodes first
-                mnodeman.Check();
-
-                // check if we should activate or ping every few minutes,
-                // slightly postpone first run to give net thread a chance to connect to some peers
-                if(nTick % MASTERNODE_MIN_MNP_SECONDS == 15)
-                    activeMasternode.ManageState(connman);
-
-                if(nTick % 60 == 0) {
-                    mnodeman.ProcessMasternodeConnections(connman);
-                    mnodeman.CheckAndRemove(connman);
-                    mnpayments.CheckAndRemove();
-                    instantsend.CheckAndRemove();
-                }
-                if(fMasterNode && (nTick % (60 * 5) == 0)) {
-                    mnodeman.DoFullVerificationStep(connman);
-                }
-
-                if(nTick % (60 * 5) == 0) {
-                    governance.DoMaintenance(connman);
-                }
-            }
+        LOCK(cs_extension_tasks);
+        task->nRuns++;
+        task->nLastMicros = nTime;
+        task->nMaxMicros = std::max(task->nMaxMicros, nTime);
+        task->nTotalMicros += nTime;
+    }
+    LogPrint(BCLog::BENCH, "RunExtensionTask -- %s: %.2fms\n", task->strName, nTime * 0.001);
 
-            if(stakenodeSync.IsBlockchainSynced()) {
+    // reschedule only once done, so a slow run delays the next one instead of overlapping it
+    scheduler->scheduleFromNow(std::bind(&RunExtensionTask, scheduler, task), task->nIntervalMillis);
+}
 
-                stakenodeman.Check();
-                if(nTick % STAKENODE_MIN_MNP_SECONDS == 15)
-                    activeStakenode.ManageState(connman);
+} // namespace
 
-                if(nTick % 60 == 0) {
-                    stakenodeman.ProcessStakenodeConnections(connman);
-                    stakenodeman.CheckAndRemove(connman);
-                }
-                if(fStakeNode && (nTick % (60 * 5) == 0)) {
-                    stakenodeman.DoFullVerificationStep(connman);
-                }
-            }
-        }
+void net_processing_galactrum::AddExtensionTask(CScheduler& scheduler, const std::string& strName, int64_t nIntervalMillis,
+                                                int64_t nFirstRunMillis, std::function<void()> func)
+{
+    CExtensionTask* task;
+    {
+        LOCK(cs_extension_tasks);
+        listExtensionTasks.push_back(CExtensionTask{strName, func, nIntervalMillis, 0, 0, 0, 0});
+        task = &listExtensionTasks.back();
+    }
+    scheduler.scheduleFromNow(std::bind(&RunExtensionTask, &scheduler, task), nFirstRunMillis);
+}
+
+void net_processing_galactrum::StartExtensions(CScheduler& scheduler, CConnman *pConnman)
+{
+    if(fLiteMode) return; // disable all Galactrum specific functionality
+
+    static bool fStarted;
+    if(fStarted) return;
+    fStarted = true;
+
+    CConnman* connman = pConnman;
+
+    // try to sync from all available nodes, one step at a time
+    AddExtensionTask(scheduler, "mnsync", 1000, 1000, [connman] {
+        masternodeSync.ProcessTick(*connman);
+    });
+    AddExtensionTask(scheduler, "snsync", 1000, 1000, [connman] {
+        stakenodeSync.ProcessTick(*connman);
+    });
+
+    // check the masternodes that are due
+    AddExtensionTask(scheduler, "mncheck", 1000, 1000, [] {
+        if(masternodeSync.IsBlockchainSynced())
+            mnodeman.Check();
+    });
+    // check if we should activate or ping every few minutes,
+    // slightly postpone first run to give net thread a chance to connect to some peers
+    AddExtensionTask(scheduler, "mnstate", MASTERNODE_MIN_MNP_SECONDS * 1000, 15 * 1000, [connman] {
+        if(masternodeSync.IsBlockchainSynced())
+            activeMasternode.ManageState(*connman);
+    });
+    AddExtensionTask(scheduler, "mnodeman", 60 * 1000, 60 * 1000, [connman] {
+        if(!masternodeSync.IsBlockchainSynced()) return;
+        mnodeman.ProcessMasternodeConnections(*connman);
+        mnodeman.CheckAndRemove(*connman);
+    });
+    AddExtensionTask(scheduler, "mnpayments", 60 * 1000, 60 * 1000, [] {
+        if(masternodeSync.IsBlockchainSynced())
+            mnpayments.CheckAndRemove();
+    });
+    AddExtensionTask(scheduler, "instantsend", 60 * 1000, 60 * 1000, [] {
+        if(masternodeSync.IsBlockchainSynced())
+            instantsend.CheckAndRemove();
+    });
+    if(fMasterNode) {
+        AddExtensionTask(scheduler, "mnverify", 60 * 5 * 1000, 60 * 5 * 1000, [connman] {
+            if(masternodeSync.IsBlockchainSynced())
+                mnodeman.DoFullVerificationStep(*connman);
+        });
+    }
+    AddExtensionTask(scheduler, "governance", 60 * 5 * 1000, 60 * 5 * 1000, [connman] {
+        if(masternodeSync.IsBlockchainSynced())
+            governance.DoMaintenance(*connman);
+    });
+
+    AddExtensionTask(scheduler, "sncheck", 1000, 1000, [] {
+        if(stakenodeSync.IsBlockchainSynced())
+            stakenodeman.Check();
+    });
+    AddExtensionTask(scheduler, "snstate", STAKENODE_MIN_MNP_SECONDS * 1000, 15 * 1000, [connman] {
+        if(stakenodeSync.IsBlockchainSynced())
+            activeStakenode.ManageState(*connman);
+    });
+    AddExtensionTask(scheduler, "stakenodeman", 60 * 1000, 60 * 1000, [connman] {
+        if(!stakenodeSync.IsBlockchainSynced()) return;
+        stakenodeman.ProcessStakenodeConnections(*connman);
+        stakenodeman.CheckAndRemove(*connman);
+    });
+    if(fStakeNode) {
+        AddExtensionTask(scheduler, "snverify", 60 * 5 * 1000, 60 * 5 * 1000, [connman] {
+            if(stakenodeSync.IsBlockchainSynced())
+                stakenodeman.DoFullVerificationStep(*connman);
+        });
+    }
+}
+
+std::vector<net_processing_galactrum::ExtensionTaskStats> net_processing_galactrum::GetExtensionTaskStats()
+{
+    LOCK(cs_extension_tasks);
+    std::vector<ExtensionTaskStats> vStats;
+    for (const CExtensionTask& task : listExtensionTasks) {
+        vStats.push_back(ExtensionTaskStats{task.strName, task.nIntervalMillis, task.nRuns,
+                                            task.nLastMicros, task.nMaxMicros, task.nTotalMicros});
     }
+    return vStats;
 }
 
 
@@ -283,12 +455,12 @@ bool net_processing_galactrum::AlreadyHave(const CInv &inv)
         return mapSporks.count(inv.hash);
 
     case MSG_MASTERNODE_PAYMENT_VOTE:
-        return mnpayments.mapMasternodePaymentVotes.count(inv.hash);
+        return mnpayments.HasPaymentVote(inv.hash);
 
     case MSG_MASTERNODE_PAYMENT_BLOCK:
     {
         BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-        return mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.find(mi->second->nHeight) != mnpayments.mapMasternodeBlocks.end();
+        return mi != mapBlockIndex.end() && mnpayments.HasPaymentBlock(mi->second->nHeight);
     }
 
     case MSG_MASTERNODE_ANNOUNCE:
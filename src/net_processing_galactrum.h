@@ -3,11 +3,16 @@
 
 #include <chainparams.h>
 
+#include <functional>
+#include <string>
+#include <vector>
+
 class CNode;
 class CInv;
 class CConnman;
 class CNetMsgMaker;
 class CDataStream;
+class CScheduler;
 
 namespace net_processing_galactrum
 {
@@ -15,14 +20,56 @@ namespace net_processing_galactrum
 bool ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParams, CConnman* connman,
                     const CInv &inv);
 
-void ProcessExtension(CNode* pfrom, const std::string &strCommand, CDataStream& vRecv, CConnman *connman);
+/** Hand an extension message to the manager registered for its command,
+ *  returns false if no manager handles the command */
+bool ProcessExtension(CNode* pfrom, const std::string &strCommand, CDataStream& vRecv, CConnman *connman);
+
+/** Extension messages received and processed for one command since startup */
+struct ExtensionMessageStats
+{
+    std::string strCommand;
+    uint64_t nMessages;
+    uint64_t nBytes;
+    int64_t nTimeMicros;
+};
+
+/** Totals of every routed extension command */
+std::vector<ExtensionMessageStats> GetExtensionMessageStats();
+
+/** Bytes received so far in the given extension commands */
+uint64_t GetExtensionMessageBytes(const std::vector<std::string>& vCommands);
 
 bool AlreadyHave(const CInv &inv);
 
 bool TransformInvForLegacyVersion(CInv &inv, CNode *pfrom, bool fForSending);
 
-/** Run an instance of extension processor */
-void ThreadProcessExtensions(CConnman *pConnman);
+/** Number of threads servicing the extension task scheduler */
+static const int EXTENSION_SCHEDULER_THREADS = 2;
+
+/** Run times of one periodic extension task */
+struct ExtensionTaskStats
+{
+    std::string strName;
+    int64_t nIntervalMillis;
+    uint64_t nRuns;
+    int64_t nLastMicros;
+    int64_t nMaxMicros;
+    int64_t nTotalMicros;
+};
+
+/** Schedule the periodic extension tasks: list syncs, masternode and stakenode
+ *  checks and maintenance, payment votes, InstantSend and governance. Tasks of
+ *  different managers may run concurrently on a scheduler with several threads,
+ *  a task never overlaps with itself. */
+void StartExtensions(CScheduler& scheduler, CConnman *pConnman);
+
+/** Run func every nIntervalMillis, the first time after nFirstRunMillis, on the
+ *  extension scheduler along with the other extension tasks */
+void AddExtensionTask(CScheduler& scheduler, const std::string& strName, int64_t nIntervalMillis,
+                      int64_t nFirstRunMillis, std::function<void()> func);
+
+/** Timing of every scheduled extension task */
+std::vector<ExtensionTaskStats> GetExtensionTaskStats();
 }
 
 #endif // NET_PROCESSING_GALACTRUM_H
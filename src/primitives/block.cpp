@@ -10,15 +10,119 @@
 #include <utilstrencodings.h>
 #include <crypto/common.h>
 
+#include <string.h>
+
+CBlockHeaderHashMemo::CBlockHeaderHashMemo(const CBlockHeaderHashMemo& other)
+{
+    std::lock_guard<std::mutex> lock(other.cs);
+    fValid = other.fValid;
+    memcpy(header, other.header, HEADER_SIZE);
+    hash = other.hash;
+}
+
+CBlockHeaderHashMemo& CBlockHeaderHashMemo::operator=(const CBlockHeaderHashMemo& other)
+{
+    if (this == &other)
+        return *this;
+
+    CBlockHeaderHashMemo tmp(other);
+    std::lock_guard<std::mutex> lock(cs);
+    fValid = tmp.fValid;
+    memcpy(header, tmp.header, HEADER_SIZE);
+    hash = tmp.hash;
+    return *this;
+}
+
+bool CBlockHeaderHashMemo::Get(const unsigned char* pheader, uint256& hashOut) const
+{
+    std::lock_guard<std::mutex> lock(cs);
+    if (!fValid || memcmp(header, pheader, HEADER_SIZE) != 0)
+        return false;
+    hashOut = hash;
+    return true;
+}
+
+void CBlockHeaderHashMemo::Set(const unsigned char* pheader, const uint256& hashIn)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    memcpy(header, pheader, HEADER_SIZE);
+    hash = hashIn;
+    fValid = true;
+}
+
+void CBlockHeaderHashMemo::Clear()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    fValid = false;
+}
 
 uint256 CBlockHeader::GetHash() const
 {
+    uint256 hash;
+    if (hashMemo.Get((const unsigned char*)BEGIN(nVersion), hash))
+        return hash;
+
+    hash = ComputeHash();
+    hashMemo.Set((const unsigned char*)BEGIN(nVersion), hash);
+    return hash;
+}
+
+uint256 CBlockHeader::ComputeHash() const
+{
+    static_assert(sizeof(int32_t) + 2 * sizeof(uint256) + 3 * sizeof(uint32_t) == CBlockHeaderHashMemo::HEADER_SIZE,
+                  "unexpected block header size");
     return lyra2re2_hash(BEGIN(nVersion), END(nNonce));
 }
 
-uint256 CBlock::GetTPoSHash()
+void CBlockHeader::SetCachedHash(const uint256& hash) const
+{
+    hashMemo.Set((const unsigned char*)BEGIN(nVersion), hash);
+}
+
+void CBlockHeader::InvalidateCachedHash() const
+{
+    hashMemo.Clear();
+}
+
+void PrecomputeBlockHeaderHashes(const CBlockHeader* headers, size_t count)
+{
+    const unsigned char* inputs[LYRA2RE2_MAX_LANES];
+    const CBlockHeader* pending[LYRA2RE2_MAX_LANES];
+    uint256 hashes[LYRA2RE2_MAX_LANES];
+    size_t lanes = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const CBlockHeader& header = headers[i];
+        uint256 hash;
+        if (!header.hashMemo.Get((const unsigned char*)BEGIN(header.nVersion), hash)) {
+            inputs[lanes] = (const unsigned char*)BEGIN(header.nVersion);
+            pending[lanes] = &header;
+            lanes++;
+        }
+        if (lanes == LYRA2RE2_MAX_LANES || (i + 1 == count && lanes > 0)) {
+            lyra2re2_hash_lanes(inputs, CBlockHeaderHashMemo::HEADER_SIZE, hashes, lanes);
+            for (size_t j = 0; j < lanes; j++)
+                pending[j]->SetCachedHash(hashes[j]);
+            lanes = 0;
+        }
+    }
+}
+
+void PrecomputeBlockHeaderHashes(const std::vector<CBlockHeader>& headers)
+{
+    if (!headers.empty())
+        PrecomputeBlockHeaderHashes(headers.data(), headers.size());
+}
+
+uint256 CBlock::GetTPoSHash() const
 {
-    return lyra2re2_hash(BEGIN(nVersion), END(hashTPoSContractTx));
+    // The signed TPoS message is the serialized header immediately followed
+    // by the contract hash; build it explicitly rather than relying on the
+    // in-memory layout of CBlockHeader.
+    unsigned char buf[CBlockHeaderHashMemo::HEADER_SIZE + sizeof(hashTPoSContractTx)];
+    memcpy(buf, BEGIN(nVersion), CBlockHeaderHashMemo::HEADER_SIZE);
+    memcpy(buf + CBlockHeaderHashMemo::HEADER_SIZE, hashTPoSContractTx.begin(), hashTPoSContractTx.size());
+    return lyra2re2_hash(buf, buf + sizeof(buf));
 }
 
 bool CBlock::IsProofOfStake() const
@@ -10,6 +10,36 @@
 #include <serialize.h>
 #include <uint256.h>
 
+#include <mutex>
+
+/** Memory-only memo of a block header's proof-of-work hash.
+ *
+ * The memo remembers the serialized header it was computed from, so it never
+ * hands out a hash for header fields that have been modified since (the miner
+ * bumps nNonce and nTime in place). Copies carry the memo along, which lets a
+ * hash computed once follow the block through the validation pipeline.
+ */
+class CBlockHeaderHashMemo
+{
+public:
+    static const size_t HEADER_SIZE = 80;
+
+    CBlockHeaderHashMemo() : fValid(false) {}
+    CBlockHeaderHashMemo(const CBlockHeaderHashMemo& other);
+    CBlockHeaderHashMemo& operator=(const CBlockHeaderHashMemo& other);
+
+    /** Set hashOut and return true if a hash is memoized for exactly this header. */
+    bool Get(const unsigned char* pheader, uint256& hashOut) const;
+    void Set(const unsigned char* pheader, const uint256& hashIn);
+    void Clear();
+
+private:
+    mutable std::mutex cs;
+    bool fValid;
+    unsigned char header[HEADER_SIZE];
+    uint256 hash;
+};
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -28,6 +58,9 @@ public:
     uint32_t nBits;
     uint32_t nNonce;
 
+    // memory only
+    mutable CBlockHeaderHashMemo hashMemo;
+
     CBlockHeader()
     {
         SetNull();
@@ -53,6 +86,7 @@ public:
         nTime = 0;
         nBits = 0;
         nNonce = 0;
+        hashMemo.Clear();
     }
 
     bool IsNull() const
@@ -60,7 +94,14 @@ public:
         return (nBits == 0);
     }
 
+    /** Proof-of-work hash, computed once per distinct header contents. */
     uint256 GetHash() const;
+    /** Run the full Lyra2REv2 chain, bypassing the memo. */
+    uint256 ComputeHash() const;
+    /** Seed the memo with a hash known to belong to this header (e.g. from the block index). */
+    void SetCachedHash(const uint256& hash) const;
+    /** Drop the memo; the next GetHash() recomputes. */
+    void InvalidateCachedHash() const;
 
     int64_t GetBlockTime() const
     {
@@ -82,6 +123,7 @@ public:
     mutable std::vector<CTxOut> voutSuperblock; // superblock payment
     mutable bool fChecked;
     mutable CTransactionRef txTPoSContract;
+    mutable uint256 hashProofOfStake; // set by CheckBlock for proof-of-stake blocks
 
     CBlock()
     {
@@ -112,6 +154,7 @@ public:
         CBlockHeader::SetNull();
         vtx.clear();
         fChecked = false;
+        hashProofOfStake.SetNull();
         txoutMasternode = CTxOut();
         voutSuperblock.clear();
 		hashTPoSContractTx.SetNull();
@@ -127,10 +170,11 @@ public:
         block.nTime          = nTime;
         block.nBits          = nBits;
         block.nNonce         = nNonce;
+        block.hashMemo       = hashMemo;
         return block;
     }
 
-	uint256 GetTPoSHash();
+	uint256 GetTPoSHash() const;
     bool IsProofOfStake() const;
     bool IsTPoSBlock() const;
     bool IsProofOfWork() const;
@@ -138,6 +182,10 @@ public:
     std::string ToString() const;
 };
 
+/** Hash a batch of headers several lanes at a time and memoize the results. */
+void PrecomputeBlockHeaderHashes(const CBlockHeader* headers, size_t count);
+void PrecomputeBlockHeaderHashes(const std::vector<CBlockHeader>& headers);
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
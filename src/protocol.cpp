@@ -61,6 +61,7 @@ const char *DSSTATUSUPDATE="dssu";
 const char *DSTX="dstx";
 const char *DSQUEUE="dsq";
 const char *DSEG="dseg";
+const char *MNLISTDIGEST="mnld";
 const char *SYNCSTATUSCOUNT="ssc";
 const char *MNGOVERNANCESYNC="govsync";
 const char *MNGOVERNANCEOBJECT="govobj";
@@ -70,6 +71,7 @@ const char *STAKENODEVERIFY="mrnv";
 const char *STAKENODEANNOUNCE="mrnan";
 const char *STAKENODEPING="mrnp";
 const char *STAKENODESEG="mrnseg";
+const char *STAKENODELISTDIGEST="mrnld";
 const char *MERCHANTSYNCSTATUSCOUNT="mrnssc";
 } // namespace NetMsgType
 
@@ -120,7 +122,9 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::DSTX,
     NetMsgType::DSQUEUE,
     NetMsgType::DSEG,
+    NetMsgType::MNLISTDIGEST,
     NetMsgType::STAKENODESEG,
+    NetMsgType::STAKENODELISTDIGEST,
     NetMsgType::SYNCSTATUSCOUNT,
     NetMsgType::MERCHANTSYNCSTATUSCOUNT,
     NetMsgType::MNGOVERNANCESYNC,
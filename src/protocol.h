@@ -257,7 +257,9 @@ extern const char *DSSTATUSUPDATE;
 extern const char *DSTX;
 extern const char *DSQUEUE;
 extern const char *DSEG;
+extern const char *MNLISTDIGEST;
 extern const char *STAKENODESEG;
+extern const char *STAKENODELISTDIGEST;
 extern const char *SYNCSTATUSCOUNT;
 extern const char *MERCHANTSYNCSTATUSCOUNT;
 extern const char *MNGOVERNANCESYNC;
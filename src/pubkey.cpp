@@ -183,6 +183,29 @@ bool CPubKey::Verify(const uint256 &hash, const std::vector<unsigned char>& vchS
     return secp256k1_ecdsa_verify(secp256k1_context_verify, &sig, hash.begin(), &pubkey);
 }
 
+bool CPubKey::VerifyCompact(const uint256 &hash, const std::vector<unsigned char>& vchSig) const {
+    if (!IsValid() || vchSig.size() != COMPACT_SIGNATURE_SIZE)
+        return false;
+    // only p2pkh headers, with the compression of this key, recover to its id
+    if (vchSig[0] < 27 || vchSig[0] > 34 || (vchSig[0] >= 31) != IsCompressed())
+        return false;
+    /* Recover with the header's recid, as the key-id path does: the same r/s
+     * under any other recid recovers a different key and must not verify. */
+    int recid = (vchSig[0] - 27) & 3;
+    secp256k1_pubkey pubkey;
+    secp256k1_ecdsa_recoverable_signature sig;
+    if (!secp256k1_ecdsa_recoverable_signature_parse_compact(secp256k1_context_verify, &sig, &vchSig[1], recid)) {
+        return false;
+    }
+    if (!secp256k1_ecdsa_recover(secp256k1_context_verify, &pubkey, &sig, hash.begin())) {
+        return false;
+    }
+    unsigned char pub[PUBLIC_KEY_SIZE];
+    size_t publen = PUBLIC_KEY_SIZE;
+    secp256k1_ec_pubkey_serialize(secp256k1_context_verify, pub, &publen, &pubkey, IsCompressed() ? SECP256K1_EC_COMPRESSED : SECP256K1_EC_UNCOMPRESSED);
+    return publen == size() && memcmp(pub, begin(), publen) == 0;
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash, const std::vector<unsigned char>& vchSig, InputScriptType &inputScriptType) {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE)
         return false;
@@ -210,6 +210,14 @@ public:
     //! Recover a public key from a compact signature.
     bool RecoverCompact(const uint256& hash, const std::vector<unsigned char>& vchSig, InputScriptType &inputScriptType);
 
+    /**
+     * Verify a compact P2PKH signature (as made by CKey::SignCompact) against
+     * this key. The key is still recovered from the signature and compared,
+     * so this costs the same as RecoverCompact; it only saves hashing the
+     * result to a key id.
+     */
+    bool VerifyCompact(const uint256& hash, const std::vector<unsigned char>& vchSig) const;
+
     //! Turn this public key into an uncompressed public key.
     bool Decompress();
 
@@ -15,6 +15,8 @@
 #include <util.h>
 #include <utilstrencodings.h>
 #include <spork.h>
+#include <instantx.h>
+#include <net_processing_galactrum.h>
 #include <netmessagemaker.h>
 #ifdef ENABLE_WALLET
 #include <wallet/rpcwallet.h>
@@ -76,10 +78,95 @@ static UniValue spork(const JSONRPCRequest& request)
 
 }
 
+static UniValue getinstantsendinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getinstantsendinfo\n"
+            "Returns InstantSend vote processing and lock completion statistics.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"pendingvotes\": n,      (numeric) Lock votes waiting to be checked\n"
+            "  \"votethreads\": n,       (numeric) Threads checking lock votes\n"
+            "  \"locks\": n,             (numeric) Number of recent locks the latencies are taken from\n"
+            "  \"latency\": {            (json object) Time from the first request or vote for a tx to its lock, in milliseconds\n"
+            "    \"p50\": x.xxx,\n"
+            "    \"p90\": x.xxx,\n"
+            "    \"p99\": x.xxx,\n"
+            "    \"max\": x.xxx\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getinstantsendinfo", "")
+            + HelpExampleRpc("getinstantsendinfo", "")
+        );
+
+    std::vector<int64_t> vLatencies = instantsend.GetLockLatencies();
+    std::sort(vLatencies.begin(), vLatencies.end());
+    // nearest-rank percentile
+    auto percentile = [&vLatencies](int nPercent) -> double {
+        if (vLatencies.empty()) return 0;
+        size_t nRank = (vLatencies.size() * nPercent + 99) / 100;
+        return vLatencies[std::max<size_t>(nRank, 1) - 1] * 0.001;
+    };
+
+    UniValue latency(UniValue::VOBJ);
+    latency.push_back(Pair("p50", percentile(50)));
+    latency.push_back(Pair("p90", percentile(90)));
+    latency.push_back(Pair("p99", percentile(99)));
+    latency.push_back(Pair("max", percentile(100)));
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("pendingvotes", (uint64_t)instantsend.GetPendingTxLockVoteCount()));
+    obj.push_back(Pair("votethreads", nInstantSendVoteThreads));
+    obj.push_back(Pair("locks", (uint64_t)vLatencies.size()));
+    obj.push_back(Pair("latency", latency));
+    return obj;
+}
+
+static UniValue getextensiontasks(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getextensiontasks\n"
+            "Returns run times of the scheduled masternode, stakenode, InstantSend and governance tasks.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"xxxx\",      (string) Task name\n"
+            "    \"interval\": n,       (numeric) Time between the end of one run and the start of the next, in milliseconds\n"
+            "    \"runs\": n,           (numeric) Number of completed runs\n"
+            "    \"lastms\": x.xxx,     (numeric) Duration of the last run, in milliseconds\n"
+            "    \"avgms\": x.xxx,      (numeric) Average duration, in milliseconds\n"
+            "    \"maxms\": x.xxx       (numeric) Longest duration, in milliseconds\n"
+            "  },\n"
+            "  ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getextensiontasks", "")
+            + HelpExampleRpc("getextensiontasks", "")
+        );
+
+    UniValue ret(UniValue::VARR);
+    for (const auto& stats : net_processing_galactrum::GetExtensionTaskStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", stats.strName));
+        obj.push_back(Pair("interval", stats.nIntervalMillis));
+        obj.push_back(Pair("runs", stats.nRuns));
+        obj.push_back(Pair("lastms", stats.nLastMicros * 0.001));
+        obj.push_back(Pair("avgms", stats.nRuns ? stats.nTotalMicros * 0.001 / stats.nRuns : 0));
+        obj.push_back(Pair("maxms", stats.nMaxMicros * 0.001));
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
   { "galactrum",            "spork",          &spork,          {"mode"} },
+  { "galactrum",            "getinstantsendinfo", &getinstantsendinfo, {} },
+  { "galactrum",            "getextensiontasks", &getextensiontasks, {} },
 };
 
 void RegisterGalactrumMiscCommands(CRPCTable &tableRPC)
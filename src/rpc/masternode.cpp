@@ -170,9 +170,9 @@ static UniValue masternodelist(const JSONRPCRequest& request)
             obj.push_back(Pair(strOutpoint, s.first));
         }
     } else {
-        std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
-        for (auto& mnpair : mapMasternodes) {
-            CMasternode mn = mnpair.second;
+        CMasternodeMan::list_snapshot_ptr_t plist = mnodeman.GetListSnapshot();
+        for (const auto& mnpair : plist->mapMasternodes) {
+            const CMasternode& mn = mnpair.second;
             std::string strOutpoint = mnpair.first.ToString();
             if (strMode == "activeseconds") {
                 if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
@@ -265,6 +265,8 @@ UniValue mnsync(const JSONRPCRequest& request)
         objStatus.push_back(Pair("IsWinnersListSynced", masternodeSync.IsWinnersListSynced()));
         objStatus.push_back(Pair("IsSynced", masternodeSync.IsSynced()));
         objStatus.push_back(Pair("IsFailed", masternodeSync.IsFailed()));
+        objStatus.push_back(Pair("ListSyncTime", masternodeSync.GetListSyncTime()));
+        objStatus.push_back(Pair("ListSyncBytes", masternodeSync.GetListSyncBytes()));
         return objStatus;
     }
 
@@ -9,6 +9,8 @@
 #include <crypto/ripemd160.h>
 #include <init.h>
 #include <key_io.h>
+#include <memusage.h>
+#include <messagesigner.h>
 #include <validation.h>
 #include <httpserver.h>
 #include <net.h>
@@ -289,6 +291,21 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCBlockIndexMemoryInfo()
+{
+    LOCK(cs_main);
+    size_t nProofOfStake = 0;
+    for (const auto& entry : mapBlockIndex) {
+        if (entry.second->IsProofOfStake())
+            nProofOfStake++;
+    }
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(mapBlockIndex.size()));
+    obj.pushKV("proofofstake", uint64_t(nProofOfStake));
+    obj.pushKV("usage", uint64_t(memusage::DynamicUsage(mapBlockIndex) + mapBlockIndex.size() * memusage::MallocUsage(sizeof(CBlockIndex))));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -308,6 +325,16 @@ static std::string RPCMallocInfo()
 }
 #endif
 
+static UniValue RPCMessageSignatureCacheInfo()
+{
+    uint64_t nHits, nMisses;
+    GetMessageSignatureCacheStats(nHits, nMisses);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("hits", nHits);
+    obj.pushKV("misses", nMisses);
+    return obj;
+}
+
 static UniValue getmemoryinfo(const JSONRPCRequest& request)
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
@@ -330,6 +357,15 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"blockindex\": {           (json object) Information about the in-memory block index\n"
+            "    \"entries\": xxxxx,       (numeric) Number of block index entries\n"
+            "    \"proofofstake\": xxxxx,  (numeric) Number of entries carrying a proof-of-stake hash\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated bytes used by the block index\n"
+            "  },\n"
+            "  \"messagesigcache\": {      (json object) Cache of verified masternode/stakenode message signatures\n"
+            "    \"hits\": xxxxx,          (numeric) Verifications answered from the cache\n"
+            "    \"misses\": xxxxx,        (numeric) Verifications that had to check the signature\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -343,6 +379,8 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("blockindex", RPCBlockIndexMemoryInfo());
+        obj.pushKV("messagesigcache", RPCMessageSignatureCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -482,6 +520,8 @@ UniValue getstakingstatus(const JSONRPCRequest& request)
             "  \"enoughcoins\": true|false,        (boolean) if available coins are greater than reserve balance\n"
             "  \"mnsync\": true|false,             (boolean) if masternode data is synced\n"
             "  \"staking status\": true|false,     (boolean) if the wallet is staking\n"
+            "  \"stakethreads\": n,                (numeric) number of threads searching stake kernels\n"
+            "  \"kernelsearchrate\": x.xxx,        (numeric) kernel hashes per second of the last stake search\n"
             "  \"stake contract txid\" ,           (string)  if the wallet is staking with stake contract\n"
             "}\n"
             "\nExamples:\n" +
@@ -507,6 +547,11 @@ UniValue getstakingstatus(const JSONRPCRequest& request)
 
 
     obj.push_back(Pair("staking status", nStaking));
+    obj.push_back(Pair("stakethreads", nStakeThreads));
+    if (pwalletMain) {
+        int64_t nSearchMicros = pwalletMain->nStakeSearchMicros;
+        obj.push_back(Pair("kernelsearchrate", nSearchMicros > 0 ? pwalletMain->nStakeSearchAttempts * 1000000.0 / nSearchMicros : 0.0));
+    }
 
     bool isTPoS = false;
     uint256 txId;
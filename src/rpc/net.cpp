@@ -10,6 +10,7 @@
 #include <validation.h>
 #include <net.h>
 #include <net_processing.h>
+#include <net_processing_galactrum.h>
 #include <netbase.h>
 #include <policy/policy.h>
 #include <rpc/protocol.h>
@@ -109,6 +110,10 @@ static UniValue getpeerinfo(const JSONRPCRequest& request)
             "    \"bytesrecv_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes received aggregated by message type\n"
             "       ...\n"
+            "    },\n"
+            "    \"timerecv_per_msg\": {\n"
+            "       \"mnp\": n,               (numeric) The total microseconds spent processing received extension messages, by message type\n"
+            "       ...\n"
             "    }\n"
             "  }\n"
             "  ,...\n"
@@ -184,6 +189,12 @@ static UniValue getpeerinfo(const JSONRPCRequest& request)
         }
         obj.pushKV("bytesrecv_per_msg", recvPerMsgCmd);
 
+        UniValue recvTimePerMsgCmd(UniValue::VOBJ);
+        for (const mapMsgCmdSize::value_type &i : stats.mapRecvTimePerMsgCmd) {
+            recvTimePerMsgCmd.pushKV(i.first, i.second);
+        }
+        obj.pushKV("timerecv_per_msg", recvTimePerMsgCmd);
+
         ret.push_back(obj);
     }
 
@@ -367,6 +378,15 @@ static UniValue getnettotals(const JSONRPCRequest& request)
             "    \"serve_historical_blocks\": true|false,  (boolean) True if serving historical blocks\n"
             "    \"bytes_left_in_cycle\": t,               (numeric) Bytes left in current time cycle\n"
             "    \"time_left_in_cycle\": t                 (numeric) Seconds left in current time cycle\n"
+            "  },\n"
+            "  \"extension_msgs\":       (json object) Received extension messages by type\n"
+            "  {\n"
+            "    \"mnp\": {\n"
+            "      \"count\": n,                             (numeric) Messages processed\n"
+            "      \"bytes\": n,                             (numeric) Bytes received\n"
+            "      \"time\": n                               (numeric) Microseconds spent processing them\n"
+            "    },\n"
+            "    ...\n"
             "  }\n"
             "}\n"
             "\nExamples:\n"
@@ -389,6 +409,18 @@ static UniValue getnettotals(const JSONRPCRequest& request)
     outboundLimit.pushKV("bytes_left_in_cycle", g_connman->GetOutboundTargetBytesLeft());
     outboundLimit.pushKV("time_left_in_cycle", g_connman->GetMaxOutboundTimeLeftInCycle());
     obj.pushKV("uploadtarget", outboundLimit);
+
+    UniValue extensionMsgs(UniValue::VOBJ);
+    for (const auto& stats : net_processing_galactrum::GetExtensionMessageStats()) {
+        if (stats.nMessages == 0)
+            continue;
+        UniValue msgStats(UniValue::VOBJ);
+        msgStats.pushKV("count", stats.nMessages);
+        msgStats.pushKV("bytes", stats.nBytes);
+        msgStats.pushKV("time", stats.nTimeMicros);
+        extensionMsgs.pushKV(stats.strCommand, msgStats);
+    }
+    obj.pushKV("extension_msgs", extensionMsgs);
     return obj;
 }
 
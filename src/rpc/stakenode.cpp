@@ -44,6 +44,8 @@ static UniValue stakenodesync(const JSONRPCRequest& request)
         objStatus.push_back(Pair("IsMasternodeListSynced", stakenodeSync.IsStakenodeListSynced()));
         objStatus.push_back(Pair("IsSynced", stakenodeSync.IsSynced()));
         objStatus.push_back(Pair("IsFailed", stakenodeSync.IsFailed()));
+        objStatus.push_back(Pair("ListSyncTime", stakenodeSync.GetListSyncTime()));
+        objStatus.push_back(Pair("ListSyncBytes", stakenodeSync.GetListSyncBytes()));
         return objStatus;
     }
 
@@ -25,6 +25,7 @@ enum {
     SPORK_2_INSTANTSEND_ENABLED                            = SPORK_START,
     SPORK_3_INSTANTSEND_BLOCK_FILTERING                    = 10002,
     SPORK_5_INSTANTSEND_MAX_VALUE                          = 10004,
+    SPORK_6_NEW_SIGS                                       = 10005,
     SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT                 = 10007,
     SPORK_9_SUPERBLOCKS_ENABLED                            = 10008,
     SPORK_10_MASTERNODE_PAY_UPDATED_NODES                  = 10009,
@@ -10,6 +10,7 @@
 #include <stakenode/stakenode.h>
 #include <stakenode/stakenodeman.h>
 #include <netfulfilledman.h>
+#include <net_processing_galactrum.h>
 #include <spork.h>
 #include <ui_interface.h>
 #include <util.h>
@@ -30,6 +31,10 @@ void CStakenodeSync::Reset()
     nTimeAssetSyncStarted = GetTime();
     nTimeLastBumped = GetTime();
     nTimeLastFailure = 0;
+    nTimeListSyncStarted = 0;
+    nListSyncMillis = 0;
+    nListBytesAtStart = 0;
+    nListSyncBytes = 0;
 }
 
 void CStakenodeSync::BumpAssetLastTime(std::string strFuncName)
@@ -52,6 +57,11 @@ std::string CStakenodeSync::GetAssetName()
     }
 }
 
+static uint64_t GetListMessageBytes()
+{
+    return net_processing_galactrum::GetExtensionMessageBytes({NetMsgType::STAKENODEANNOUNCE, NetMsgType::STAKENODEPING, NetMsgType::MERCHANTSYNCSTATUSCOUNT});
+}
+
 void CStakenodeSync::SwitchToNextAsset(CConnman& connman)
 {
     switch(nRequestedStakenodeAssets)
@@ -69,9 +79,14 @@ void CStakenodeSync::SwitchToNextAsset(CConnman& connman)
             LogPrintf("CStakenodeSync::SwitchToNextAsset -- Completed %s in %llds\n", GetAssetName(), GetTime() - nTimeAssetSyncStarted);
             nRequestedStakenodeAssets = STAKENODE_SYNC_LIST;
             LogPrintf("CStakenodeSync::SwitchToNextAsset -- Starting %s\n", GetAssetName());
+            nTimeListSyncStarted = GetTimeMillis();
+            nListBytesAtStart = GetListMessageBytes();
             break;
         case(STAKENODE_SYNC_LIST):
             LogPrintf("CStakenodeSync::SwitchToNextAsset -- Completed %s in %llds\n", GetAssetName(), GetTime() - nTimeAssetSyncStarted);
+            nListSyncMillis = GetTimeMillis() - nTimeListSyncStarted;
+            nListSyncBytes = GetListMessageBytes() - nListBytesAtStart;
+            LogPrintf("CStakenodeSync::SwitchToNextAsset -- List sync received %d bytes\n", nListSyncBytes);
             nRequestedStakenodeAssets = STAKENODE_SYNC_FINISHED;
             uiInterface.NotifyAdditionalDataSyncProgressChanged(1);
             //try to activate our masternode if possible
@@ -93,6 +108,18 @@ void CStakenodeSync::SwitchToNextAsset(CConnman& connman)
     BumpAssetLastTime("CStakenodeSync::SwitchToNextAsset");
 }
 
+int64_t CStakenodeSync::GetListSyncTime()
+{
+    if(nRequestedStakenodeAssets == STAKENODE_SYNC_LIST) return GetTimeMillis() - nTimeListSyncStarted;
+    return nListSyncMillis;
+}
+
+uint64_t CStakenodeSync::GetListSyncBytes()
+{
+    if(nRequestedStakenodeAssets == STAKENODE_SYNC_LIST) return GetListMessageBytes() - nListBytesAtStart;
+    return nListSyncBytes;
+}
+
 std::string CStakenodeSync::GetSyncStatus()
 {
     switch (stakenodeSync.nRequestedStakenodeAssets) {
@@ -41,6 +41,12 @@ private:
     // ... or failed
     int64_t nTimeLastFailure;
 
+    // Duration of the stakenode list sync in milliseconds and the list messages received meanwhile
+    int64_t nTimeListSyncStarted;
+    int64_t nListSyncMillis;
+    uint64_t nListBytesAtStart;
+    uint64_t nListSyncBytes;
+
     void Fail();
     void ClearFulfilledRequests(CConnman& connman);
 
@@ -59,6 +65,9 @@ public:
     int GetAttempt() { return nRequestedStakenodeAttempt; }
     void BumpAssetLastTime(std::string strFuncName);
     int64_t GetAssetStartTime() { return nTimeAssetSyncStarted; }
+    /// Time and bytes the last (or current) list sync took
+    int64_t GetListSyncTime();
+    uint64_t GetListSyncBytes();
     std::string GetAssetName();
     std::string GetSyncStatus();
 
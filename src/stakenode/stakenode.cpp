@@ -11,6 +11,7 @@
 #include <stakenode/stakenode-sync.h>
 #include <messagesigner.h>
 #include <script/standard.h>
+#include <spork.h>
 #include <util.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
@@ -198,6 +199,24 @@ void CStakenode::Check(bool fForce)
     }
 }
 
+int64_t CStakenode::GetNextCheckTime() const
+{
+    LOCK(cs);
+    int64_t nNow = GetAdjustedTime();
+    int64_t nNextTime = 0;
+    auto fnDeadline = [&](int64_t nTime) {
+        if(nTime > nNow && (nNextTime == 0 || nTime < nNextTime)) nNextTime = nTime;
+    };
+    // the ping ages Check() compares with, see IsPingedWithin
+    if(lastPing != CStakenodePing()) {
+        fnDeadline(lastPing.sigTime + STAKENODE_MIN_MNP_SECONDS);
+        fnDeadline(lastPing.sigTime + STAKENODE_EXPIRATION_SECONDS);
+        fnDeadline(lastPing.sigTime + STAKENODE_NEW_START_REQUIRED_SECONDS);
+    }
+    fnDeadline(nTimeLastWatchdogVote + STAKENODE_WATCHDOG_MAX_SECONDS + 1);
+    return nNextTime;
+}
+
 bool CStakenode::IsValidNetAddr() const
 {
     return IsValidNetAddr(addr);
@@ -411,6 +430,7 @@ bool CStakenodeBroadcast::Update(CStakenode* pmn, int& nDos, CConnman& connman)
         LogPrintf("CStakenodeBroadcast::Update -- Got UPDATED Stakenode entry: addr=%s\n", addr.ToString());
         if(pmn->UpdateFromNewBroadcast(*this, connman)) {
             pmn->Check();
+            stakenodeman.ScheduleCheck(*pmn, true);
             Relay(connman);
         }
         stakenodeSync.BumpAssetLastTime("CStakenodeBroadcast::Update");
@@ -425,25 +445,54 @@ bool CStakenodeBroadcast::CheckStakenode(int &nDos)
     return CheckSignature(nDos);
 }
 
+uint256 CStakenodeBroadcast::GetSignatureHash() const
+{
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << addr;
+    ss << pubKeyStakenode;
+    ss << hashTPoSContractTx;
+    ss << sigTime;
+    ss << nProtocolVersion;
+    return ss.GetHash();
+}
+
+std::string CStakenodeBroadcast::GetStrMessage() const
+{
+    return addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
+            pubKeyStakenode.GetID().ToString() +
+            boost::lexical_cast<std::string>(nProtocolVersion);
+}
+
 bool CStakenodeBroadcast::Sign(const CKey& keyCollateralAddress)
 {
     std::string strError;
-    std::string strMessage;
 
     sigTime = GetAdjustedTime();
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-            pubKeyStakenode.GetID().ToString() +
-            boost::lexical_cast<std::string>(nProtocolVersion);
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyCollateralAddress, CPubKey::InputScriptType::SPENDP2PKH)) {
-        LogPrintf("CStakenodeBroadcast::Sign -- SignMessage() failed\n");
-        return false;
-    }
+        if(!CHashSigner::SignHash(hash, keyCollateralAddress, CPubKey::InputScriptType::SPENDP2PKH, vchSig)) {
+            LogPrintf("CStakenodeBroadcast::Sign -- SignHash() failed\n");
+            return false;
+        }
 
-    if(!CMessageSigner::VerifyMessage(pubKeyStakenode.GetID(), vchSig, strMessage, strError)) {
-        LogPrintf("CStakenodeBroadcast::Sign -- VerifyMessage() failed, error: %s\n", strError);
-        return false;
+        if(!CHashSigner::VerifyHash(hash, pubKeyStakenode, vchSig, strError)) {
+            LogPrintf("CStakenodeBroadcast::Sign -- VerifyHash() failed, error: %s\n", strError);
+            return false;
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::SignMessage(strMessage, vchSig, keyCollateralAddress, CPubKey::InputScriptType::SPENDP2PKH)) {
+            LogPrintf("CStakenodeBroadcast::Sign -- SignMessage() failed\n");
+            return false;
+        }
+
+        if(!CMessageSigner::VerifyMessage(pubKeyStakenode, vchSig, strMessage, strError)) {
+            LogPrintf("CStakenodeBroadcast::Sign -- VerifyMessage() failed, error: %s\n", strError);
+            return false;
+        }
     }
 
     return true;
@@ -451,20 +500,34 @@ bool CStakenodeBroadcast::Sign(const CKey& keyCollateralAddress)
 
 bool CStakenodeBroadcast::CheckSignature(int& nDos)
 {
-    std::string strMessage;
     std::string strError = "";
     nDos = 0;
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-            pubKeyStakenode.GetID().ToString() +
-            boost::lexical_cast<std::string>(nProtocolVersion);
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
 
-    LogPrint(BCLog::STAKENODE, "CStakenodeBroadcast::CheckSignature -- strMessage: %s  pubKeyStakenode address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyStakenode.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
+        if(!CHashSigner::VerifyHash(hash, pubKeyStakenode, vchSig, strError)) {
+            // could be a broadcast signed before the spork, try the old format
+            std::string strMessage = GetStrMessage();
 
-    if(!CMessageSigner::VerifyMessage(pubKeyStakenode.GetID(), vchSig, strMessage, strError)){
-        LogPrintf("CStakenodeBroadcast::CheckSignature -- Got bad Stakenode announce signature, error: %s\n", strError);
-        nDos = 100;
-        return false;
+            LogPrint(BCLog::STAKENODE, "CStakenodeBroadcast::CheckSignature -- strMessage: %s  pubKeyStakenode address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyStakenode.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
+
+            if(!CMessageSigner::VerifyMessage(pubKeyStakenode, vchSig, strMessage, strError)) {
+                LogPrintf("CStakenodeBroadcast::CheckSignature -- Got bad Stakenode announce signature, error: %s\n", strError);
+                nDos = 100;
+                return false;
+            }
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        LogPrint(BCLog::STAKENODE, "CStakenodeBroadcast::CheckSignature -- strMessage: %s  pubKeyStakenode address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyStakenode.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
+
+        if(!CMessageSigner::VerifyMessage(pubKeyStakenode, vchSig, strMessage, strError)){
+            LogPrintf("CStakenodeBroadcast::CheckSignature -- Got bad Stakenode announce signature, error: %s\n", strError);
+            nDos = 100;
+            return false;
+        }
     }
 
     return true;
@@ -495,23 +558,53 @@ CStakenodePing::CStakenodePing(const CPubKey &stakenodePubKey)
     sigTime = GetAdjustedTime();
 }
 
+uint256 CStakenodePing::GetSignatureHash() const
+{
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << stakenodePubKey;
+    ss << blockHash;
+    ss << sigTime;
+    ss << fSentinelIsCurrent;
+    ss << nSentinelVersion;
+    return ss.GetHash();
+}
+
+std::string CStakenodePing::GetStrMessage() const
+{
+    // TODO: add sentinel data
+    return stakenodePubKey.GetID().ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+}
+
 bool CStakenodePing::Sign(const CKey& keyStakenode, const CPubKey& pubKeyStakenode)
 {
     std::string strError;
-    std::string strMasterNodeSignMessage;
 
-    // TODO: add sentinel data
     sigTime = GetAdjustedTime();
-    std::string strMessage = stakenodePubKey.GetID().ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyStakenode, CPubKey::InputScriptType::SPENDP2PKH)) {
-        LogPrintf("CStakenodePing::Sign -- SignMessage() failed\n");
-        return false;
-    }
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
 
-    if(!CMessageSigner::VerifyMessage(pubKeyStakenode.GetID(), vchSig, strMessage, strError)) {
-        LogPrintf("CStakenodePing::Sign -- VerifyMessage() failed, error: %s\n", strError);
-        return false;
+        if(!CHashSigner::SignHash(hash, keyStakenode, CPubKey::InputScriptType::SPENDP2PKH, vchSig)) {
+            LogPrintf("CStakenodePing::Sign -- SignHash() failed\n");
+            return false;
+        }
+
+        if(!CHashSigner::VerifyHash(hash, pubKeyStakenode, vchSig, strError)) {
+            LogPrintf("CStakenodePing::Sign -- VerifyHash() failed, error: %s\n", strError);
+            return false;
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::SignMessage(strMessage, vchSig, keyStakenode, CPubKey::InputScriptType::SPENDP2PKH)) {
+            LogPrintf("CStakenodePing::Sign -- SignMessage() failed\n");
+            return false;
+        }
+
+        if(!CMessageSigner::VerifyMessage(pubKeyStakenode, vchSig, strMessage, strError)) {
+            LogPrintf("CStakenodePing::Sign -- VerifyMessage() failed, error: %s\n", strError);
+            return false;
+        }
     }
 
     return true;
@@ -519,17 +612,34 @@ bool CStakenodePing::Sign(const CKey& keyStakenode, const CPubKey& pubKeyStakeno
 
 bool CStakenodePing::CheckSignature(CPubKey& pubKeyStakenode, int &nDos)
 {
-    // TODO: add sentinel data
-    std::string strMessage = stakenodePubKey.GetID().ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
     std::string strError = "";
     nDos = 0;
 
-    if(!CMessageSigner::VerifyMessage(pubKeyStakenode.GetID(), vchSig, strMessage, strError)) {
-        LogPrintf("CStakenodePing::CheckSignature -- Got bad Stakenode ping signature, stakenode=%s, error: %s\n",
-                  stakenodePubKey.GetID().ToString(), strError);
-        nDos = 33;
-        return false;
+    if(sporkManager.IsSporkActive(Spork::SPORK_6_NEW_SIGS)) {
+        uint256 hash = GetSignatureHash();
+
+        if(!CHashSigner::VerifyHash(hash, pubKeyStakenode, vchSig, strError)) {
+            // could be a ping signed before the spork, try the old format
+            std::string strMessage = GetStrMessage();
+
+            if(!CMessageSigner::VerifyMessage(pubKeyStakenode, vchSig, strMessage, strError)) {
+                LogPrintf("CStakenodePing::CheckSignature -- Got bad Stakenode ping signature, stakenode=%s, error: %s\n",
+                          stakenodePubKey.GetID().ToString(), strError);
+                nDos = 33;
+                return false;
+            }
+        }
+    } else {
+        std::string strMessage = GetStrMessage();
+
+        if(!CMessageSigner::VerifyMessage(pubKeyStakenode, vchSig, strMessage, strError)) {
+            LogPrintf("CStakenodePing::CheckSignature -- Got bad Stakenode ping signature, stakenode=%s, error: %s\n",
+                      stakenodePubKey.GetID().ToString(), strError);
+            nDos = 33;
+            return false;
+        }
     }
+
     return true;
 }
 
@@ -644,6 +754,7 @@ bool CStakenodePing::CheckAndUpdate(CStakenode* pmn, bool fFromNewBroadcast, int
 
     // force update, ignoring cache
     pmn->Check(true);
+    stakenodeman.ScheduleCheck(*pmn);
     // relay ping for nodes in ENABLED/EXPIRED/WATCHDOG_EXPIRED state only, skip everyone else
     if (!pmn->IsEnabled() && !pmn->IsExpired() && !pmn->IsWatchdogExpired()) return false;
 
@@ -70,6 +70,10 @@ public:
     }
 
     bool IsExpired() const { return GetAdjustedTime() - sigTime > STAKENODE_NEW_START_REQUIRED_SECONDS; }
+    /// Hash of the serialized fields, signed once SPORK_6_NEW_SIGS is active
+    uint256 GetSignatureHash() const;
+    /// Text message signed before SPORK_6_NEW_SIGS
+    std::string GetStrMessage() const;
     bool Sign(const CKey& keyStakenode, const CPubKey& pubKeyStakenode);
     bool CheckSignature(CPubKey& pubKeyStakenode, int &nDos);
     bool SimpleCheck(int& nDos);
@@ -163,7 +167,10 @@ public:
         READWRITE(vchSig);
         READWRITE(sigTime);
         READWRITE(nLastDsq);
-        READWRITE(nTimeLastChecked);
+        if(!(s.GetType() & SER_GETHASH)) {
+            // bookkeeping of Check(), the cache journal does not count it as a change
+            READWRITE(nTimeLastChecked);
+        }
         READWRITE(nTimeLastWatchdogVote);
         READWRITE(nActiveState);
         READWRITE(nProtocolVersion);
@@ -188,6 +195,11 @@ public:
         return nTimeToCheckAt - lastPing.sigTime < nSeconds;
     }
 
+    /// Earliest adjusted time after now at which Check() can move this stakenode
+    /// to another state on its own (ping or watchdog vote getting too old);
+    /// 0 if only a new ping, broadcast or chain change can change it
+    int64_t GetNextCheckTime() const;
+
     bool IsEnabled() const { return nActiveState == STAKENODE_ENABLED; }
     bool IsPreEnabled() const { return nActiveState == STAKENODE_PRE_ENABLED; }
     bool IsPoSeBanned() const { return nActiveState == STAKENODE_POSE_BAN; }
@@ -311,6 +323,11 @@ public:
     bool Update(CStakenode* pmn, int& nDos, CConnman& connman);
     bool CheckStakenode(int &nDos);
 
+    /// Hash of the serialized fields, signed once SPORK_6_NEW_SIGS is active
+    uint256 GetSignatureHash() const;
+    /// Text message signed before SPORK_6_NEW_SIGS
+    std::string GetStrMessage() const;
+
     bool Sign(const CKey& keyCollateralAddress);
     bool CheckSignature(int& nDos);
     void Relay(CConnman& connman);
@@ -44,6 +44,8 @@ struct CompareByAddr
 CStakenodeMan::CStakenodeMan()
     : cs(),
       mapStakenodes(),
+      journalStakenodes("stakenodes"),
+      mapKeyIDIndex(),
       mAskedUsForStakenodeList(),
       mWeAskedForStakenodeList(),
       mWeAskedForStakenodeListEntry(),
@@ -65,6 +67,9 @@ bool CStakenodeMan::Add(CStakenode &mn)
 
     LogPrint(BCLog::STAKENODE, "CStakenodeMan::Add -- Adding new Stakenode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapStakenodes[mn.pubKeyStakenode] = mn;
+    MarkChanged(mn.pubKeyStakenode);
+    mapKeyIDIndex[mn.pubKeyStakenode.GetID()] = mn.pubKeyStakenode;
+    ScheduleCheck(mn, true);
 
     return true;
 }
@@ -106,6 +111,8 @@ bool CStakenodeMan::PoSeBan(const CPubKey &pubKeyStakenode)
         return false;
     }
     pmn->PoSeBan();
+    MarkChanged(pubKeyStakenode);
+    ScheduleCheck(*pmn, true);
 
     return true;
 }
@@ -117,11 +124,61 @@ void CStakenodeMan::Check()
 
     LogPrint(BCLog::STAKENODE, "CStakenodeMan::Check -- nLastWatchdogVoteTime=%d, IsWatchdogActive()=%d\n", nLastWatchdogVoteTime, IsWatchdogActive());
 
-    for (auto& mnpair : mapStakenodes) {
-        mnpair.second.Check();
+    // only visit the stakenodes whose state can have changed by now
+    int64_t nNow = GetAdjustedTime();
+    while (!setCheckQueue.empty() && setCheckQueue.begin()->first <= nNow) {
+        CPubKey pubKeyStakenode = setCheckQueue.begin()->second;
+        UnscheduleCheck(pubKeyStakenode);
+        CStakenode* pmn = Find(pubKeyStakenode);
+        if (!pmn) continue;
+        CheckEntry(*pmn, true);
+        ScheduleCheck(*pmn);
+    }
+}
+
+void CStakenodeMan::CheckEntry(CStakenode& mn, bool fForce)
+{
+    int nActiveStatePrev = mn.nActiveState;
+    int nPoSeBanScorePrev = mn.nPoSeBanScore;
+    int nPoSeBanHeightPrev = mn.nPoSeBanHeight;
+    mn.Check(fForce);
+    if (mn.nActiveState != nActiveStatePrev || mn.nPoSeBanScore != nPoSeBanScorePrev || mn.nPoSeBanHeight != nPoSeBanHeightPrev) {
+        MarkChanged(mn.pubKeyStakenode);
     }
 }
 
+void CStakenodeMan::ScheduleCheck(const CStakenode& mn, bool fNow)
+{
+    LOCK(cs);
+    UnscheduleCheck(mn.pubKeyStakenode);
+
+    if(!fNow && mn.IsPoSeBanned()) {
+        // a ban ends at a height, UpdatedBlockTip moves it back in time
+        setCheckQueueBanned.emplace(mn.nPoSeBanHeight, mn.pubKeyStakenode);
+        mapCheckScheduled.emplace(mn.pubKeyStakenode, std::make_pair(true, (int64_t)mn.nPoSeBanHeight));
+        return;
+    }
+
+    int64_t nTime = fNow ? GetAdjustedTime() : mn.GetNextCheckTime();
+    // nothing to wait for, the next ping or broadcast or CheckAndRemove checks it
+    if(nTime == 0) return;
+    setCheckQueue.emplace(nTime, mn.pubKeyStakenode);
+    mapCheckScheduled.emplace(mn.pubKeyStakenode, std::make_pair(false, nTime));
+}
+
+void CStakenodeMan::UnscheduleCheck(const CPubKey& pubKeyStakenode)
+{
+    LOCK(cs);
+    auto it = mapCheckScheduled.find(pubKeyStakenode);
+    if(it == mapCheckScheduled.end()) return;
+    if(it->second.first) {
+        setCheckQueueBanned.erase(std::make_pair(it->second.second, pubKeyStakenode));
+    } else {
+        setCheckQueue.erase(std::make_pair(it->second.second, pubKeyStakenode));
+    }
+    mapCheckScheduled.erase(it);
+}
+
 void CStakenodeMan::CheckAndRemove(CConnman& connman)
 {
     if(!stakenodeSync.IsStakenodeListSynced()) return;
@@ -132,8 +189,12 @@ void CStakenodeMan::CheckAndRemove(CConnman& connman)
         // in CheckMnbAndUpdateStakenodeList()
         LOCK2(cs_main, cs);
 
-        Check();
-
+        // A new minimum protocol or the end of the list sync have no deadline
+        // to queue a check at, catch them on this pass over the whole list instead
+        for (auto& mnpair : mapStakenodes) {
+            CheckEntry(mnpair.second);
+            ScheduleCheck(mnpair.second);
+        }
 
 
         // Remove spent stakenodes, prepare structures and make requests to reasure the state of inactive ones
@@ -152,6 +213,9 @@ void CStakenodeMan::CheckAndRemove(CConnman& connman)
                 mWeAskedForStakenodeListEntry.erase(it->first);
 
                 // and finally remove it from the list
+                mapKeyIDIndex.erase(it->first.GetID());
+                UnscheduleCheck(it->first);
+                MarkChanged(it->first);
                 mapStakenodes.erase(it++);
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
@@ -282,6 +346,11 @@ void CStakenodeMan::Clear()
 {
     LOCK(cs);
     mapStakenodes.clear();
+    journalStakenodes.MarkAllDirty();
+    mapKeyIDIndex.clear();
+    setCheckQueue.clear();
+    setCheckQueueBanned.clear();
+    mapCheckScheduled.clear();
     mAskedUsForStakenodeList.clear();
     mWeAskedForStakenodeList.clear();
     mWeAskedForStakenodeListEntry.clear();
@@ -291,6 +360,57 @@ void CStakenodeMan::Clear()
     nLastWatchdogVoteTime = 0;
 }
 
+void CStakenodeMan::RebuildIndexes()
+{
+    LOCK(cs);
+    mapKeyIDIndex.clear();
+    setCheckQueue.clear();
+    setCheckQueueBanned.clear();
+    mapCheckScheduled.clear();
+    // states read from disk may be stale, check everything once
+    for (const auto& mnpair : mapStakenodes) {
+        mapKeyIDIndex.emplace(mnpair.first.GetID(), mnpair.first);
+        ScheduleCheck(mnpair.second, true);
+    }
+}
+
+void CStakenodeMan::SetJournalBaseline()
+{
+    LOCK(cs);
+    journalStakenodes.SetBaseline(mapStakenodes);
+}
+
+int CStakenodeMan::WriteJournal(CCacheJournalDB& db, bool fSync)
+{
+    CDBBatch batch(db);
+    int nRecords;
+    {
+        LOCK(cs);
+        nRecords = journalStakenodes.WriteChanges(batch, mapStakenodes);
+    }
+    bool fWritten = db.WriteBatch(batch, fSync);
+    LOCK(cs);
+    if(!fWritten) {
+        journalStakenodes.Abort();
+        return -1;
+    }
+    journalStakenodes.Commit();
+    return nRecords;
+}
+
+bool CStakenodeMan::ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    LOCK(cs);
+    if(!journalStakenodes.Replay(db, hashSnapshot, mapStakenodes)) return false;
+    RebuildIndexes();
+    return true;
+}
+
+void CStakenodeMan::ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot)
+{
+    journalStakenodes.Reset(batch, db, hashSnapshot);
+}
+
 int CStakenodeMan::CountStakenodes(int nProtocolVersion) const
 {
     LOCK(cs);
@@ -350,13 +470,94 @@ void CStakenodeMan::DsegUpdate(CNode* pnode, CConnman& connman)
         }
     }
 
-    connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::STAKENODESEG, CPubKey()));
+    if(!mapStakenodes.empty() && pnode->nVersion >= LIST_DIGEST_VERSION) {
+        // we have a list already (e.g. from the cache file), only ask for the buckets that differ
+        connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::STAKENODELISTDIGEST, GetListDigests()));
+    } else {
+        connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::STAKENODESEG, CPubKey()));
+    }
     int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
     mWeAskedForStakenodeList[pnode->addr] = askAgain;
 
     LogPrint(BCLog::STAKENODE, "CStakenodeMan::DsegUpdate -- asked %s for the list\n", pnode->addr.ToString());
 }
 
+bool CStakenodeMan::AllowListRequest(CNode* pfrom, const std::string& strCommand)
+{
+    LOCK(cs);
+
+    //local network
+    bool isLocal = (pfrom->addr.IsRFC1918() || pfrom->addr.IsLocal());
+
+    if(!isLocal && Params().NetworkIDString() == CBaseChainParams::MAIN) {
+        std::map<CNetAddr, int64_t>::iterator it = mAskedUsForStakenodeList.find(pfrom->addr);
+        if (it != mAskedUsForStakenodeList.end() && it->second > GetTime()) {
+            Misbehaving(pfrom->GetId(), 34);
+            LogPrintf("%s -- peer already asked me for the list, peer=%d\n", strCommand, pfrom->GetId());
+            return false;
+        }
+        int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
+        mAskedUsForStakenodeList[pfrom->addr] = askAgain;
+    }
+    return true;
+}
+
+bool CStakenodeMan::IsRelayedInList(const CStakenode& mn)
+{
+    if (mn.addr.IsRFC1918() || mn.addr.IsLocal()) return false; // do not send local network stakenode
+    if (mn.IsUpdateRequired()) return false; // do not send outdated stakenodes
+    return true;
+}
+
+void CStakenodeMan::PushListEntryInvs(CNode* pfrom, const CStakenode& mn)
+{
+    LOCK(cs);
+
+    CStakenodeBroadcast mnb = CStakenodeBroadcast(mn);
+    LogPrint(BCLog::STAKENODE, "CStakenodeMan::PushListEntryInvs -- Sending Stakenode entry: stakenode=%s  addr=%s\n",
+             mnb.pubKeyStakenode.GetID().ToString(), mnb.addr.ToString());
+    CStakenodePing mnp = mn.lastPing;
+    uint256 hashMNB = mnb.GetHash();
+    uint256 hashMNP = mnp.GetHash();
+    pfrom->PushInventory(CInv(MSG_STAKENODE_ANNOUNCE, hashMNB));
+    pfrom->PushInventory(CInv(MSG_STAKENODE_PING, hashMNP));
+
+    mapSeenStakenodeBroadcast.insert(std::make_pair(hashMNB, std::make_pair(GetTime(), mnb)));
+    mapSeenStakenodePing.insert(std::make_pair(hashMNP, mnp));
+}
+
+void CStakenodeMan::PushListEntryPingInv(CNode* pfrom, const CStakenode& mn)
+{
+    LOCK(cs);
+
+    CStakenodePing mnp = mn.lastPing;
+    uint256 hashMNP = mnp.GetHash();
+    pfrom->PushInventory(CInv(MSG_STAKENODE_PING, hashMNP));
+
+    mapSeenStakenodePing.insert(std::make_pair(hashMNP, mnp));
+}
+
+std::vector<uint256> CStakenodeMan::GetListDigests()
+{
+    LOCK(cs);
+
+    // entries come in key order, so both sides hash each bucket in the same order
+    std::vector<CHashWriter> vecWriters(LIST_DIGEST_BUCKETS, CHashWriter(SER_GETHASH, PROTOCOL_VERSION));
+    for (const auto& mnpair : mapStakenodes) {
+        const CStakenode& mn = mnpair.second;
+        if (!IsRelayedInList(mn)) continue;
+        // the fields of the broadcast hash, pings are sent for every bucket
+        vecWriters[GetListDigestBucket(mnpair.first)] << mn.pubKeyStakenode << mn.hashTPoSContractTx << mn.sigTime;
+    }
+
+    std::vector<uint256> vecDigests;
+    vecDigests.reserve(LIST_DIGEST_BUCKETS);
+    for (CHashWriter& writer : vecWriters) {
+        vecDigests.push_back(writer.GetHash());
+    }
+    return vecDigests;
+}
+
 CStakenode* CStakenodeMan::Find(const CPubKey &pubKeyStakenode)
 {
     LOCK(cs);
@@ -368,14 +569,11 @@ bool CStakenodeMan::Get(const CKeyID &pubKeyID, CStakenode& stakenodeRet)
 {
     // Theses mutexes are recursive so double locking by the same thread is safe.
     LOCK(cs);
-    for (auto& mnpair : mapStakenodes) {
-        CKeyID keyID = mnpair.second.pubKeyStakenode.GetID();
-        if (keyID == pubKeyID) {
-            stakenodeRet = mnpair.second;
-            return true;
-        }
+    auto itIndex = mapKeyIDIndex.find(pubKeyID);
+    if (itIndex == mapKeyIDIndex.end()) {
+        return false;
     }
-    return false;
+    return Get(itIndex->second, stakenodeRet);
 }
 
 bool CStakenodeMan::Get(const CPubKey &pubKeyStakenode, CStakenode &stakenodeRet)
@@ -404,27 +602,23 @@ bool CStakenodeMan::GetStakenodeInfo(const CPubKey& pubKeyStakenode, stakenode_i
 bool CStakenodeMan::GetStakenodeInfo(const CKeyID &pubKeyStakenode, stakenode_info_t &mnInfoRet)
 {
     LOCK(cs);
-    for (auto& mnpair : mapStakenodes) {
-        CKeyID keyID = mnpair.second.pubKeyStakenode.GetID();
-        if (keyID == pubKeyStakenode) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
-        }
+    auto itIndex = mapKeyIDIndex.find(pubKeyStakenode);
+    if (itIndex == mapKeyIDIndex.end()) {
+        return false;
     }
-    return false;
+    return GetStakenodeInfo(itIndex->second, mnInfoRet);
 }
 
 bool CStakenodeMan::GetStakenodeInfo(const CScript& payee, stakenode_info_t& mnInfoRet)
 {
-    LOCK(cs);
-    for (auto& mnpair : mapStakenodes) {
-        CScript scriptCollateralAddress = GetScriptForDestination(mnpair.second.pubKeyStakenode.GetID());
-        if (scriptCollateralAddress == payee) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
-        }
+    // stakenodes are paid to the key id of their stakenode key, so only
+    // pay-to-pubkey-hash scripts can match
+    CTxDestination dest;
+    const CKeyID* keyID;
+    if (!ExtractDestination(payee, dest) || !(keyID = boost::get<CKeyID>(&dest))) {
+        return false;
     }
-    return false;
+    return GetStakenodeInfo(*keyID, mnInfoRet);
 }
 
 bool CStakenodeMan::Has(const CPubKey &pubKeyStakenode)
@@ -532,7 +726,10 @@ void CStakenodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         if(pmn && pmn->IsExpired()) return;
 
         int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        bool fUpdated = mnp.CheckAndUpdate(pmn, false, nDos, connman);
+        // a rejected ping can still have checked the stakenode
+        if(pmn) MarkChanged(pmn->pubKeyStakenode);
+        if(fUpdated) return;
 
         if(nDos > 0) {
             // if anything significant failed, mark that node
@@ -560,40 +757,17 @@ void CStakenodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         LOCK(cs);
 
         if(!pubKeyStakenode.IsValid()) { //only should ask for this once
-            //local network
-            bool isLocal = (pfrom->addr.IsRFC1918() || pfrom->addr.IsLocal());
-
-            if(!isLocal && Params().NetworkIDString() == CBaseChainParams::MAIN) {
-                std::map<CNetAddr, int64_t>::iterator it = mAskedUsForStakenodeList.find(pfrom->addr);
-                if (it != mAskedUsForStakenodeList.end() && it->second > GetTime()) {
-                    Misbehaving(pfrom->GetId(), 34);
-                    LogPrintf("STAKENODESEG -- peer already asked me for the list, peer=%d\n", pfrom->GetId());
-                    return;
-                }
-                int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
-                mAskedUsForStakenodeList[pfrom->addr] = askAgain;
-            }
+            if (!AllowListRequest(pfrom, "STAKENODESEG")) return;
         } //else, asking for a specific node which is ok
 
         int nInvCount = 0;
 
         for (auto& mnpair : mapStakenodes) {
             if (pubKeyStakenode.IsValid() && pubKeyStakenode != mnpair.second.pubKeyStakenode) continue; // asked for specific vin but we are not there yet
-            if (mnpair.second.addr.IsRFC1918() || mnpair.second.addr.IsLocal()) continue; // do not send local network stakenode
-            if (mnpair.second.IsUpdateRequired()) continue; // do not send outdated stakenodes
-
-            CStakenodeBroadcast mnb = CStakenodeBroadcast(mnpair.second);
-            LogPrint(BCLog::STAKENODE, "STAKENODESEG -- Sending Stakenode entry: stakenode=%s  addr=%s\n",
-                     mnb.pubKeyStakenode.GetID().ToString(), mnb.addr.ToString());
-            CStakenodePing mnp = mnpair.second.lastPing;
-            uint256 hashMNB = mnb.GetHash();
-            uint256 hashMNP = mnp.GetHash();
-            pfrom->PushInventory(CInv(MSG_STAKENODE_ANNOUNCE, hashMNB));
-            pfrom->PushInventory(CInv(MSG_STAKENODE_PING, hashMNP));
-            nInvCount++;
+            if (!IsRelayedInList(mnpair.second)) continue;
 
-            mapSeenStakenodeBroadcast.insert(std::make_pair(hashMNB, std::make_pair(GetTime(), mnb)));
-            mapSeenStakenodePing.insert(std::make_pair(hashMNP, mnp));
+            PushListEntryInvs(pfrom, mnpair.second);
+            nInvCount++;
 
             if (pubKeyStakenode == mnpair.first) {
                 LogPrintf("STAKENODESEG -- Sent 1 Stakenode inv to peer %d\n", pfrom->GetId());
@@ -610,6 +784,49 @@ void CStakenodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         // smth weird happen - someone asked us for vin we have no idea about?
         LogPrint(BCLog::STAKENODE, "STAKENODESEG -- No invs sent to peer %d\n", pfrom->GetId());
 
+    } else if (strCommand == NetMsgType::STAKENODELISTDIGEST) { //Get the Stakenode list entries in the buckets that differ from ours
+        if (!stakenodeSync.IsSynced()) return;
+
+        std::vector<uint256> vecDigests;
+        vRecv >> vecDigests;
+
+        if (vecDigests.size() != LIST_DIGEST_BUCKETS) {
+            LogPrintf("STAKENODELISTDIGEST -- invalid number of buckets %d, peer=%d\n", vecDigests.size(), pfrom->GetId());
+            Misbehaving(pfrom->GetId(), 20);
+            return;
+        }
+
+        LOCK(cs);
+
+        if (!AllowListRequest(pfrom, "STAKENODELISTDIGEST")) return;
+
+        std::vector<uint256> vecOurDigests = GetListDigests();
+        int nInvCount = 0;
+        int nBucketsDiffer = 0;
+        for (int i = 0; i < LIST_DIGEST_BUCKETS; i++) {
+            if (vecDigests[i] != vecOurDigests[i]) nBucketsDiffer++;
+        }
+
+        int nPingCount = 0;
+        for (auto& mnpair : mapStakenodes) {
+            if (!IsRelayedInList(mnpair.second)) continue;
+
+            int nBucket = GetListDigestBucket(mnpair.first);
+            if (vecDigests[nBucket] == vecOurDigests[nBucket]) {
+                // the peer has this entry, but its ping could be stale
+                PushListEntryPingInv(pfrom, mnpair.second);
+                nPingCount++;
+                continue;
+            }
+
+            PushListEntryInvs(pfrom, mnpair.second);
+            nInvCount++;
+        }
+
+        connman.PushMessage(pfrom, CNetMsgMaker(pfrom->GetSendVersion()).Make(
+                                NetMsgType::MERCHANTSYNCSTATUSCOUNT, STAKENODE_SYNC_LIST, nInvCount));
+        LogPrint(BCLog::STAKENODE, "STAKENODELISTDIGEST -- Sent %d Stakenode invs from %d differing buckets and %d ping invs to peer %d\n", nInvCount, nBucketsDiffer, nPingCount, pfrom->GetId());
+
     } else if (strCommand == NetMsgType::STAKENODEVERIFY) { // Stakenode Verify
 
         // Need LOCK2 here to ensure consistent locking order because the all functions below call GetBlockHash which locks cs_main
@@ -766,6 +983,8 @@ void CStakenodeMan::CheckSameAddr()
         LogPrintf("CStakenodeMan::CheckSameAddr -- increasing PoSe ban score for stakenode %s\n",
                   pmn->pubKeyStakenode.GetID().ToString());
         pmn->IncreasePoSeBanScore();
+        MarkChanged(pmn->pubKeyStakenode);
+        ScheduleCheck(*pmn, true);
     }
 }
 
@@ -824,7 +1043,7 @@ void CStakenodeMan::SendVerifyReply(CNode* pnode, CStakenodeVerification& mnv, C
 
     std::string strError;
 
-    if(!CMessageSigner::VerifyMessage(activeStakenode.pubKeyStakenode.GetID(), mnv.vchSig1, strMessage, strError)) {
+    if(!CMessageSigner::VerifyMessage(activeStakenode.pubKeyStakenode, mnv.vchSig1, strMessage, strError)) {
         LogPrintf("StakenodeMan::SendVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
         return;
     }
@@ -884,11 +1103,12 @@ void CStakenodeMan::ProcessVerifyReply(CNode* pnode, CStakenodeVerification& mnv
         std::string strMessage1 = strprintf("%s%d%s", pnode->addr.ToString(false), mnv.nonce, blockHash.ToString());
         for (auto& mnpair : mapStakenodes) {
             if(CAddress(mnpair.second.addr, NODE_NETWORK) == pnode->addr) {
-                if(CMessageSigner::VerifyMessage(mnpair.second.pubKeyStakenode.GetID(), mnv.vchSig1, strMessage1, strError)) {
+                if(CMessageSigner::VerifyMessage(mnpair.second.pubKeyStakenode, mnv.vchSig1, strMessage1, strError)) {
                     // found it!
                     prealStakenode = &mnpair.second;
                     if(!mnpair.second.IsPoSeVerified()) {
                         mnpair.second.DecreasePoSeBanScore();
+                        MarkChanged(mnpair.first);
                     }
                     netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::STAKENODEVERIFY)+"-done");
 
@@ -908,7 +1128,7 @@ void CStakenodeMan::ProcessVerifyReply(CNode* pnode, CStakenodeVerification& mnv
 
                     std::string strError;
 
-                    if(!CMessageSigner::VerifyMessage(activeStakenode.pubKeyStakenode.GetID(), mnv.vchSig2, strMessage2, strError)) {
+                    if(!CMessageSigner::VerifyMessage(activeStakenode.pubKeyStakenode, mnv.vchSig2, strMessage2, strError)) {
                         LogPrintf("StakenodeMan::ProcessVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
                         return;
                     }
@@ -935,6 +1155,8 @@ void CStakenodeMan::ProcessVerifyReply(CNode* pnode, CStakenodeVerification& mnv
         // increase ban score for everyone else
         for(CStakenode* pmn : vpStakenodesToBan) {
             pmn->IncreasePoSeBanScore();
+            MarkChanged(pmn->pubKeyStakenode);
+            ScheduleCheck(*pmn, true);
             LogPrint(BCLog::STAKENODE, "CStakenodeMan::ProcessVerifyReply -- increased PoSe ban score for %s addr %s, new score %d\n",
                      prealStakenode->pubKeyStakenode.GetID().ToString(), pnode->addr.ToString(), pmn->nPoSeBanScore);
         }
@@ -1019,18 +1241,19 @@ void CStakenodeMan::ProcessVerifyBroadcast(CNode* pnode, const CStakenodeVerific
             return;
         }
 
-        if(!CMessageSigner::VerifyMessage(pmn1->pubKeyStakenode.GetID(), mnv.vchSig1, strMessage1, strError)) {
+        if(!CMessageSigner::VerifyMessage(pmn1->pubKeyStakenode, mnv.vchSig1, strMessage1, strError)) {
             LogPrintf("CStakenodeMan::ProcessVerifyBroadcast -- VerifyMessage() for stakenode1 failed, error: %s\n", strError);
             return;
         }
 
-        if(!CMessageSigner::VerifyMessage(pmn2->pubKeyStakenode.GetID(), mnv.vchSig2, strMessage2, strError)) {
+        if(!CMessageSigner::VerifyMessage(pmn2->pubKeyStakenode, mnv.vchSig2, strMessage2, strError)) {
             LogPrintf("CStakenodeMan::ProcessVerifyBroadcast -- VerifyMessage() for stakenode2 failed, error: %s\n", strError);
             return;
         }
 
         if(!pmn1->IsPoSeVerified()) {
             pmn1->DecreasePoSeBanScore();
+            MarkChanged(pmn1->pubKeyStakenode);
         }
         mnv.Relay();
 
@@ -1042,6 +1265,8 @@ void CStakenodeMan::ProcessVerifyBroadcast(CNode* pnode, const CStakenodeVerific
         for (auto& mnpair : mapStakenodes) {
             if(mnpair.second.addr != mnv.addr || mnpair.first == mnv.pubKeyStakenode1) continue;
             mnpair.second.IncreasePoSeBanScore();
+            MarkChanged(mnpair.first);
+            ScheduleCheck(mnpair.second, true);
             nCount++;
             LogPrint(BCLog::STAKENODE, "CStakenodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
                      mnpair.first.GetID().ToString(), mnpair.second.addr.ToString(), mnpair.second.nPoSeBanScore);
@@ -1082,6 +1307,8 @@ void CStakenodeMan::UpdateStakenodeList(CStakenodeBroadcast mnb, CConnman& connm
     } else {
         CStakenodeBroadcast mnbOld = mapSeenStakenodeBroadcast[CStakenodeBroadcast(*pmn).GetHash()].second;
         if(pmn->UpdateFromNewBroadcast(mnb, connman)) {
+            MarkChanged(mnb.pubKeyStakenode);
+            ScheduleCheck(*pmn, true);
             stakenodeSync.BumpAssetLastTime("CStakenodeMan::UpdateStakenodeList - seen");
             mapSeenStakenodeBroadcast.erase(mnbOld.GetHash());
         }
@@ -1150,7 +1377,10 @@ bool CStakenodeMan::CheckMnbAndUpdateStakenodeList(CNode* pfrom, CStakenodeBroad
         CStakenode* pmn = Find(mnb.pubKeyStakenode);
         if(pmn) {
             CStakenodeBroadcast mnbOld = mapSeenStakenodeBroadcast[CStakenodeBroadcast(*pmn).GetHash()].second;
-            if(!mnb.Update(pmn, nDos, connman)) {
+            // even a rejected broadcast can have checked the stakenode
+            bool fUpdated = mnb.Update(pmn, nDos, connman);
+            MarkChanged(mnb.pubKeyStakenode);
+            if(!fUpdated) {
                 LogPrint(BCLog::STAKENODE, "CStakenodeMan::CheckMnbAndUpdateStakenodeList -- Update() failed, stakenode=%s\n",
                          mnb.pubKeyStakenode.GetID().ToString());
                 return false;
@@ -1199,7 +1429,9 @@ void CStakenodeMan::UpdateWatchdogVoteTime(const CPubKey &pubKeyStakenode, uint6
         return;
     }
     pmn->UpdateWatchdogVoteTime(nVoteTime);
+    MarkChanged(pubKeyStakenode);
     nLastWatchdogVoteTime = GetTime();
+    ScheduleCheck(*pmn);
 }
 
 bool CStakenodeMan::IsWatchdogActive()
@@ -1214,7 +1446,8 @@ void CStakenodeMan::CheckStakenode(const CPubKey& pubKeyStakenode, bool fForce)
     LOCK2(cs_main, cs);
     for (auto& mnpair : mapStakenodes) {
         if (mnpair.second.pubKeyStakenode == pubKeyStakenode) {
-            mnpair.second.Check(fForce);
+            CheckEntry(mnpair.second, fForce);
+            ScheduleCheck(mnpair.second);
             return;
         }
     }
@@ -1235,12 +1468,14 @@ void CStakenodeMan::SetStakenodeLastPing(const CPubKey &pubKeyStakenode, const C
         return;
     }
     pmn->lastPing = mnp;
+    MarkChanged(pubKeyStakenode);
     // if stakenode uses sentinel ping instead of watchdog
     // we shoud update nTimeLastWatchdogVote here if sentinel
     // ping flag is actual
     if(mnp.fSentinelIsCurrent) {
         UpdateWatchdogVoteTime(mnp.stakenodePubKey, mnp.sigTime);
     }
+    ScheduleCheck(*pmn, true);
     mapSeenStakenodePing.insert(std::make_pair(mnp.GetHash(), mnp));
 
     CStakenodeBroadcast mnb(*pmn);
@@ -1255,6 +1490,20 @@ void CStakenodeMan::UpdatedBlockTip(const CBlockIndex *pindex)
     nCachedBlockHeight = pindex->nHeight;
     LogPrint(BCLog::STAKENODE, "CStakenodeMan::UpdatedBlockTip -- nCachedBlockHeight=%d\n", nCachedBlockHeight);
 
+    {
+        LOCK(cs);
+        // PoSe bans that end with this block
+        while (!setCheckQueueBanned.empty() && setCheckQueueBanned.begin()->first <= nCachedBlockHeight) {
+            CPubKey pubKeyStakenode = setCheckQueueBanned.begin()->second;
+            CStakenode* pmn = Find(pubKeyStakenode);
+            if (pmn) {
+                ScheduleCheck(*pmn, true);
+            } else {
+                UnscheduleCheck(pubKeyStakenode);
+            }
+        }
+    }
+
     CheckSameAddr();
 }
 
@@ -5,9 +5,13 @@
 #ifndef STAKENODEMAN_H
 #define STAKENODEMAN_H
 
+#include <cache-journal.h>
+#include <coins.h>
 #include <stakenode/stakenode.h>
 #include <sync.h>
 
+#include <unordered_map>
+
 using namespace std;
 
 class CStakenodeMan;
@@ -22,6 +26,9 @@ private:
 
     static const int DSEG_UPDATE_SECONDS        = 1 * 30 * 60;
 
+    /// Buckets of the list digest, by the first byte of the stakenode key id
+    static const int LIST_DIGEST_BUCKETS        = 256;
+
     static const int LAST_PAID_SCAN_BLOCKS      = 100;
 
     static const int MIN_POSE_PROTO_VERSION     = 70203;
@@ -44,6 +51,9 @@ private:
 
     // map to hold all MNs
     std::map<CPubKey, CStakenode> mapStakenodes;
+    CCacheJournalTable<CPubKey, CStakenode> journalStakenodes;
+    // key id of every listed Stakenode, to look entries up by id or payee
+    std::unordered_map<CKeyID, CPubKey, SaltedKeyIDHasher> mapKeyIDIndex;
     // who's asked for the Stakenode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForStakenodeList;
     // who we asked for the Stakenode list and the last time
@@ -60,6 +70,31 @@ private:
 
     int64_t nLastWatchdogVoteTime;
 
+    // Stakenodes ordered by the adjusted time of their next state deadline,
+    // and PoSe-banned ones by the height their ban ends. Each stakenode is in
+    // at most one of the queues, at the place mapCheckScheduled records.
+    std::set<std::pair<int64_t, CPubKey> > setCheckQueue;
+    std::set<std::pair<int64_t, CPubKey> > setCheckQueueBanned;
+    std::map<CPubKey, std::pair<bool, int64_t> > mapCheckScheduled;
+
+    void UnscheduleCheck(const CPubKey& pubKeyStakenode);
+    void RebuildIndexes();
+
+    /// The entry was added, changed in place or is about to be erased, the
+    /// next journal flush writes it
+    void MarkChanged(const CPubKey& pubKeyStakenode) { journalStakenodes.MarkDirty(pubKeyStakenode); }
+    /// Check an entry and mark it changed if its state or ban score did
+    void CheckEntry(CStakenode& mn, bool fForce = false);
+
+    static int GetListDigestBucket(const CPubKey& pubKeyStakenode) { return *pubKeyStakenode.GetID().begin(); }
+    /// Rate limit full list and list digest requests per peer
+    bool AllowListRequest(CNode* pfrom, const std::string& strCommand);
+    /// Whether a stakenode is sent to peers syncing the list
+    static bool IsRelayedInList(const CStakenode& mn);
+    void PushListEntryInvs(CNode* pfrom, const CStakenode& mn);
+    /// Only the ping inv, for entries the peer already has
+    void PushListEntryPingInv(CNode* pfrom, const CStakenode& mn);
+
     friend class CStakenodeSync;
     /// Find an entry
     CStakenode* Find(const CPubKey &pubKeyStakenode);
@@ -89,6 +124,9 @@ public:
         }
 
         READWRITE(mapStakenodes);
+        if(ser_action.ForRead()) {
+            RebuildIndexes();
+        }
         READWRITE(mAskedUsForStakenodeList);
         READWRITE(mWeAskedForStakenodeList);
         READWRITE(mWeAskedForStakenodeListEntry);
@@ -115,8 +153,11 @@ public:
 
     bool PoSeBan(const CPubKey &pubKeyStakenode);
 
-    /// Check all Stakenodes
+    /// Check the Stakenodes whose state deadline has come
     void Check();
+    /// Queue the next check of a stakenode at its next state deadline, or
+    /// right away when something other than time changed it (fNow)
+    void ScheduleCheck(const CStakenode& mn, bool fNow = false);
 
     /// Check all Stakenodes and remove inactive
     void CheckAndRemove(CConnman& connman);
@@ -126,6 +167,12 @@ public:
     /// Clear Stakenode vector
     void Clear();
 
+    /// Journal of the stakenode list between snapshots, see CJournaledFlatDB
+    void SetJournalBaseline();
+    int WriteJournal(CCacheJournalDB& db, bool fSync);
+    bool ReplayJournal(CCacheJournalDB& db, const uint256& hashSnapshot);
+    void ResetJournal(CDBBatch& batch, CCacheJournalDB& db, const uint256& hashSnapshot);
+
     /// Count Stakenodes filtered by nProtocolVersion.
     /// Stakenode nProtocolVersion should match or be above the one specified in param here.
     int CountStakenodes(int nProtocolVersion = -1) const;
@@ -138,6 +185,11 @@ public:
 
     void DsegUpdate(CNode* pnode, CConnman& connman);
 
+    /// Digest of the stakenodes we would send to a syncing peer, per bucket.
+    /// A peer that sends its own gets the entries of the buckets that differ
+    /// and the pings of all the others.
+    std::vector<uint256> GetListDigests();
+
     /// Versions of Find that are safe to use from outside the class
     bool Get(const CKeyID &pubKeyID, CStakenode& masternodeRet);
     bool Get(const CPubKey &pubKeyStakenode, CStakenode& stakenodeRet);
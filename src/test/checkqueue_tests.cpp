@@ -441,5 +441,31 @@ BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks)
         tg.join_all();
     }
 }
+/** Test that header hashes computed on the header hashing threads are
+ * memoized and match the serial computation.
+ */
+BOOST_AUTO_TEST_CASE(test_HeaderHashQueue)
+{
+    std::vector<CBlockHeader> headers(MAX_HEADERS_RESULTS / 10 + 3);
+    for (CBlockHeader& header : headers) {
+        header.nVersion = 1;
+        header.hashPrevBlock = InsecureRand256();
+        header.hashMerkleRoot = InsecureRand256();
+        header.nTime = InsecureRand32();
+        header.nBits = 0x1e0ffff0;
+        header.nNonce = InsecureRand32();
+    }
+
+    // TestingSetup runs the header hashing threads alongside the script
+    // checking threads.
+    BOOST_REQUIRE(nScriptCheckThreads > 1);
+    PrecomputeHeaderHashes(headers);
+
+    for (const CBlockHeader& header : headers) {
+        uint256 hash;
+        BOOST_CHECK(header.hashMemo.Get((const unsigned char*)BEGIN(header.nVersion), hash));
+        BOOST_CHECK(hash == header.ComputeHash());
+    }
+}
 BOOST_AUTO_TEST_SUITE_END()
 
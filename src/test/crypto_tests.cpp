@@ -4,6 +4,7 @@
 
 #include <crypto/aes.h>
 #include <crypto/chacha20.h>
+#include <crypto/Lyra2RE/Lyra2.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
@@ -214,6 +215,22 @@ static std::string LongTestString(void) {
 
 const std::string test1 = LongTestString();
 
+static void TestLYRA2(unsigned char seed, uint64_t timeCost, uint64_t nRows, uint64_t nCols, const std::string& hexout)
+{
+    std::vector<unsigned char> in(32), out(32), outCtx(32);
+    for (unsigned int i = 0; i < in.size(); i++)
+        in[i] = seed + i * 7;
+    BOOST_CHECK_EQUAL(LYRA2(out.data(), 32, in.data(), 32, in.data(), 32, timeCost, nRows, nCols), 0);
+    BOOST_CHECK(out == ParseHex(hexout));
+
+    // A reused context must give the same result as a fresh one.
+    static LYRA2_CTX ctx;
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK_EQUAL(LYRA2_ctx(&ctx, outCtx.data(), 32, in.data(), 32, in.data(), 32, timeCost, nRows, nCols), 0);
+        BOOST_CHECK(outCtx == out);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(ripemd160_testvectors) {
     TestRIPEMD160("", "9c1185a5c5e9fc54612808977ee8f548b2258d31");
     TestRIPEMD160("abc", "8eb208f7e05d987a9b044a8e98c6b087f15a0bfc");
@@ -524,6 +541,15 @@ BOOST_AUTO_TEST_CASE(chacha20_testvector)
                  "fab78c9");
 }
 
+BOOST_AUTO_TEST_CASE(lyra2_testvectors)
+{
+    // Lyra2REv2 parameters
+    TestLYRA2(0, 1, 4, 4, "d497a4a2ce68a6525d8e5c165f317ce3e55a44bf0ead953bb7ccda530ebf0d1b");
+    TestLYRA2(31, 1, 4, 4, "7a0cd15471e65b918bf3a9f23b5e4456bd9fda2ef83e229a8b9017bb16520fae");
+    // Largest matrix a context holds
+    TestLYRA2(17, 2, 8, 8, "f0ab940fc9f6cb535e05df67a765e3f6d3130a91341714699bbef0f8e2e709f2");
+}
+
 BOOST_AUTO_TEST_CASE(countbits_tests)
 {
     FastRandomContext ctx;
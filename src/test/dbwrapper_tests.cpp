@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <cache-journal.h>
 #include <dbwrapper.h>
 #include <uint256.h>
 #include <random.h>
@@ -317,6 +318,68 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
     }
 }
 
-
+BOOST_AUTO_TEST_CASE(cache_journal_table)
+{
+    CCacheJournalDB db(1 << 20, true);
+    uint256 hashSnapshot = InsecureRand256();
+
+    std::map<int, std::string> mapEntries{{1, "one"}, {2, "two"}, {3, "three"}};
+    CCacheJournalTable<int, std::string> table("test");
+    table.SetBaseline(mapEntries);
+    CDBBatch batchReset(db);
+    table.Reset(batchReset, db, hashSnapshot);
+    BOOST_CHECK(db.WriteBatch(batchReset));
+
+    // of the entries marked dirty, only the changed, added and erased ones are journaled
+    mapEntries[2] = "TWO";
+    mapEntries[4] = "four";
+    mapEntries.erase(1);
+    for (int n : {1, 2, 3, 4, 5}) {
+        table.MarkDirty(n);
+    }
+    CDBBatch batch(db);
+    BOOST_CHECK_EQUAL(table.WriteChanges(batch, mapEntries), 3);
+    BOOST_CHECK(db.WriteBatch(batch));
+    table.Commit();
+
+    CDBBatch batchNone(db);
+    BOOST_CHECK_EQUAL(table.WriteChanges(batchNone, mapEntries), 0);
+    table.Commit();
+
+    // changes that are not marked wait for their mark
+    mapEntries[3] = "THREE";
+    CDBBatch batchUnmarked(db);
+    BOOST_CHECK_EQUAL(table.WriteChanges(batchUnmarked, mapEntries), 0);
+    table.Commit();
+
+    // the entries of a batch that was not written go into the next one
+    table.MarkDirty(3);
+    CDBBatch batchFailed(db);
+    BOOST_CHECK_EQUAL(table.WriteChanges(batchFailed, mapEntries), 1);
+    table.Abort();
+    CDBBatch batchRetry(db);
+    BOOST_CHECK_EQUAL(table.WriteChanges(batchRetry, mapEntries), 1);
+    BOOST_CHECK(db.WriteBatch(batchRetry));
+    table.Commit();
+
+    // replaying on top of the snapshot gives the current entries
+    std::map<int, std::string> mapLoaded{{1, "one"}, {2, "two"}, {3, "three"}};
+    BOOST_CHECK(table.Replay(db, hashSnapshot, mapLoaded));
+    BOOST_CHECK(mapLoaded == mapEntries);
+
+    // the journal of another snapshot is not applied
+    std::map<int, std::string> mapOther{{1, "one"}};
+    BOOST_CHECK(!table.Replay(db, InsecureRand256(), mapOther));
+    BOOST_CHECK_EQUAL(mapOther.size(), 1U);
+
+    CDBBatch batchNext(db);
+    uint256 hashNext = InsecureRand256();
+    table.Reset(batchNext, db, hashNext);
+    BOOST_CHECK(db.WriteBatch(batchNext));
+    std::vector<std::pair<CCacheJournalDB::record_t, CCacheJournalDB::record_t> > vRecords;
+    BOOST_CHECK(db.ReadRecords("test", vRecords));
+    BOOST_CHECK(vRecords.empty());
+    BOOST_CHECK(db.IsTableOf("test", hashNext));
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flat-database.h>
+#include <test/test_galactrum.h>
+#include <tinyformat.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+// An entry with an optional trailing field, read only if there are bytes left
+struct CTestEntry
+{
+    std::string strValue;
+    int nExtra = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(strValue);
+        if(ser_action.ForRead() && (s.size() == 0)) {
+            nExtra = 0;
+            return;
+        }
+        READWRITE(nExtra);
+    }
+};
+
+struct CTestCache
+{
+    std::map<int, CTestEntry> mapEntries;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(mapEntries);
+    }
+
+    void Clear() { mapEntries.clear(); }
+    void CheckAndRemove() {}
+    std::string ToString() const { return strprintf("Entries: %d", (int)mapEntries.size()); }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flatdb_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(flatdb_roundtrip)
+{
+    CTestCache cache;
+    for (int i = 0; i < 1000; i++) {
+        cache.mapEntries[i].strValue = std::string(i % 50, 'x');
+        cache.mapEntries[i].nExtra = i;
+    }
+
+    CFlatDB<CTestCache> flatdb("flatdb_test.dat", "magicTestCache");
+    BOOST_CHECK(flatdb.Dump(cache));
+    BOOST_CHECK(!flatdb.GetLastHash().IsNull());
+    BOOST_CHECK(!fs::exists(GetDataDir() / "flatdb_test.dat.new"));
+
+    CTestCache cacheLoaded;
+    CFlatDB<CTestCache> flatdbLoad("flatdb_test.dat", "magicTestCache");
+    BOOST_CHECK(flatdbLoad.Load(cacheLoaded));
+    BOOST_CHECK(flatdbLoad.GetLastHash() == flatdb.GetLastHash());
+    BOOST_CHECK_EQUAL(cacheLoaded.mapEntries.size(), 1000U);
+    BOOST_CHECK_EQUAL(cacheLoaded.mapEntries[999].nExtra, 999);
+    BOOST_CHECK_EQUAL(cacheLoaded.mapEntries[49].strValue, cache.mapEntries[49].strValue);
+
+    // a missing file is recreated
+    CFlatDB<CTestCache> flatdbMissing("flatdb_missing.dat", "magicTestCache");
+    CTestCache cacheMissing;
+    BOOST_CHECK(flatdbMissing.Load(cacheMissing));
+    BOOST_CHECK(flatdbMissing.GetLastHash().IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_corrupted)
+{
+    CTestCache cache;
+    cache.mapEntries[1].strValue = "one";
+    CFlatDB<CTestCache> flatdb("flatdb_corrupted.dat", "magicTestCache");
+    BOOST_CHECK(flatdb.Dump(cache));
+
+    // flip a byte of the data
+    fs::path path = GetDataDir() / "flatdb_corrupted.dat";
+    FILE* file = fsbridge::fopen(path, "rb+");
+    BOOST_REQUIRE(file);
+    fseek(file, -40, SEEK_END);
+    int ch = fgetc(file);
+    fseek(file, -40, SEEK_END);
+    fputc(ch ^ 0xff, file);
+    fclose(file);
+
+    CTestCache cacheLoaded;
+    BOOST_CHECK(!flatdb.Load(cacheLoaded));
+    BOOST_CHECK(cacheLoaded.mapEntries.empty());
+
+    // nor is it overwritten
+    BOOST_CHECK(!flatdb.Dump(cache));
+
+    // another kind of cache in the file is refused as well
+    BOOST_CHECK(fs::remove(path));
+    BOOST_CHECK(flatdb.Dump(cache));
+    CFlatDB<CTestCache> flatdbOther("flatdb_corrupted.dat", "magicOtherCache");
+    BOOST_CHECK(!flatdbOther.Load(cacheLoaded));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
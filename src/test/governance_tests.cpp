@@ -0,0 +1,89 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <governance/governance-votedb.h>
+#include <random.h>
+#include <uint256.h>
+#include <test/test_galactrum.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+// An in-memory vote database of its own, pgovernancevotedb is left alone
+struct GovernanceVoteDBSetup : public BasicTestingSetup {
+    CGovernanceVoteDB votedb;
+
+    GovernanceVoteDBSetup() : votedb(1 << 20, true) {}
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(governance_tests, GovernanceVoteDBSetup)
+
+BOOST_AUTO_TEST_CASE(governance_vote_db)
+{
+    uint256 nParentA = InsecureRand256();
+    uint256 nParentB = InsecureRand256();
+    COutPoint outpoint1(InsecureRand256(), 0);
+    COutPoint outpoint2(InsecureRand256(), 1);
+
+    CGovernanceVote vote1(outpoint1, nParentA, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    CGovernanceVote vote2(outpoint1, nParentA, VOTE_SIGNAL_DELETE, VOTE_OUTCOME_NO);
+    CGovernanceVote vote3(outpoint2, nParentA, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO);
+    CGovernanceVote vote4(outpoint2, nParentB, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    for (const CGovernanceVote& vote : {vote1, vote2, vote3, vote4}) {
+        BOOST_CHECK(votedb.WriteVote(vote));
+    }
+
+    BOOST_CHECK_EQUAL(votedb.ReadVotes(nParentA).size(), 3U);
+    BOOST_CHECK(votedb.HaveVote(nParentB, vote4.GetHash()));
+    BOOST_CHECK(!votedb.HaveVote(nParentA, vote4.GetHash()));
+    uint256 nParent;
+    BOOST_CHECK(votedb.ReadVoteParent(vote3.GetHash(), nParent));
+    BOOST_CHECK(nParent == nParentA);
+
+    // only the votes of the given masternode are erased
+    BOOST_CHECK_EQUAL(votedb.EraseVotes(nParentA, &outpoint1), 2);
+    BOOST_CHECK_EQUAL(votedb.ReadVotes(nParentA).size(), 1U);
+    BOOST_CHECK(!votedb.ReadVoteParent(vote1.GetHash(), nParent));
+
+    std::map<uint256, int> mapVoteCounts;
+    BOOST_CHECK(votedb.PruneVotes([&](const uint256& nHash) { return nHash == nParentB; }, mapVoteCounts));
+    BOOST_CHECK_EQUAL(mapVoteCounts.size(), 1U);
+    BOOST_CHECK_EQUAL(mapVoteCounts[nParentB], 1);
+    BOOST_CHECK(votedb.ReadVotes(nParentA).empty());
+}
+
+BOOST_AUTO_TEST_CASE(governance_vote_file_memory_bound)
+{
+    uint256 nParent = InsecureRand256();
+    uint256 nCollateralHash = InsecureRand256();
+
+    CGovernanceObjectVoteFile fileVotes(&votedb);
+    std::vector<uint256> vecHashes;
+    for (int i = 0; i < 150; i++) {
+        CGovernanceVote vote(COutPoint(nCollateralHash, i), nParent, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+        fileVotes.AddVote(vote);
+        vecHashes.push_back(vote.GetHash());
+    }
+
+    // the oldest votes are only on disk, but still found
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 150);
+    BOOST_CHECK_EQUAL(fileVotes.GetCachedVotes().size(), 100U);
+    BOOST_CHECK_EQUAL(fileVotes.GetVotes().size(), 150U);
+    CGovernanceVote vote;
+    BOOST_CHECK(fileVotes.HasVote(vecHashes.front()));
+    BOOST_CHECK(fileVotes.GetVote(vecHashes.front(), vote));
+    BOOST_CHECK(vote.GetHash() == vecHashes.front());
+
+    fileVotes.RemoveVotesFromMasternode(COutPoint(nCollateralHash, 0));
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 149);
+    BOOST_CHECK(!fileVotes.HasVote(vecHashes.front()));
+
+    fileVotes.RemoveAllVotes();
+    BOOST_CHECK(votedb.ReadVotes(nParent).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
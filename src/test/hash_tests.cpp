@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <hash.h>
+#include <primitives/block.h>
 #include <utilstrencodings.h>
 #include <test/test_galactrum.h>
 
@@ -147,4 +148,66 @@ BOOST_AUTO_TEST_CASE(siphash)
     }
 }
 
+BOOST_AUTO_TEST_CASE(block_header_hash_memo)
+{
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1520000000;
+    header.nBits = 0x1e0ffff0;
+    header.nNonce = 1;
+
+    const uint256 hash = header.GetHash();
+    BOOST_CHECK(hash == header.ComputeHash());
+    BOOST_CHECK(hash == header.GetHash());
+
+    // Copies carry the memo, and modifying a field invalidates it.
+    CBlock block(header);
+    BOOST_CHECK(block.GetHash() == hash);
+    block.nNonce++;
+    BOOST_CHECK(block.GetHash() != hash);
+    BOOST_CHECK(block.GetHash() == block.ComputeHash());
+    BOOST_CHECK(block.GetBlockHeader().GetHash() == block.ComputeHash());
+
+    // A seeded hash is served until it is explicitly invalidated.
+    const uint256 seeded = InsecureRand256();
+    header.SetCachedHash(seeded);
+    BOOST_CHECK(header.GetHash() == seeded);
+    header.InvalidateCachedHash();
+    BOOST_CHECK(header.GetHash() == hash);
+}
+
+BOOST_AUTO_TEST_CASE(lyra2re2_hash_lanes_matches_single)
+{
+    std::vector<std::vector<unsigned char>> data(LYRA2RE2_MAX_LANES, std::vector<unsigned char>(80));
+    const unsigned char* inputs[LYRA2RE2_MAX_LANES];
+    uint256 hashes[LYRA2RE2_MAX_LANES];
+
+    // Unrelated inputs, and inputs that differ only in the last four bytes
+    // (which takes the shared blake256 prefix path).
+    for (int shared = 0; shared < 2; shared++) {
+        for (size_t i = 0; i < LYRA2RE2_MAX_LANES; i++) {
+            for (size_t j = 0; j < data[i].size(); j++)
+                data[i][j] = shared && j < 76 ? data[0][j] : InsecureRandBits(8);
+            inputs[i] = data[i].data();
+        }
+        for (size_t lanes = 1; lanes <= LYRA2RE2_MAX_LANES; lanes++) {
+            lyra2re2_hash_lanes(inputs, 80, hashes, lanes);
+            for (size_t i = 0; i < lanes; i++)
+                BOOST_CHECK(hashes[i] == lyra2re2_hash(data[i].begin(), data[i].end()));
+        }
+    }
+
+    // Header batches are memoized with the same hashes GetHash() computes.
+    std::vector<CBlockHeader> headers(LYRA2RE2_MAX_LANES + 3);
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].hashPrevBlock = InsecureRand256();
+        headers[i].nNonce = i;
+    }
+    PrecomputeBlockHeaderHashes(headers);
+    for (const CBlockHeader& header : headers)
+        BOOST_CHECK(header.GetHash() == header.ComputeHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,308 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <activemasternode.h>
+#include <instantx.h>
+#include <masternode-sync.h>
+#include <masternodeman.h>
+#include <net_processing.h>
+#include <test/test_galactrum.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct CInstantSendTest {
+    static void AddPendingVote(CInstantSend& is, const CTxLockVote& vote)
+    {
+        boost::unique_lock<boost::mutex> lock(is.mutexTxLockVotesPending);
+        is.vecTxLockVotesPending.push_back(vote);
+    }
+
+    static void AddOrphanVote(CInstantSend& is, const CTxLockVote& vote)
+    {
+        LOCK(is.cs_instantsend);
+        is.AddOrphanTxLockVote(vote);
+    }
+
+    static bool HasOrphanVote(CInstantSend& is, const uint256& nVoteHash)
+    {
+        LOCK(is.cs_instantsend);
+        return is.mapTxLockVotesOrphan.count(nVoteHash);
+    }
+
+    static std::vector<uint256> GetOrphanVoteHashes(CInstantSend& is, const uint256& txHash)
+    {
+        LOCK(is.cs_instantsend);
+        return is.GetOrphanTxLockVoteHashes(txHash);
+    }
+
+    static bool IsEnoughOrphanVotes(CInstantSend& is, const uint256& txHash, const COutPoint& outpoint)
+    {
+        return is.IsEnoughOrphanVotesForTxAndOutPoint(txHash, outpoint);
+    }
+
+    static void AddVote(CInstantSend& is, const CTxLockVote& vote)
+    {
+        LOCK(is.cs_instantsend);
+        is.AddTxLockVote(vote);
+    }
+
+    static void SetVoteConfirmedHeight(CInstantSend& is, const uint256& nVoteHash, int nConfirmedHeight)
+    {
+        LOCK(is.cs_instantsend);
+        is.SetTxLockVoteConfirmedHeight(nVoteHash, nConfirmedHeight);
+    }
+
+    static bool HasVote(CInstantSend& is, const uint256& nVoteHash)
+    {
+        LOCK(is.cs_instantsend);
+        return is.mapTxLockVotes.count(nVoteHash);
+    }
+
+    // the orphan map and both of its indexes hold the same votes
+    static size_t CountOrphanVotes(CInstantSend& is)
+    {
+        LOCK(is.cs_instantsend);
+        size_t nIndexed = 0;
+        for (const auto& pair : is.mapTxLockVotesOrphanByOutpoint) {
+            nIndexed += pair.second.size();
+        }
+        BOOST_CHECK_EQUAL(nIndexed, is.mapTxLockVotesOrphan.size());
+        BOOST_CHECK_EQUAL(is.setTxLockVotesOrphanTimeouts.size(), is.mapTxLockVotesOrphan.size());
+        return is.mapTxLockVotesOrphan.size();
+    }
+};
+
+namespace {
+
+// A 100 block chain with a synced masternode list of two masternodes
+struct InstantSendTestingSetup : public TestChain100Setup {
+    CKey keyMasternode1;
+    CKey keyMasternode2;
+    COutPoint outpointMasternode1;
+    COutPoint outpointMasternode2;
+
+    InstantSendTestingSetup()
+    {
+        masternodeSync.Reset();
+        while (!masternodeSync.IsMasternodeListSynced()) {
+            masternodeSync.SwitchToNextAsset(*connman);
+        }
+
+        keyMasternode1.MakeNewKey(true);
+        keyMasternode2.MakeNewKey(true);
+        outpointMasternode1 = AddMasternode(1, keyMasternode1);
+        outpointMasternode2 = AddMasternode(2, keyMasternode2);
+    }
+
+    ~InstantSendTestingSetup()
+    {
+        activeMasternode.keyMasternode = CKey();
+        activeMasternode.pubKeyMasternode = CPubKey();
+        mnodeman.Clear();
+        masternodeSync.Reset();
+    }
+
+    COutPoint AddMasternode(uint32_t n, const CKey& key)
+    {
+        CMasternode mn;
+        mn.outpoint = COutPoint(uint256S("01"), n);
+        mn.pubKeyMasternode = key.GetPubKey();
+        mn.nProtocolVersion = PROTOCOL_VERSION;
+        BOOST_CHECK(mnodeman.Add(mn));
+        return mn.outpoint;
+    }
+
+    // a vote for the coinbase of block nCoinbase, signed with key
+    CTxLockVote MakeVote(const uint256& txHash, int nCoinbase, const COutPoint& outpointMasternode, const CKey& key)
+    {
+        CTxLockVote vote(txHash, COutPoint(m_coinbase_txns[nCoinbase]->GetHash(), 0), outpointMasternode);
+        activeMasternode.keyMasternode = key;
+        activeMasternode.pubKeyMasternode = key.GetPubKey();
+        BOOST_CHECK(vote.Sign());
+        return vote;
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(instantx_tests, InstantSendTestingSetup)
+
+BOOST_AUTO_TEST_CASE(txlockvote_batch_skips_invalid)
+{
+    int nVoteThreadsPrev = nInstantSendVoteThreads;
+    uint256 txHash = uint256S("aa");
+
+    // once inline and once through the vote check queue
+    for (int nThreads : {1, 4}) {
+        nInstantSendVoteThreads = nThreads;
+        CInstantSend is;
+        is.UpdatedBlockTip(chainActive.Tip());
+
+        CTxLockVote vote1 = MakeVote(txHash, 0, outpointMasternode1, keyMasternode1);
+        CTxLockVote vote2 = MakeVote(txHash, 1, outpointMasternode2, keyMasternode2);
+        // signed by the other masternode
+        CTxLockVote voteBad = MakeVote(txHash, 2, outpointMasternode2, keyMasternode1);
+        BOOST_CHECK(vote1.IsValid(nullptr, *connman));
+        BOOST_CHECK(!voteBad.IsValid(nullptr, *connman));
+
+        CInstantSendTest::AddPendingVote(is, vote1);
+        CInstantSendTest::AddPendingVote(is, voteBad);
+        CInstantSendTest::AddPendingVote(is, vote2);
+        is.ProcessPendingTxLockVotes(*connman);
+        BOOST_CHECK_EQUAL(is.GetPendingTxLockVoteCount(), 0U);
+
+        // there is no lock request yet, so the valid votes wait as orphans
+        BOOST_CHECK(CInstantSendTest::HasOrphanVote(is, vote1.GetHash()));
+        BOOST_CHECK(CInstantSendTest::HasOrphanVote(is, vote2.GetHash()));
+        BOOST_CHECK(!CInstantSendTest::HasOrphanVote(is, voteBad.GetHash()));
+        BOOST_CHECK_EQUAL(CInstantSendTest::CountOrphanVotes(is), 2U);
+    }
+
+    nInstantSendVoteThreads = nVoteThreadsPrev;
+}
+
+BOOST_AUTO_TEST_CASE(txlockvote_pending_queue_is_bounded)
+{
+    CInstantSend is;
+    is.UpdatedBlockTip(chainActive.Tip());
+    uint256 txHash = uint256S("aa");
+
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", true);
+    node.nVersion = PROTOCOL_VERSION;
+    peerLogic->InitializeNode(&node);
+
+    for (size_t i = 0; i + 1 < MAX_INSTANTSEND_PENDING_VOTES; i++) {
+        CInstantSendTest::AddPendingVote(is, CTxLockVote());
+    }
+
+    // the last free slot is taken
+    CTxLockVote vote1 = MakeVote(txHash, 0, outpointMasternode1, keyMasternode1);
+    CDataStream ssVote1(SER_NETWORK, PROTOCOL_VERSION);
+    ssVote1 << vote1;
+    is.ProcessMessage(&node, NetMsgType::TXLOCKVOTE, ssVote1, *connman);
+    BOOST_CHECK_EQUAL(is.GetPendingTxLockVoteCount(), MAX_INSTANTSEND_PENDING_VOTES);
+    BOOST_CHECK(is.AlreadyHave(vote1.GetHash()));
+
+    CNodeStateStats stats;
+    BOOST_CHECK(GetNodeStateStats(node.GetId(), stats));
+    BOOST_CHECK_EQUAL(stats.nMisbehavior, 0);
+
+    // a full queue drops the vote, it can be asked for again later
+    CTxLockVote vote2 = MakeVote(txHash, 1, outpointMasternode2, keyMasternode2);
+    CDataStream ssVote2(SER_NETWORK, PROTOCOL_VERSION);
+    ssVote2 << vote2;
+    is.ProcessMessage(&node, NetMsgType::TXLOCKVOTE, ssVote2, *connman);
+    BOOST_CHECK_EQUAL(is.GetPendingTxLockVoteCount(), MAX_INSTANTSEND_PENDING_VOTES);
+    BOOST_CHECK(!is.AlreadyHave(vote2.GetHash()));
+    BOOST_CHECK(GetNodeStateStats(node.GetId(), stats));
+    BOOST_CHECK_GT(stats.nMisbehavior, 0);
+
+    bool fUpdateConnectionTime;
+    peerLogic->FinalizeNode(node.GetId(), fUpdateConnectionTime);
+}
+
+BOOST_AUTO_TEST_CASE(txlockvote_orphans_by_outpoint_and_timeout)
+{
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+
+    CInstantSend is;
+    is.UpdatedBlockTip(chainActive.Tip());
+    uint256 txHash1 = uint256S("aa");
+    uint256 txHash2 = uint256S("bb");
+    COutPoint outpoint1(uint256S("01"), 0);
+    COutPoint outpoint2(uint256S("02"), 0);
+
+    // enough votes to lock outpoint1 of tx1, one for outpoint2
+    for (uint32_t i = 0; i < COutPointLock::SIGNATURES_REQUIRED; i++) {
+        CInstantSendTest::AddOrphanVote(is, CTxLockVote(txHash1, outpoint1, COutPoint(uint256S("03"), i)));
+    }
+    CInstantSendTest::AddOrphanVote(is, CTxLockVote(txHash1, outpoint2, COutPoint(uint256S("03"), 0)));
+
+    // the same outpoint voted for in another tx a bit later
+    SetMockTime(nNow + 10);
+    CTxLockVote voteLater(txHash2, outpoint1, COutPoint(uint256S("03"), 0));
+    CInstantSendTest::AddOrphanVote(is, voteLater);
+    BOOST_CHECK_EQUAL(CInstantSendTest::CountOrphanVotes(is), (size_t)COutPointLock::SIGNATURES_REQUIRED + 2);
+
+    BOOST_CHECK_EQUAL(CInstantSendTest::GetOrphanVoteHashes(is, txHash1).size(), (size_t)COutPointLock::SIGNATURES_REQUIRED + 1);
+    BOOST_CHECK(CInstantSendTest::GetOrphanVoteHashes(is, txHash2) == std::vector<uint256>{voteLater.GetHash()});
+    BOOST_CHECK(CInstantSendTest::GetOrphanVoteHashes(is, uint256S("cc")).empty());
+    BOOST_CHECK(CInstantSendTest::IsEnoughOrphanVotes(is, txHash1, outpoint1));
+    BOOST_CHECK(!CInstantSendTest::IsEnoughOrphanVotes(is, txHash1, outpoint2));
+    BOOST_CHECK(!CInstantSendTest::IsEnoughOrphanVotes(is, txHash2, outpoint1));
+
+    // nothing is due yet
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(CInstantSendTest::CountOrphanVotes(is), (size_t)COutPointLock::SIGNATURES_REQUIRED + 2);
+
+    // the first votes time out, the later one stays
+    SetMockTime(nNow + INSTANTSEND_LOCK_TIMEOUT_SECONDS + 1);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(CInstantSendTest::CountOrphanVotes(is), 1U);
+    BOOST_CHECK(CInstantSendTest::GetOrphanVoteHashes(is, txHash1).empty());
+    BOOST_CHECK(!CInstantSendTest::IsEnoughOrphanVotes(is, txHash1, outpoint1));
+    BOOST_CHECK(CInstantSendTest::HasOrphanVote(is, voteLater.GetHash()));
+
+    SetMockTime(nNow + 10 + INSTANTSEND_LOCK_TIMEOUT_SECONDS + 1);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(CInstantSendTest::CountOrphanVotes(is), 0U);
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(txlockvote_expiry_by_height_and_time)
+{
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+
+    CInstantSend is;
+    is.UpdatedBlockTip(chainActive.Tip());
+    int nHeight = chainActive.Height();
+    int nKeepLock = Params().GetConsensus().nInstantSendKeepLock;
+
+    CTxLockVote voteUnconfirmed(uint256S("aa"), COutPoint(uint256S("01"), 0), outpointMasternode1);
+    CTxLockVote voteConfirmed(uint256S("bb"), COutPoint(uint256S("02"), 0), outpointMasternode1);
+    CTxLockVote voteReorged(uint256S("cc"), COutPoint(uint256S("03"), 0), outpointMasternode1);
+    CInstantSendTest::AddVote(is, voteUnconfirmed);
+    CInstantSendTest::AddVote(is, voteConfirmed);
+    CInstantSendTest::AddVote(is, voteReorged);
+    CInstantSendTest::SetVoteConfirmedHeight(is, voteConfirmed.GetHash(), nHeight);
+    // disconnected and mined again two blocks later
+    CInstantSendTest::SetVoteConfirmedHeight(is, voteReorged.GetHash(), nHeight);
+    CInstantSendTest::SetVoteConfirmedHeight(is, voteReorged.GetHash(), -1);
+    CInstantSendTest::SetVoteConfirmedHeight(is, voteReorged.GetHash(), nHeight + 2);
+
+    CBlockIndex index;
+    index.nHeight = nHeight + nKeepLock;
+    is.UpdatedBlockTip(&index);
+    is.CheckAndRemove();
+    BOOST_CHECK(CInstantSendTest::HasVote(is, voteConfirmed.GetHash()));
+
+    // expired by height, the stale entry of the reorged vote is skipped
+    index.nHeight = nHeight + nKeepLock + 1;
+    is.UpdatedBlockTip(&index);
+    is.CheckAndRemove();
+    BOOST_CHECK(!CInstantSendTest::HasVote(is, voteConfirmed.GetHash()));
+    BOOST_CHECK(CInstantSendTest::HasVote(is, voteReorged.GetHash()));
+    BOOST_CHECK(CInstantSendTest::HasVote(is, voteUnconfirmed.GetHash()));
+
+    index.nHeight = nHeight + nKeepLock + 3;
+    is.UpdatedBlockTip(&index);
+    is.CheckAndRemove();
+    BOOST_CHECK(!CInstantSendTest::HasVote(is, voteReorged.GetHash()));
+    BOOST_CHECK(CInstantSendTest::HasVote(is, voteUnconfirmed.GetHash()));
+
+    // failed by time, there is no lock for its tx
+    SetMockTime(nNow + INSTANTSEND_FAILED_TIMEOUT_SECONDS);
+    is.CheckAndRemove();
+    BOOST_CHECK(CInstantSendTest::HasVote(is, voteUnconfirmed.GetHash()));
+    SetMockTime(nNow + INSTANTSEND_FAILED_TIMEOUT_SECONDS + 1);
+    is.CheckAndRemove();
+    BOOST_CHECK(!CInstantSendTest::HasVote(is, voteUnconfirmed.GetHash()));
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
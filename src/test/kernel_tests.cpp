@@ -0,0 +1,101 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <hash.h>
+#include <kernel.h>
+#include <validation.h>
+#include <test/test_galactrum.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+const unsigned int KERNEL_BLOCK_TIME = 1530000000;
+const uint64_t KERNEL_STAKE_MODIFIER = 0x0123456789abcdefULL;
+const unsigned int KERNEL_BITS = 0x1e0fffff;
+
+// The preimage CheckStakeKernelHash has always hashed, spelled out
+uint256 KernelHash(unsigned int nTimeBlockFrom, uint32_t nPrevout, unsigned int nTimeTx)
+{
+    unsigned int nTxPrevOffset = 336;
+    int64_t txPrevTime = nTimeBlockFrom;
+    CDataStream ss(SER_GETHASH, 0);
+    ss << KERNEL_STAKE_MODIFIER;
+    ss << nTimeBlockFrom << nTxPrevOffset << txPrevTime << nPrevout << nTimeTx;
+    BOOST_CHECK_EQUAL(ss.size(), 32U);
+    return Hash(ss.begin(), ss.end());
+}
+
+// A kernel block followed a day later by the block whose modifier it stakes with
+struct KernelTestingSetup : public BasicTestingSetup {
+    uint256 hashBlockFrom;
+    uint256 hashBlockModifier;
+    CBlockIndex indexFrom;
+    CBlockIndex indexModifier;
+
+    KernelTestingSetup()
+    {
+        hashBlockFrom = uint256S("0a");
+        hashBlockModifier = uint256S("0b");
+
+        indexFrom.nHeight = 0;
+        indexFrom.nTime = KERNEL_BLOCK_TIME;
+        indexFrom.phashBlock = &mapBlockIndex.emplace(hashBlockFrom, &indexFrom).first->first;
+
+        indexModifier.pprev = &indexFrom;
+        indexModifier.nHeight = 1;
+        indexModifier.nTime = KERNEL_BLOCK_TIME + 60 * 60 * 24;
+        indexModifier.SetStakeModifier(KERNEL_STAKE_MODIFIER, true);
+        indexModifier.phashBlock = &mapBlockIndex.emplace(hashBlockModifier, &indexModifier).first->first;
+
+        chainActive.SetTip(&indexModifier);
+    }
+
+    ~KernelTestingSetup()
+    {
+        chainActive.SetTip(nullptr);
+        mapBlockIndex.erase(hashBlockFrom);
+        mapBlockIndex.erase(hashBlockModifier);
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(kernel_tests, KernelTestingSetup)
+
+BOOST_AUTO_TEST_CASE(kernel_context_matches_kernel_hash)
+{
+    COutPoint prevout(uint256S("01"), 1);
+    CStakeKernelContext kernel;
+    BOOST_REQUIRE(kernel.Init(hashBlockFrom, KERNEL_BLOCK_TIME, 1000 * COIN, prevout));
+    BOOST_CHECK_EQUAL(kernel.GetBlockFromTime(), KERNEL_BLOCK_TIME);
+
+    for(unsigned int nTimeTx = KERNEL_BLOCK_TIME + 60 * 60; nTimeTx < KERNEL_BLOCK_TIME + 60 * 60 + 16; nTimeTx++) {
+        uint256 hashContext, hashKernel;
+        bool fContext = kernel.CheckHash(KERNEL_BITS, nTimeTx, hashContext);
+        bool fKernel = CheckStakeKernelHash(KERNEL_BITS, hashBlockFrom, KERNEL_BLOCK_TIME, 1000 * COIN, prevout, nTimeTx, hashKernel);
+        BOOST_CHECK_EQUAL(fContext, fKernel);
+        BOOST_CHECK(hashContext == hashKernel);
+        BOOST_CHECK(hashContext == KernelHash(KERNEL_BLOCK_TIME, prevout.n, nTimeTx));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kernel_hash_regression)
+{
+    // hashProofOfStake as computed by the original CheckStakeKernelHash,
+    // which hashed txPrev time as the 64-bit CBlock::GetBlockTime()
+    COutPoint prevout(uint256S("01"), 1);
+    unsigned int nTimeTx = KERNEL_BLOCK_TIME + 2 * 60 * 60;
+    uint256 hashProofOfStake;
+    CheckStakeKernelHash(KERNEL_BITS, hashBlockFrom, KERNEL_BLOCK_TIME, 1000 * COIN, prevout, nTimeTx, hashProofOfStake);
+    BOOST_CHECK_EQUAL(hashProofOfStake.ToString(), "6922a79d2961a6215bbea00528adff3ff46a286ad96cfa16c5ee3f23e4c3930d");
+    BOOST_CHECK(hashProofOfStake == KernelHash(KERNEL_BLOCK_TIME, prevout.n, nTimeTx));
+
+    // coins younger than the min age or kernels earlier than their block still fail
+    BOOST_CHECK(!CheckStakeKernelHash(KERNEL_BITS, hashBlockFrom, KERNEL_BLOCK_TIME, 1000 * COIN, prevout, KERNEL_BLOCK_TIME - 1, hashProofOfStake));
+    BOOST_CHECK(!CheckStakeKernelHash(KERNEL_BITS, hashBlockFrom, KERNEL_BLOCK_TIME, 1000 * COIN, prevout, KERNEL_BLOCK_TIME + 60, hashProofOfStake));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
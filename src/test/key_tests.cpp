@@ -5,6 +5,7 @@
 #include <key.h>
 
 #include <key_io.h>
+#include <messagesigner.h>
 #include <script/script.h>
 #include <uint256.h>
 #include <util.h>
@@ -128,6 +129,25 @@ BOOST_AUTO_TEST_CASE(key_test1)
         BOOST_CHECK(rkey2  == pubkey2);
         BOOST_CHECK(rkey1C == pubkey1C);
         BOOST_CHECK(rkey2C == pubkey2C);
+
+        // compact signatures checked against a known key
+
+        BOOST_CHECK( pubkey1.VerifyCompact (hashMsg, csign1));
+        BOOST_CHECK( pubkey2.VerifyCompact (hashMsg, csign2));
+        BOOST_CHECK( pubkey1C.VerifyCompact(hashMsg, csign1C));
+        BOOST_CHECK( pubkey2C.VerifyCompact(hashMsg, csign2C));
+        BOOST_CHECK(!pubkey1.VerifyCompact (hashMsg, csign2));
+        BOOST_CHECK(!pubkey1.VerifyCompact (hashMsg, csign1C));
+        BOOST_CHECK(!pubkey1C.VerifyCompact(hashMsg, csign1));
+
+        // the same r/s under any other recovery id is rejected
+
+        for (int nHeader = 27; nHeader < 35; nHeader++) {
+            std::vector<unsigned char> csign1Other = csign1, csign1COther = csign1C;
+            csign1Other[0] = csign1COther[0] = nHeader;
+            if (nHeader != csign1[0]) BOOST_CHECK(!pubkey1.VerifyCompact(hashMsg, csign1Other));
+            if (nHeader != csign1C[0]) BOOST_CHECK(!pubkey1C.VerifyCompact(hashMsg, csign1COther));
+        }
     }
 
     // test deterministic signing
@@ -153,4 +173,31 @@ BOOST_AUTO_TEST_CASE(key_test1)
     BOOST_CHECK(detsigc == ParseHex("2052d8a32079c11e79db95af63bb9600c5b04f21a9ca33dc129c2bfa8ac9dc1cd561d8ae5e0f6c1a16bde3719c64c2fd70e404b6428ab9a69566962e8771b5944d"));
 }
 
+BOOST_AUTO_TEST_CASE(message_signer)
+{
+    CKey key = DecodeSecret(strSecret1C);
+    CPubKey pubkey = key.GetPubKey();
+    CPubKey pubkeyOther = DecodeSecret(strSecret2C).GetPubKey();
+    std::string strMessage = "Very deterministic message", strError;
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(CMessageSigner::SignMessage(strMessage, vchSig, key, CPubKey::InputScriptType::SPENDP2PKH));
+
+    uint64_t nHits, nMisses, nHitsBefore, nMissesBefore;
+    GetMessageSignatureCacheStats(nHitsBefore, nMissesBefore);
+
+    // the known-key and the address path agree, and repeats hit the cache
+    BOOST_CHECK(CMessageSigner::VerifyMessage(pubkey, vchSig, strMessage, strError));
+    BOOST_CHECK(CMessageSigner::VerifyMessage(pubkey, vchSig, strMessage, strError));
+    BOOST_CHECK(CMessageSigner::VerifyMessage(pubkey.GetID(), vchSig, strMessage, strError));
+    BOOST_CHECK(CMessageSigner::VerifyMessage(pubkey.GetID(), vchSig, strMessage, strError));
+    GetMessageSignatureCacheStats(nHits, nMisses);
+    BOOST_CHECK_EQUAL(nHits - nHitsBefore, 2U);
+    BOOST_CHECK_EQUAL(nMisses - nMissesBefore, 2U);
+
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(pubkeyOther, vchSig, strMessage, strError));
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(pubkeyOther.GetID(), vchSig, strMessage, strError));
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(pubkey, vchSig, strMessage + ".", strError));
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(pubkey.GetID(), vchSig, strMessage + ".", strError));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
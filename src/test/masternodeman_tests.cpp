@@ -0,0 +1,192 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cache-journal.h>
+#include <masternodeman.h>
+#include <netbase.h>
+#include <test/test_galactrum.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+CMasternode MakeMasternode(uint32_t n)
+{
+    CMasternode mn;
+    mn.outpoint = COutPoint(uint256S("01"), n);
+    mn.nProtocolVersion = PROTOCOL_VERSION;
+    return mn;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(masternodeman_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(masternode_list_snapshot)
+{
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+
+    // there is a snapshot before anything was added
+    CMasternodeMan man;
+    CMasternodeMan::list_snapshot_ptr_t plistEmpty = man.GetListSnapshot();
+    BOOST_REQUIRE(plistEmpty);
+    BOOST_CHECK(plistEmpty->mapMasternodes.empty());
+
+    CMasternode mn = MakeMasternode(0);
+    mn.fUnitTest = true;
+    mn.lastPing.masternodeOutpoint = mn.outpoint;
+    mn.lastPing.sigTime = nNow - 100;
+    BOOST_CHECK(man.Add(mn));
+
+    // a new entry is in the snapshot right away, readers share it
+    CMasternodeMan::list_snapshot_ptr_t plist = man.GetListSnapshot();
+    BOOST_REQUIRE(plist);
+    BOOST_CHECK_EQUAL(plist->mapMasternodes.size(), 1U);
+    BOOST_CHECK(man.GetListSnapshot() == plist);
+    BOOST_CHECK(plistEmpty->mapMasternodes.empty());
+
+    // changed fields are published by the next Check()
+    CMasternodePing mnp = mn.lastPing;
+    mnp.sigTime = nNow;
+    man.SetMasternodeLastPing(mn.outpoint, mnp);
+    BOOST_CHECK(man.GetListSnapshot() == plist);
+    man.Check();
+    CMasternodeMan::list_snapshot_ptr_t plistPinged = man.GetListSnapshot();
+    BOOST_CHECK(plistPinged != plist);
+    BOOST_CHECK_EQUAL(plistPinged->mapMasternodes.at(mn.outpoint).lastPing.sigTime, nNow);
+    BOOST_CHECK_EQUAL(plist->mapMasternodes.at(mn.outpoint).lastPing.sigTime, nNow - 100);
+
+    // and nothing is copied while nothing changed
+    man.Check();
+    BOOST_CHECK(man.GetListSnapshot() == plistPinged);
+
+    // clearing the list publishes an empty one
+    man.Clear();
+    CMasternodeMan::list_snapshot_ptr_t plistCleared = man.GetListSnapshot();
+    BOOST_REQUIRE(plistCleared);
+    BOOST_CHECK(plistCleared->mapMasternodes.empty());
+    BOOST_CHECK_EQUAL(plistPinged->mapMasternodes.size(), 1U);
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(masternode_list_digests)
+{
+    CMasternodeMan man1, man2, man3, man4;
+    CMasternode mn = MakeMasternode(0);
+    mn.addr = LookupNumeric("8.8.8.8", 9999);
+    mn.lastPing.masternodeOutpoint = mn.outpoint;
+    mn.lastPing.sigTime = 1000;
+    BOOST_CHECK(man1.Add(mn));
+    BOOST_CHECK(man2.Add(mn));
+
+    std::vector<uint256> vecDigests1 = man1.GetListDigests();
+    BOOST_CHECK(vecDigests1 == man2.GetListDigests());
+
+    // same broadcast with a newer ping: the digests only cover broadcasts,
+    // the ping is sent for matching buckets on its own
+    mn.lastPing.sigTime = 2000;
+    BOOST_CHECK(man3.Add(mn));
+    BOOST_CHECK(vecDigests1 == man3.GetListDigests());
+
+    // another broadcast: exactly its bucket differs
+    mn.sigTime = 3000;
+    BOOST_CHECK(man4.Add(mn));
+    std::vector<uint256> vecDigests4 = man4.GetListDigests();
+    BOOST_REQUIRE_EQUAL(vecDigests1.size(), vecDigests4.size());
+    int nBucketsDiffer = 0;
+    for(size_t i = 0; i < vecDigests1.size(); i++) {
+        if(vecDigests1[i] != vecDigests4[i]) nBucketsDiffer++;
+    }
+    BOOST_CHECK_EQUAL(nBucketsDiffer, 1);
+}
+
+BOOST_AUTO_TEST_CASE(masternode_journal_skips_checks)
+{
+    CCacheJournalDB db(1 << 20, true);
+    CCacheJournalTable<COutPoint, CMasternode> table("test");
+    std::map<COutPoint, CMasternode> mapMasternodes;
+    CMasternode mn = MakeMasternode(0);
+    mn.fUnitTest = true;
+    mapMasternodes.emplace(mn.outpoint, mn);
+    CMasternode& mnEntry = mapMasternodes.begin()->second;
+
+    SetMockTime(GetTime());
+    mnEntry.Check(true);
+    table.SetBaseline(mapMasternodes);
+
+    // a check that leaves the state as it was is not a change
+    int nActiveState = mnEntry.nActiveState;
+    SetMockTime(GetTime() + 60);
+    mnEntry.Check(true);
+    BOOST_CHECK_EQUAL(mnEntry.nActiveState, nActiveState);
+    table.MarkDirty(mn.outpoint);
+    CDBBatch batch(db);
+    BOOST_CHECK_EQUAL(table.WriteChanges(batch, mapMasternodes), 0);
+    table.Commit();
+
+    // a new ping is
+    mnEntry.lastPing.sigTime = GetTime();
+    table.MarkDirty(mn.outpoint);
+    CDBBatch batchPing(db);
+    BOOST_CHECK_EQUAL(table.WriteChanges(batchPing, mapMasternodes), 1);
+    table.Commit();
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(masternode_check_queue)
+{
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+
+    CMasternodeMan man;
+    CMasternode mn0 = MakeMasternode(0);
+    mn0.fUnitTest = true;
+    mn0.lastPing.masternodeOutpoint = mn0.outpoint;
+    mn0.lastPing.sigTime = nNow - 100;
+    CMasternode mn1 = MakeMasternode(1);
+    mn1.fUnitTest = true;
+    mn1.lastPing.masternodeOutpoint = mn1.outpoint;
+    mn1.lastPing.sigTime = nNow - 300;
+    BOOST_CHECK(man.Add(mn0));
+    BOOST_CHECK(man.Add(mn1));
+
+    // new entries are checked right away
+    int64_t nDue;
+    bool fHeight;
+    BOOST_REQUIRE(man.GetScheduledCheck(mn0.outpoint, nDue, fHeight));
+    BOOST_CHECK(!fHeight);
+    BOOST_CHECK_EQUAL(nDue, nNow);
+
+    // then each waits for the next age of its ping that Check() looks at
+    man.Check();
+    BOOST_REQUIRE(man.GetScheduledCheck(mn0.outpoint, nDue, fHeight));
+    BOOST_CHECK_EQUAL(nDue, nNow - 100 + MASTERNODE_MIN_MNP_SECONDS);
+    BOOST_REQUIRE(man.GetScheduledCheck(mn1.outpoint, nDue, fHeight));
+    BOOST_CHECK_EQUAL(nDue, nNow - 300 + MASTERNODE_MIN_MNP_SECONDS);
+
+    // only the entry that came due is visited and moves on to its next deadline
+    SetMockTime(nNow - 300 + MASTERNODE_MIN_MNP_SECONDS);
+    man.Check();
+    BOOST_REQUIRE(man.GetScheduledCheck(mn1.outpoint, nDue, fHeight));
+    BOOST_CHECK_EQUAL(nDue, nNow - 300 + MASTERNODE_EXPIRATION_SECONDS);
+    BOOST_REQUIRE(man.GetScheduledCheck(mn0.outpoint, nDue, fHeight));
+    BOOST_CHECK_EQUAL(nDue, nNow - 100 + MASTERNODE_MIN_MNP_SECONDS);
+
+    // a new ping replaces the deadline of the old one
+    int64_t nPingTime = GetTime();
+    CMasternodePing mnp = mn0.lastPing;
+    mnp.sigTime = nPingTime;
+    man.SetMasternodeLastPing(mn0.outpoint, mnp);
+    BOOST_REQUIRE(man.GetScheduledCheck(mn0.outpoint, nDue, fHeight));
+    BOOST_CHECK_EQUAL(nDue, nPingTime);
+    man.Check();
+    BOOST_REQUIRE(man.GetScheduledCheck(mn0.outpoint, nDue, fHeight));
+    BOOST_CHECK_EQUAL(nDue, nPingTime + MASTERNODE_MIN_MNP_SECONDS);
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-payments.h>
+#include <streams.h>
+#include <test/test_galactrum.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+CMasternodePaymentVote MakeVote(int nBlockHeight, uint32_t nMasternode, uint32_t nPayee, bool fVerified = true)
+{
+    CMasternodePaymentVote vote(COutPoint(uint256S("01"), nMasternode), nBlockHeight, CScript() << nPayee);
+    if(fVerified) vote.vchSig.assign(65, 1);
+    return vote;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(mnpayments_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(payment_window_add_and_expire)
+{
+    CMasternodePaymentWindow window(10);
+
+    for(int h = 100; h < 105; h++) {
+        BOOST_CHECK(window.AddVote(MakeVote(h, 1, h)));
+        BOOST_CHECK(window.AddVote(MakeVote(h, 2, h)));
+    }
+    BOOST_CHECK_EQUAL(window.GetVoteCount(), 10);
+    BOOST_CHECK_EQUAL(window.GetBlockCount(), 5);
+
+    const CMasternodeBlockPayees* pblockPayees = window.GetBlockPayees(102);
+    BOOST_REQUIRE(pblockPayees);
+    BOOST_CHECK_EQUAL(pblockPayees->vecPayees.size(), 1U);
+    BOOST_CHECK(pblockPayees->HasPayeeWithVotes(CScript() << 102, 2));
+    BOOST_CHECK(!window.GetBlockPayees(99));
+    BOOST_CHECK(!window.GetBlockPayees(105));
+
+    const CMasternodePaymentVote* pvote = window.GetVote(MakeVote(103, 2, 103).GetHash());
+    BOOST_REQUIRE(pvote);
+    BOOST_CHECK(pvote->vinMasternode.prevout == COutPoint(uint256S("01"), 2));
+
+    // moving the end to 112 leaves 103 as the first height
+    BOOST_CHECK(window.AddVote(MakeVote(112, 1, 112)));
+    BOOST_CHECK_EQUAL(window.GetFirstHeight(), 103);
+    BOOST_CHECK_EQUAL(window.GetVoteCount(), 5);
+    BOOST_CHECK_EQUAL(window.GetBlockCount(), 3);
+    BOOST_CHECK(!window.HasVote(MakeVote(102, 1, 102).GetHash()));
+    BOOST_CHECK(window.HasVote(MakeVote(103, 1, 103).GetHash()));
+    BOOST_CHECK(!window.AddVote(MakeVote(102, 3, 102)));
+
+    // heights come out in order, wherever their slots are
+    std::vector<int> vecHeights;
+    for(const auto& entry : window) {
+        vecHeights.push_back(entry.first);
+    }
+    BOOST_CHECK(vecHeights == std::vector<int>({103, 104, 112}));
+
+    window.Prune(104);
+    BOOST_CHECK(!window.GetBlock(103));
+    BOOST_CHECK(window.GetBlock(104));
+    BOOST_CHECK_EQUAL(window.GetVoteCount(), 3);
+
+    // a jump past the whole window drops everything
+    BOOST_CHECK(window.AddVote(MakeVote(200, 1, 200)));
+    BOOST_CHECK_EQUAL(window.GetVoteCount(), 1);
+    BOOST_CHECK_EQUAL(window.GetBlockCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(payment_window_verify_and_grow)
+{
+    CMasternodePaymentWindow window(10);
+
+    // a vote only seen counts for no payee until it is verified
+    CMasternodePaymentVote vote = MakeVote(50, 1, 7, false);
+    BOOST_CHECK(window.AddVote(vote));
+    BOOST_CHECK(window.HasVote(vote.GetHash()));
+    BOOST_CHECK(window.GetBlock(50));
+    BOOST_CHECK(!window.GetBlockPayees(50));
+    BOOST_CHECK_EQUAL(window.GetBlockCount(), 0);
+
+    vote = MakeVote(50, 1, 7);
+    BOOST_CHECK(window.AddVote(vote));
+    BOOST_CHECK(window.AddVote(vote));
+    BOOST_CHECK_EQUAL(window.GetVoteCount(), 1);
+    BOOST_CHECK_EQUAL(window.GetBlockCount(), 1);
+    BOOST_REQUIRE(window.GetBlockPayees(50));
+    BOOST_CHECK_EQUAL(window.GetBlockPayees(50)->vecPayees[0].GetVoteCount(), 1);
+
+    for(int h = 51; h < 60; h++) {
+        BOOST_CHECK(window.AddVote(MakeVote(h, 1, h)));
+    }
+    window.Reserve(25);
+    BOOST_CHECK_EQUAL(window.GetSize(), 25);
+    BOOST_CHECK_EQUAL(window.GetVoteCount(), 10);
+    for(int h = 50; h < 60; h++) {
+        BOOST_CHECK(window.GetBlockPayees(h));
+        BOOST_CHECK(window.GetVote(MakeVote(h, 1, h == 50 ? 7 : h).GetHash()));
+    }
+    BOOST_CHECK(window.AddVote(MakeVote(40, 1, 40)));
+    BOOST_CHECK_EQUAL((*window.begin()).first, 40);
+}
+
+BOOST_AUTO_TEST_CASE(payment_window_serialization)
+{
+    CMasternodePaymentWindow window(10);
+    for(int h = 100; h < 103; h++) {
+        window.AddVote(MakeVote(h, 1, 1));
+        window.AddVote(MakeVote(h, 2, 2));
+    }
+    window.AddVote(MakeVote(103, 3, 3, false));
+
+    // the layout of the maps mnpayments.dat held before
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << window;
+    std::map<uint256, CMasternodePaymentVote> mapVotes;
+    std::map<int, CMasternodeBlockPayees> mapBlocks;
+    ss >> mapVotes >> mapBlocks;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK_EQUAL(mapVotes.size(), 7U);
+    BOOST_CHECK_EQUAL(mapBlocks.size(), 3U);
+    BOOST_CHECK_EQUAL(mapBlocks[101].vecPayees.size(), 2U);
+    for(const auto& entry : mapVotes) {
+        BOOST_CHECK(entry.first == entry.second.GetHash());
+    }
+
+    // reading it back keeps the verified votes and rebuilds the payees
+    ss << mapVotes << mapBlocks;
+    CMasternodePaymentWindow windowRead(10);
+    ss >> windowRead;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK_EQUAL(windowRead.GetVoteCount(), 6);
+    BOOST_CHECK_EQUAL(windowRead.GetBlockCount(), 3);
+    BOOST_REQUIRE(windowRead.GetBlockPayees(101));
+    BOOST_CHECK(windowRead.GetBlockPayees(101)->HasPayeeWithVotes(CScript() << 2, 1));
+    BOOST_CHECK(!windowRead.HasVote(MakeVote(103, 3, 3, false).GetHash()));
+
+    // a block as journaled replaces the one in the window
+    CMasternodePaymentBlock block = *window.GetBlock(100);
+    windowRead.EraseBlock(100);
+    BOOST_CHECK(!windowRead.GetBlock(100));
+    BOOST_CHECK_EQUAL(windowRead.GetBlockCount(), 2);
+    windowRead.SetBlock(100, block);
+    BOOST_CHECK_EQUAL(windowRead.GetBlockCount(), 3);
+    BOOST_CHECK_EQUAL(windowRead.GetVoteCount(), 6);
+    BOOST_CHECK(windowRead.HasVote(MakeVote(100, 2, 2).GetHash()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
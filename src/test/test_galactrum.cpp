@@ -8,7 +8,9 @@
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
+#include <crypto/Lyra2RE/Lyra2.h>
 #include <validation.h>
+#include <messagesigner.h>
 #include <miner.h>
 #include <net_processing.h>
 #include <ui_interface.h>
@@ -42,12 +44,14 @@ extern void noui_connect();
 BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
 {
     SHA256AutoDetect();
+    LYRA2AutoDetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
     SetupNetworking();
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitMessageSignatureCache();
     fCheckBlockIndex = true;
     SelectParams(chainName);
     noui_connect();
@@ -92,8 +96,10 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
         }
     }
     nScriptCheckThreads = 3;
-    for (int i=0; i < nScriptCheckThreads-1; i++)
+    for (int i=0; i < nScriptCheckThreads-1; i++) {
         threadGroup.create_thread(&ThreadScriptCheck);
+        threadGroup.create_thread(&ThreadHeaderHashCheck);
+    }
     g_connman = std::unique_ptr<CConnman>(new CConnman(0x1337, 0x1337)); // Deterministic randomness for tests.
     connman = g_connman.get();
     peerLogic.reset(new PeerLogicValidation(connman, scheduler));
@@ -1098,6 +1098,21 @@ int RaiseFileDescriptorLimit(int nMinFD) {
 #endif
 }
 
+size_t GetProcessPeakMemoryUsage() {
+#if defined(WIN32)
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(MAC_OSX)
+    return usage.ru_maxrss; // bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024; // kilobytes
+#endif
+#endif
+}
+
 /**
  * this function tries to make a particular range of a file allocated (corresponding to disk space)
  * it is advisory, and the range specified in the arguments will never contain live data
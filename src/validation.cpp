@@ -59,7 +59,6 @@
 #define MICRO 0.000001
 #define MILLI 0.001
 
-static std::map<uint256, uint256> mapProofOfStake;
 
 /**
  * Global state
@@ -1706,6 +1705,35 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+/** Each closure covers one lane batch, so keep per-worker batches small. */
+static CCheckQueue<CBlockHeaderHashCheck> headerhashcheckqueue(4);
+
+void ThreadHeaderHashCheck() {
+    RenameThread("galactrum-hdrhash");
+    headerhashcheckqueue.Thread();
+}
+
+bool CBlockHeaderHashCheck::operator()() {
+    PrecomputeBlockHeaderHashes(pheaders, nCount);
+    return true;
+}
+
+void PrecomputeHeaderHashes(const std::vector<CBlockHeader>& headers)
+{
+    if (!nScriptCheckThreads || headers.size() <= LYRA2RE2_MAX_LANES) {
+        PrecomputeBlockHeaderHashes(headers);
+        return;
+    }
+
+    CCheckQueueControl<CBlockHeaderHashCheck> control(&headerhashcheckqueue);
+    std::vector<CBlockHeaderHashCheck> vChecks;
+    vChecks.reserve((headers.size() + LYRA2RE2_MAX_LANES - 1) / LYRA2RE2_MAX_LANES);
+    for (size_t i = 0; i < headers.size(); i += LYRA2RE2_MAX_LANES)
+        vChecks.emplace_back(&headers[i], std::min(LYRA2RE2_MAX_LANES, headers.size() - i));
+    control.Add(vChecks);
+    control.Wait();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2994,9 +3022,9 @@ static void AcceptProofOfStakeBlock(const CBlock &block, CBlockIndex *pindexNew)
 
     // ppcoin: record proof-of-stake hash value
     if (pindexNew->IsProofOfStake()) {
-        if (!mapProofOfStake.count(hash))
-            LogPrintf("AcceptProofOfStakeBlock() : hashProofOfStake not found in map \n");
-        pindexNew->hashProofOfStake = mapProofOfStake[hash];
+        if (block.hashProofOfStake.IsNull())
+            LogPrintf("AcceptProofOfStakeBlock() : hashProofOfStake not set on block %s \n", hash.ToString());
+        pindexNew->hashProofOfStake = block.hashProofOfStake;
     }
 
     // ppcoin: compute stake modifier
@@ -3261,9 +3289,7 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
             block.txTPoSContract = contract.rawTx;
         }
 
-        CBlock blockTmp = block;
-
-        CBlockSigner signer(blockTmp, nullptr, contract);
+        CBlockSigner signer(block, contract);
 
         if(!signer.CheckBlockSignature()) {
             return state.DoS(100, error("CheckBlock(): block signature invalid"),
@@ -3274,8 +3300,7 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
             return state.DoS(100, error("CheckBlock(): check proof-of-stake failed for block %s\n", hash.ToString().c_str()));
         }
 
-        if(!mapProofOfStake.count(hash)) // add to mapProofOfStake
-            mapProofOfStake.insert(std::make_pair(hash, hashProofOfStake));
+        block.hashProofOfStake = hashProofOfStake;
     }
 
     // Check transactions
@@ -3640,6 +3665,10 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+    // Proof-of-work hashes do not depend on chain state; compute them on the
+    // worker threads before taking cs_main so AcceptBlockHeader finds them
+    // memoized and the serial index insertion only does cheap lookups.
+    PrecomputeHeaderHashes(headers);
     {
         LOCK(cs_main);
         for (const CBlockHeader& header : headers) {
@@ -275,6 +275,8 @@ bool LoadChainTip(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the header hashing thread */
+void ThreadHeaderHashCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -393,6 +395,32 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Closure hashing a run of consecutive headers from a headers message.
+ * The hashes are memoized on the headers themselves, so the closure never
+ * fails; acceptance is still decided serially by AcceptBlockHeader.
+ */
+class CBlockHeaderHashCheck
+{
+private:
+    const CBlockHeader *pheaders;
+    size_t nCount;
+
+public:
+    CBlockHeaderHashCheck(): pheaders(nullptr), nCount(0) {}
+    CBlockHeaderHashCheck(const CBlockHeader* pheadersIn, size_t nCountIn) : pheaders(pheadersIn), nCount(nCountIn) { }
+
+    bool operator()();
+
+    void swap(CBlockHeaderHashCheck &check) {
+        std::swap(pheaders, check.pheaders);
+        std::swap(nCount, check.nCount);
+    }
+};
+
+/** Hash a batch of headers on the header check threads, if any are running */
+void PrecomputeHeaderHashes(const std::vector<CBlockHeader>& headers);
+
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
 
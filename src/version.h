@@ -9,7 +9,7 @@
  * network protocol versioning
  */
 
-static const int PROTOCOL_VERSION = 70213;
+static const int PROTOCOL_VERSION = 70214;
 
 static const int PRESEGWIT_PROTO_VERSION = 70210;
 
@@ -44,4 +44,7 @@ static const int SHORT_IDS_BLOCKS_VERSION = 70208;
 //! not banning for invalid compact blocks starts with this version
 static const int INVALID_CB_NO_BAN_VERSION = 70208;
 
+//! masternode and stakenode list sync by bucket digests starts with this version
+static const int LIST_DIGEST_VERSION = 70214;
+
 #endif // BITCOIN_VERSION_H
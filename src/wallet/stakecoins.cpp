@@ -0,0 +1,75 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/stakecoins.h>
+
+#include <limits>
+
+template <typename Key>
+void CStakeCoinIndex::EraseFromBucket(std::multimap<Key, COutPoint>& buckets, const Key& key, const COutPoint& outpoint)
+{
+    auto range = buckets.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == outpoint) {
+            buckets.erase(it);
+            return;
+        }
+    }
+}
+
+void CStakeCoinIndex::Add(const COutPoint& outpoint, const CStakeCoin& coin)
+{
+    // re-adding (e.g. after the output moved to another block) starts over
+    Remove(outpoint);
+    mapCoins.emplace(outpoint, coin);
+    mapByHeight.emplace(coin.nHeightMature, outpoint);
+}
+
+void CStakeCoinIndex::Remove(const COutPoint& outpoint)
+{
+    auto it = mapCoins.find(outpoint);
+    if (it == mapCoins.end())
+        return;
+
+    if (!setStakeable.erase(outpoint)) {
+        EraseFromBucket(mapByHeight, it->second.nHeightMature, outpoint);
+        EraseFromBucket(mapByTime, it->second.nTimeMature, outpoint);
+    }
+    mapCoins.erase(it);
+}
+
+void CStakeCoinIndex::Clear()
+{
+    mapCoins.clear();
+    mapByHeight.clear();
+    mapByTime.clear();
+    setStakeable.clear();
+}
+
+void CStakeCoinIndex::Promote(int nHeight, int64_t nTime)
+{
+    auto itHeight = mapByHeight.begin();
+    while (itHeight != mapByHeight.end() && itHeight->first <= nHeight) {
+        const COutPoint& outpoint = itHeight->second;
+        mapByTime.emplace(mapCoins.at(outpoint).nTimeMature, outpoint);
+        itHeight = mapByHeight.erase(itHeight);
+    }
+
+    auto itTime = mapByTime.begin();
+    while (itTime != mapByTime.end() && itTime->first <= nTime) {
+        setStakeable.insert(itTime->second);
+        itTime = mapByTime.erase(itTime);
+    }
+}
+
+int64_t CStakeCoinIndex::GetNextTimeMature() const
+{
+    return mapByTime.empty() ? std::numeric_limits<int64_t>::max() : mapByTime.begin()->first;
+}
+
+const CStakeCoin* CStakeCoinIndex::Get(const COutPoint& outpoint) const
+{
+    auto it = mapCoins.find(outpoint);
+    return it == mapCoins.end() ? nullptr : &it->second;
+}
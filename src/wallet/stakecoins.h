@@ -0,0 +1,63 @@
+// Copyright (c) 2018 The Galactrum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_STAKECOINS_H
+#define BITCOIN_WALLET_STAKECOINS_H
+
+#include <primitives/transaction.h>
+
+#include <map>
+#include <set>
+
+/** Per-output data the stake coin index keeps. */
+struct CStakeCoin
+{
+    //! First chain height at which the output is deep enough to stake
+    int nHeightMature;
+    //! First time at which the output is old enough to stake
+    int64_t nTimeMature;
+    //! Spendable by the wallet, as opposed to watch-only (TPoS contracts)
+    bool fSpendable;
+    //! Pays to a key hash, i.e. can stake without segwit
+    bool fKeyID;
+};
+
+/**
+ * Wallet outputs that are confirmed, unspent and of a type that can stake.
+ *
+ * Outputs wait in a height bucket until they have enough confirmations, then
+ * in a time bucket until they pass the minimum stake age, and are promoted to
+ * the stakeable set as the chain and the clock advance. Every operation costs
+ * O(log n) per output that changes, so staking never has to rescan the wallet.
+ */
+class CStakeCoinIndex
+{
+public:
+    void Add(const COutPoint& outpoint, const CStakeCoin& coin);
+    void Remove(const COutPoint& outpoint);
+    void Clear();
+
+    /** Promote the outputs that are mature at nHeight and nTime. */
+    void Promote(int nHeight, int64_t nTime);
+
+    const std::set<COutPoint>& GetStakeable() const { return setStakeable; }
+    /** Earliest time a deep enough output becomes stakeable, max if none is waiting. */
+    int64_t GetNextTimeMature() const;
+    const CStakeCoin* Get(const COutPoint& outpoint) const;
+
+    size_t size() const { return mapCoins.size(); }
+
+private:
+    std::map<COutPoint, CStakeCoin> mapCoins;
+    //! Waiting for confirmations, by nHeightMature
+    std::multimap<int, COutPoint> mapByHeight;
+    //! Deep enough, waiting for the minimum age, by nTimeMature
+    std::multimap<int64_t, COutPoint> mapByTime;
+    std::set<COutPoint> setStakeable;
+
+    template <typename Key>
+    static void EraseFromBucket(std::multimap<Key, COutPoint>& buckets, const Key& key, const COutPoint& outpoint);
+};
+
+#endif // BITCOIN_WALLET_STAKECOINS_H
@@ -251,6 +251,46 @@ BOOST_AUTO_TEST_CASE(ComputeTimeSmart)
     SetMockTime(0);
 }
 
+// Outputs move from the height bucket to the time bucket to the stakeable
+// set, and can be removed from any stage.
+BOOST_AUTO_TEST_CASE(stake_coin_index)
+{
+    CStakeCoinIndex index;
+    COutPoint a(uint256S("0a"), 0), b(uint256S("0b"), 1), c(uint256S("0c"), 2);
+    index.Add(a, CStakeCoin{10, 1000, true, true});
+    index.Add(b, CStakeCoin{20, 500, true, true});
+    index.Add(c, CStakeCoin{10, 2000, true, false});
+    BOOST_CHECK_EQUAL(index.size(), 3U);
+
+    // deep enough but too young, the earliest of them is the next to mature
+    index.Promote(10, 999);
+    BOOST_CHECK(index.GetStakeable().empty());
+    BOOST_CHECK_EQUAL(index.GetNextTimeMature(), 1000);
+
+    index.Promote(10, 1000);
+    BOOST_CHECK(index.GetStakeable() == std::set<COutPoint>({a}));
+
+    // b is old enough but needs more confirmations
+    index.Promote(19, 5000);
+    BOOST_CHECK(index.GetStakeable() == std::set<COutPoint>({a, c}));
+    index.Promote(20, 5000);
+    BOOST_CHECK(index.GetStakeable() == std::set<COutPoint>({a, b, c}));
+    BOOST_CHECK_EQUAL(index.GetNextTimeMature(), std::numeric_limits<int64_t>::max());
+
+    // spending removes a stakeable coin, re-adding starts it over
+    index.Remove(a);
+    index.Add(c, CStakeCoin{30, 5000, true, false});
+    index.Promote(29, 5000);
+    BOOST_CHECK(index.GetStakeable() == std::set<COutPoint>({b}));
+
+    // removing a waiting coin drops it from its bucket
+    index.Remove(c);
+    index.Promote(30, 5000);
+    BOOST_CHECK(index.GetStakeable() == std::set<COutPoint>({b}));
+    BOOST_CHECK_EQUAL(index.size(), 1U);
+    BOOST_CHECK(index.Get(c) == nullptr);
+}
+
 BOOST_AUTO_TEST_CASE(LoadReceiveRequests)
 {
     CTxDestination dest = CKeyID();
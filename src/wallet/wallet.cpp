@@ -6,6 +6,7 @@
 #include <wallet/wallet.h>
 
 #include <checkpoints.h>
+#include <checkqueue.h>
 #include <chain.h>
 #include <wallet/coincontrol.h>
 #include <consensus/consensus.h>
@@ -400,16 +401,10 @@ CAmount GetStakeReward(CAmount blockReward, unsigned int percentage)
     return (blockReward / 100) * percentage;
 }
 
-bool CWallet::CreateCoinStakeKernel(CScript &kernelScript, const CScript &stakeScript,
-                                    unsigned int nBits, const CBlock &blockFrom,
-                                    unsigned int nTxPrevOffset, const CTransactionRef &txPrev,
-                                    const COutPoint &prevout, unsigned int &nTimeTx,
-                                    const TPoSContract &contract, bool fGenerateSegwit, bool fPrintProofOfStake) const
+bool CWallet::IsStakeKernelCandidate(const CScript &stakeScript, const CStakeKernelContext &kernel,
+                                     unsigned int nTimeTx, const TPoSContract &contract, bool fGenerateSegwit) const
 {
-    unsigned int nTryTime = 0;
-    uint256 hashProofOfStake;
-
-    if (blockFrom.GetBlockTime() + Params().GetConsensus().nStakeMinAge + nHashDrift > nTimeTx) // Min age requirement
+    if (kernel.GetBlockFromTime() + Params().GetConsensus().nStakeMinAge + nHashDrift > nTimeTx) // Min age requirement
         return false;
 
 
@@ -422,7 +417,7 @@ bool CWallet::CreateCoinStakeKernel(CScript &kernelScript, const CScript &stakeS
         // this will return true only if it's P2SH_SEGWIT, SEGWIT, P2PKH(LEGACY)
         if(GetKeyForDestination(*this, dest).IsNull())
         {
-            return error("CreateCoinStakeKernel : no support for kernel %s\n", EncodeDestination(dest));
+            return error("IsStakeKernelCandidate : no support for kernel %s\n", EncodeDestination(dest));
         }
 
         if(!fGenerateSegwit && !boost::get<CKeyID>(&dest))
@@ -431,33 +426,121 @@ bool CWallet::CreateCoinStakeKernel(CScript &kernelScript, const CScript &stakeS
         }
     }
 
+    return true;
+}
+
+int nStakeThreads = DEFAULT_STAKE_THREADS;
+
+namespace {
+
+/** Outcome of one stake kernel search, shared by the threads running it. */
+struct CStakeKernelSearch
+{
+    std::atomic<bool> fFound{false};
+    std::atomic<uint64_t> nAttempts{0};
+    std::mutex mutex;
+    size_t nKernel = 0;
+    unsigned int nTimeTx = 0;
+};
+
+/** Closure searching the hash drift window of one staked coin. */
+class CStakeKernelCheck
+{
+private:
+    const CStakeKernelContext* kernel;
+    size_t nKernel;
+    unsigned int nBits;
+    unsigned int nTimeTx;
+    unsigned int nHashDrift;
+    int64_t nTimeMin;
+    CStakeKernelSearch* search;
 
-    for(unsigned int i = 0; i < nHashDrift; ++i)
+public:
+    CStakeKernelCheck() : kernel(nullptr), nKernel(0), nBits(0), nTimeTx(0), nHashDrift(0), nTimeMin(0), search(nullptr) {}
+    CStakeKernelCheck(const CStakeKernelContext* kernelIn, size_t nKernelIn, unsigned int nBitsIn, unsigned int nTimeTxIn,
+                      unsigned int nHashDriftIn, int64_t nTimeMinIn, CStakeKernelSearch* searchIn) :
+        kernel(kernelIn), nKernel(nKernelIn), nBits(nBitsIn), nTimeTx(nTimeTxIn), nHashDrift(nHashDriftIn),
+        nTimeMin(nTimeMinIn), search(searchIn) {}
+
+    bool operator()()
     {
-        nTryTime = nTimeTx - i;
-        if (CheckStakeKernelHash(nBits, blockFrom, nTxPrevOffset, txPrev, prevout, nTryTime, hashProofOfStake, fPrintProofOfStake))
-        {
-            //Double check that this will pass time requirements
-            if (nTryTime <= chainActive.Tip()->GetMedianTimePast()) {
-                LogPrintf("CreateCoinStakeKernel() : kernel found, but it is too far in the past \n");
-                continue;
+        unsigned int nTryTime = nTimeTx;
+        uint64_t nAttempts = 0;
+        bool fFound = kernel->Search(nBits, nTryTime, nHashDrift, nTimeMin, nAttempts, &search->fFound);
+        search->nAttempts += nAttempts;
+        if (fFound) {
+            std::lock_guard<std::mutex> lock(search->mutex);
+            if (!search->fFound) {
+                search->nKernel = nKernel;
+                search->nTimeTx = nTryTime;
+                search->fFound = true;
             }
+        }
+        // a hit is reported through search, returning false would only stop
+        // the queue from running further checks in this batch
+        return true;
+    }
 
-            // Found a kernel
-            if (gArgs.GetBoolArg("-printcoinstake", false))
-                LogPrintf("CreateCoinStakeKernel : kernel found\n");
+    void swap(CStakeKernelCheck& check)
+    {
+        std::swap(kernel, check.kernel);
+        std::swap(nKernel, check.nKernel);
+        std::swap(nBits, check.nBits);
+        std::swap(nTimeTx, check.nTimeTx);
+        std::swap(nHashDrift, check.nHashDrift);
+        std::swap(nTimeMin, check.nTimeMin);
+        std::swap(search, check.search);
+    }
+};
 
-            kernelScript.clear();
+/** Each closure is a whole hash drift window, so keep per-worker batches small. */
+CCheckQueue<CStakeKernelCheck> stakekernelcheckqueue(16);
 
+} // namespace
 
-            kernelScript = stakeScript;
-            nTimeTx = nTryTime;
+void ThreadStakeKernelCheck()
+{
+    RenameThread("galactrum-stakech");
+    stakekernelcheckqueue.Thread();
+}
 
-            return true;
+bool CWallet::SearchStakeKernels(const std::vector<const CStakeKernelContext*>& vKernels, unsigned int nBits,
+                                 unsigned int nTimeTx, size_t& nKernelRet, unsigned int& nTimeTxRet)
+{
+    const int64_t nTimeStart = GetTimeMicros();
+    const int64_t nTimeMin = chainActive.Tip()->GetMedianTimePast();
+    CStakeKernelSearch search;
+
+    if (nStakeThreads <= 1 || vKernels.size() < 2) {
+        for (size_t i = 0; i < vKernels.size() && !search.fFound; i++) {
+            CStakeKernelCheck(vKernels[i], i, nBits, nTimeTx, nHashDrift, nTimeMin, &search)();
+        }
+    } else {
+        CCheckQueueControl<CStakeKernelCheck> control(&stakekernelcheckqueue);
+        std::vector<CStakeKernelCheck> vChecks;
+        vChecks.reserve(vKernels.size());
+        for (size_t i = 0; i < vKernels.size(); i++) {
+            vChecks.emplace_back(vKernels[i], i, nBits, nTimeTx, nHashDrift, nTimeMin, &search);
         }
+        control.Add(vChecks);
+        control.Wait();
     }
 
-    return false;
+    nStakeSearchAttempts = search.nAttempts.load();
+    nStakeSearchMicros = GetTimeMicros() - nTimeStart;
+    LogPrint(BCLog::KERNEL, "%s: tried %u kernel hashes for %u coins in %.2fms\n", __func__,
+             (uint64_t)nStakeSearchAttempts, vKernels.size(), nStakeSearchMicros * 0.001);
+
+    if (!search.fFound)
+        return false;
+
+    // Found a kernel
+    if (gArgs.GetBoolArg("-printcoinstake", false))
+        LogPrintf("SearchStakeKernels : kernel found\n");
+
+    nKernelRet = search.nKernel;
+    nTimeTxRet = search.nTimeTx;
+    return true;
 }
 
 void CWallet::FillCoinStakePayments(CMutableTransaction &transaction,
@@ -867,6 +950,8 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
 {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
     setWalletUTXO.erase(outpoint);
+    stakeCoins.Remove(outpoint);
+    fStakeCoinsCacheValid = false;
 
     std::pair<TxSpends::iterator, TxSpends::iterator> range;
     range = mapTxSpends.equal_range(outpoint);
@@ -1355,7 +1440,10 @@ bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const CBlockI
             if (pIndex != nullptr)
                 wtx.SetMerkleBranch(pIndex, posInBlock);
 
-            return AddToWallet(wtx, false);
+            if (!AddToWallet(wtx, false))
+                return false;
+            UpdateStakeCoins(mapWallet.at(tx.GetHash()));
+            return true;
         }
     }
     return false;
@@ -1404,6 +1492,8 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
             wtx.nIndex = -1;
             wtx.setAbandoned();
             wtx.MarkDirty();
+            // the outputs it spent are available again
+            MarkStakeCoinsDirty();
             batch.WriteTx(wtx);
             NotifyTransactionChanged(this, wtx.GetHash(), CT_UPDATED);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them abandoned too
@@ -1445,6 +1535,9 @@ void CWallet::MarkConflicted(const uint256& hashBlock, const uint256& hashTx)
     if (conflictconfirms >= 0)
         return;
 
+    // the outputs spent by the conflicted transactions are available again
+    MarkStakeCoinsDirty();
+
     // Do not flush the wallet here for performance reasons
     WalletBatch batch(*database, "r+", false);
 
@@ -1611,11 +1704,17 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
     }
 
     m_last_block_processed = pindex;
+    nStakeCoinsHeight = pindex->nHeight;
+    fStakeCoinsCacheValid = false;
 }
 
 void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {
     LOCK2(cs_main, cs_wallet);
 
+    // outputs of the disconnected block, and those that matured with it,
+    // have to be demoted
+    MarkStakeCoinsDirty();
+
     for (const CTransactionRef& ptx : pblock->vtx) {
         SyncTransaction(ptx);
     }
@@ -2897,108 +2996,173 @@ bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibil
     }
 }
 
-bool CWallet::MintableCoins()
+void CWallet::UpdateStakeCoins(const CWalletTx& wtx)
 {
-    //    CAmount nBalance = GetBalance();
-    //    if (mapArgs.count("-reservebalance") && !ParseMoney(mapArgs["-reservebalance"], nReserveBalance))
-    //        return error("MintableCoins() : invalid reserve balance amount");
-    //    if (nBalance <= nReserveBalance)
-    //        return false;
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
-    std::vector<COutput> vCoins;
-    LOCK2(cs_main, cs_wallet);
-    AvailableCoins(vCoins, true);
+    const uint256& hash = wtx.GetHash();
+    const CBlockIndex* pindex = wtx.hashUnset() ? nullptr : LookupBlockIndex(wtx.hashBlock);
+    bool fConfirmed = pindex && chainActive.Contains(pindex);
+    // coinbase and coinstake outputs also have to pass COINBASE_MATURITY
+    int nDepthRequired = (wtx.IsCoinBase() || wtx.IsCoinStake()) ? COINBASE_MATURITY + 1 : 10;
 
-    for (const COutput& out : vCoins)
-    {
-        if (GetTime() - out.tx->GetTxTime() > Params().GetConsensus().nStakeMinAge)
-        {
-            return true;
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
+        COutPoint outpoint(hash, i);
+        const CScript& scriptPubKey = wtx.tx->vout[i].scriptPubKey;
+        isminetype mine = fConfirmed ? IsMine(wtx.tx->vout[i]) : ISMINE_NO;
+
+        // for staking we support P2PKH, Native Segwit, P2SH Segwit
+        CTxDestination dest;
+        if (mine == ISMINE_NO || IsSpent(hash, i) || !ExtractDestination(scriptPubKey, dest) ||
+                (!boost::get<CKeyID>(&dest) && !boost::get<WitnessV0KeyHash>(&dest) && !boost::get<CScriptID>(&dest))) {
+            if (stakeCoins.Get(outpoint)) {
+                stakeCoins.Remove(outpoint);
+                fStakeCoinsCacheValid = false;
+            }
+            continue;
         }
+
+        CStakeCoin coin;
+        coin.nHeightMature = pindex->nHeight + nDepthRequired - 1;
+        coin.nTimeMature = wtx.GetTxTime() + Params().GetConsensus().nStakeMinAge;
+        coin.fSpendable = (mine & ISMINE_SPENDABLE) != ISMINE_NO;
+        coin.fKeyID = boost::get<CKeyID>(&dest) != nullptr;
+
+        // repeated notifications for the same block keep the coin where it is
+        const CStakeCoin* pcoin = stakeCoins.Get(outpoint);
+        if (pcoin && pcoin->nHeightMature == coin.nHeightMature && pcoin->nTimeMature == coin.nTimeMature &&
+                pcoin->fSpendable == coin.fSpendable)
+            continue;
+        stakeCoins.Add(outpoint, coin);
+        fStakeCoinsCacheValid = false;
     }
+}
 
-    return false;
+void CWallet::RebuildStakeCoins()
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    int64_t nTimeStart = GetTimeMicros();
+    stakeCoins.Clear();
+    for (const auto& entry : mapWallet) {
+        UpdateStakeCoins(entry.second);
+    }
+    nStakeCoinsHeight = chainActive.Height();
+    fStakeCoinsDirty = false;
+    fStakeCoinsCacheValid = false;
+    LogPrint(BCLog::KERNEL, "%s: %u stake coins in %.2fms\n", __func__, stakeCoins.size(), (GetTimeMicros() - nTimeStart) * 0.001);
 }
 
-bool CWallet::SelectStakeCoins(StakeCoinsSet &setCoins, CAmount nTargetAmount, bool fSelectWitness, const CScript &scriptFilterPubKey) const
+void CWallet::PromoteStakeCoins()
 {
-    std::vector<COutput> vCoins;
-    CCoinControl coinControl;
-    coinControl.fAllowWatchOnly = !scriptFilterPubKey.empty();
-    {
-        LOCK2(cs_main, cs_wallet);
-        AvailableCoins(vCoins, !scriptFilterPubKey.empty(), &coinControl);
+    AssertLockHeld(cs_wallet);
+
+    if (fStakeCoinsDirty) {
+        AssertLockHeld(cs_main);
+        RebuildStakeCoins();
     }
-    CAmount nAmountSelected = 0;
+    stakeCoins.Promote(nStakeCoinsHeight, GetTime());
+}
 
-    std::set<CScript> rejectCache;
+void CWallet::MarkStakeCoinsDirty()
+{
+    AssertLockHeld(cs_wallet);
+    fStakeCoinsDirty = true;
+    fStakeCoinsCacheValid = false;
+}
 
-    for (const COutput& out : vCoins) {
-        //make sure not to outrun target amount
-        CScript scriptPubKeyKernel;
-        scriptPubKeyKernel = out.tx->tx->vout[out.i].scriptPubKey;
+void CWallet::RefreshStakeCoinsCache()
+{
+    AssertLockHeld(cs_stakecoinscache);
 
-        if(!coinControl.fAllowWatchOnly && !out.fSpendable)
-            continue;
+    LOCK2(cs_main, cs_wallet);
+    PromoteStakeCoins();
 
-        CTxDestination dest;
-        if(!ExtractDestination(scriptPubKeyKernel, dest))
-            continue;
+    fStakeCoinsCacheMintable = false;
+    for (const COutPoint& outpoint : stakeCoins.GetStakeable())
+    {
+        if (stakeCoins.Get(outpoint)->fSpendable && !IsLockedCoin(outpoint.hash, outpoint.n))
+        {
+            fStakeCoinsCacheMintable = true;
+            break;
+        }
+    }
+    mapStakeCoinsCache.clear();
+    nStakeCoinsCacheExpiry = stakeCoins.GetNextTimeMature();
+    // set under cs_wallet, so a change made after the promotion above clears it again
+    fStakeCoinsCacheValid = true;
+}
 
-        // for staking we support P2PKH, Native Segwit, P2SH Segwit
-        if(!boost::get<CKeyID>(&dest) && !boost::get<WitnessV0KeyHash>(&dest) &&
-                !boost::get<CScriptID>(&dest))
-            continue;
+bool CWallet::MintableCoins()
+{
+    //    CAmount nBalance = GetBalance();
+    //    if (mapArgs.count("-reservebalance") && !ParseMoney(mapArgs["-reservebalance"], nReserveBalance))
+    //        return error("MintableCoins() : invalid reserve balance amount");
+    //    if (nBalance <= nReserveBalance)
+    //        return false;
 
-        if(!fSelectWitness && !boost::get<CKeyID>(&dest))
-            continue;
+    LOCK(cs_stakecoinscache);
+    if (!fStakeCoinsCacheValid || GetTime() >= nStakeCoinsCacheExpiry)
+        RefreshStakeCoinsCache();
 
-        //        LogPrintf("scriptPubKeyKernel is good\n");
+    return fStakeCoinsCacheMintable;
+}
 
-        //for now we will comment this out
-        //        if (nAmountSelected + out.tx->vout[out.i].nValue > nTargetAmount)
-        //            continue;
+bool CWallet::SelectStakeCoins(StakeCoinsSet &setCoins, CAmount nTargetAmount, bool fSelectWitness, const CScript &scriptFilterPubKey)
+{
+    LOCK(cs_stakecoinscache);
+    if (!fStakeCoinsCacheValid || GetTime() >= nStakeCoinsCacheExpiry)
+        RefreshStakeCoinsCache();
 
-        //        LogPrintf("amount is good\n");
+    auto itCache = mapStakeCoinsCache.find(std::make_pair(fSelectWitness, scriptFilterPubKey));
+    if (itCache != mapStakeCoinsCache.end()) {
+        setCoins.insert(itCache->second.begin(), itCache->second.end());
+        return true;
+    }
 
-        //check for min age
-        if (GetTime() - out.tx->GetTxTime() < Params().GetConsensus().nStakeMinAge)
-            continue;
+    LOCK2(cs_main, cs_wallet);
+    // a change since the refresh is picked up here and clears the cache for the next call
+    PromoteStakeCoins();
 
-        //        LogPrintf("min age is good\n");
+    // outputs paying to our TPoS contracts' owner addresses are not staked directly
+    std::set<CScript> setTPoSScripts;
+    for (const auto& entry : tposOwnerContracts) {
+        setTPoSScripts.insert(GetScriptForDestination(entry.second.tposAddress.Get()));
+    }
 
-        //check that it is matured
-        if (out.nDepth < (out.tx->tx->IsCoinStake() ? COINBASE_MATURITY : 10))
-            continue;
+    CAmount nAmountSelected = 0;
 
-        //        LogPrintf("maturity is good\n");
+    for (const COutPoint& outpoint : stakeCoins.GetStakeable()) {
+        const CStakeCoin& coin = *stakeCoins.Get(outpoint);
 
-        auto scriptPubKeyCoin = out.tx->tx->vout[out.i].scriptPubKey;
+        // watch-only outputs can only stake for a TPoS contract
+        if(scriptFilterPubKey.empty() && !coin.fSpendable)
+            continue;
 
-        if(!scriptFilterPubKey.empty() && scriptPubKeyCoin != scriptFilterPubKey)
+        if(!fSelectWitness && !coin.fKeyID)
             continue;
 
-        //        LogPrintf("filtering is good\n");
+        if (IsLockedCoin(outpoint.hash, outpoint.n))
+            continue;
 
-        if(rejectCache.count(scriptPubKeyCoin)) {
+        auto it = mapWallet.find(outpoint.hash);
+        if (it == mapWallet.end())
             continue;
-        }
-        else {
-            auto it = std::find_if(std::begin(tposOwnerContracts), std::end(tposOwnerContracts), [scriptPubKeyCoin](const std::pair<uint256, TPoSContract> &entry) {
-                return GetScriptForDestination(entry.second.tposAddress.Get()) == scriptPubKeyCoin;
-            });
+        const CWalletTx& wtx = it->second;
+        const CScript& scriptPubKeyCoin = wtx.tx->vout[outpoint.n].scriptPubKey;
 
-            if(it != std::end(tposOwnerContracts)) {
-                rejectCache.insert(scriptPubKeyCoin);
-                continue;
-            }
-        }
+        if(!scriptFilterPubKey.empty() && scriptPubKeyCoin != scriptFilterPubKey)
+            continue;
 
-        //        LogPrintf("reject is good\n");
+        if(setTPoSScripts.count(scriptPubKeyCoin))
+            continue;
 
-        nAmountSelected += out.tx->tx->vout[out.i].nValue; //maybe change here for tpos
-        setCoins.emplace(out.tx, out.i);
+        nAmountSelected += wtx.tx->vout[outpoint.n].nValue; //maybe change here for tpos
+        setCoins.emplace(&wtx, outpoint.n);
     }
+    mapStakeCoinsCache.emplace(std::make_pair(fSelectWitness, scriptFilterPubKey), setCoins);
     return true;
 }
 
@@ -3725,28 +3889,20 @@ bool CWallet::CreateCoinStake(unsigned int nBits,
     //    if (nBalance <= nReserveBalance)
     //        return false;
 
-    // presstab HyperStake - Initialize as static and don't update the set on every run of CreateCoinStake() in order to lighten resource use
-    static StakeCoinsSet setStakeCoins;
-    static int nLastStakeSetUpdate = 0;
+    // the selection is cached until the stake coins, locked coins, TPoS
+    // contracts or the tip change, so most attempts take no wallet locks
+    StakeCoinsSet setStakeCoins;
 
     bool fIsTPoS = tposContract.IsValid();
-    if (GetTime() - nLastStakeSetUpdate > nStakeSetUpdateTime) {
-        setStakeCoins.clear();
-
-        CScript scriptPubKey;
-        if(fIsTPoS)
-        {
-            scriptPubKey = GetScriptForDestination(tposContract.tposAddress.Get());
-            LogPrint(BCLog::KERNEL, "finding stake, stake contract ownerAddress: %s\n", tposContract.tposAddress.ToString().c_str());
-        }
-
-        if (!SelectStakeCoins(setStakeCoins, nBalance /*- nReserveBalance*/, fGenerateSegwit, scriptPubKey)) {
-            return error("Failed to select coins for staking");
-        }
-
-        LogPrintf("Selected %d coins for staking\n", setStakeCoins.size());
+    CScript scriptPubKey;
+    if(fIsTPoS)
+    {
+        scriptPubKey = GetScriptForDestination(tposContract.tposAddress.Get());
+        LogPrint(BCLog::KERNEL, "finding stake, stake contract ownerAddress: %s\n", tposContract.tposAddress.ToString().c_str());
+    }
 
-        nLastStakeSetUpdate = GetTime();
+    if (!SelectStakeCoins(setStakeCoins, nBalance /*- nReserveBalance*/, fGenerateSegwit, scriptPubKey)) {
+        return error("Failed to select coins for staking");
     }
 
     if (setStakeCoins.empty())
@@ -3756,9 +3912,23 @@ bool CWallet::CreateCoinStake(unsigned int nBits,
     if (GetAdjustedTime() <= chainActive.Tip()->nTime)
         MilliSleep(10000);
 
+    // Kernel contexts only depend on the coin and the active chain, so they are
+    // reused by every staking attempt until the tip changes
+    static std::map<COutPoint, CStakeKernelContext> mapStakeKernels;
+    static uint256 hashStakeKernelsTip;
+    if (hashStakeKernelsTip != chainActive.Tip()->GetBlockHash()) {
+        mapStakeKernels.clear();
+        hashStakeKernelsTip = chainActive.Tip()->GetBlockHash();
+    }
+
     bool fKernelFound = false;
     CAmount nCredit = 0;
 
+    // all coins are tried at the same kernel timestamps
+    nTxNewTime = GetAdjustedTime();
+    std::vector<std::pair<const CWalletTx*, unsigned int>> vCandidates;
+    std::vector<const CStakeKernelContext*> vKernels;
+
     COutPoint tposContractOutpoint = TPoSUtils::GetContractCollateralOutpoint(tposContract);
     for(const std::pair<const CWalletTx*, unsigned int> &pcoin : setStakeCoins)
     {
@@ -3777,26 +3947,37 @@ bool CWallet::CreateCoinStake(unsigned int nBits,
             continue;
         }
 
-        // Read block header
-        CBlockHeader block = pindex->GetBlockHeader();
         COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
+        auto itKernel = mapStakeKernels.find(prevoutStake);
+        if (itKernel == mapStakeKernels.end()) {
+            CStakeKernelContext kernel;
+            if (!kernel.Init(pindex->GetBlockHash(), pindex->GetBlockTime(),
+                             pcoin.first->tx->vout[pcoin.second].nValue, prevoutStake))
+                continue;
+            itKernel = mapStakeKernels.emplace(prevoutStake, kernel).first;
+        }
 
-        nTxNewTime = GetAdjustedTime();
-        //iterates each utxo inside of CheckStakeKernelHash()
-        CScript kernelScript;
         auto stakeScript = pcoin.first->tx->vout[pcoin.second].scriptPubKey;
-        fKernelFound = CreateCoinStakeKernel(kernelScript, stakeScript, nBits,
-                                             block, sizeof(CBlock), pcoin.first->tx,
-                                             prevoutStake, nTxNewTime, tposContract, fGenerateSegwit, false);
+        if (!IsStakeKernelCandidate(stakeScript, itKernel->second, nTxNewTime, tposContract, fGenerateSegwit))
+            continue;
 
-        if(fKernelFound)
-        {
-            if(!fIsTPoS) // we won't sign in case of tpos block
-                vwtxPrev.push_back(pcoin.first);
+        vCandidates.push_back(pcoin);
+        vKernels.push_back(&itKernel->second);
+    }
 
-            FillCoinStakePayments(txNew, tposContract, kernelScript, prevoutStake, blockReward);
-            break;
-        }
+    //iterates the hash drift window of each utxo inside of SearchStakeKernels()
+    size_t nKernel = 0;
+    fKernelFound = SearchStakeKernels(vKernels, nBits, nTxNewTime, nKernel, nTxNewTime);
+    if(fKernelFound)
+    {
+        const std::pair<const CWalletTx*, unsigned int> &pcoin = vCandidates[nKernel];
+        COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
+        CScript kernelScript = pcoin.first->tx->vout[pcoin.second].scriptPubKey;
+
+        if(!fIsTPoS) // we won't sign in case of tpos block
+            vwtxPrev.push_back(pcoin.first);
+
+        FillCoinStakePayments(txNew, tposContract, kernelScript, prevoutStake, blockReward);
     }
 
     if(!fKernelFound)
@@ -3821,7 +4002,6 @@ bool CWallet::CreateCoinStake(unsigned int nBits,
     LogPrintf("CreateCoinStake -- nBlockHeight %d blockReward %lld txoutMasternode %s txNew %s",
               nHeight, blockReward, txoutMasternode.ToString(), txNew.ToString());
 
-    nLastStakeSetUpdate = 0; //this will trigger stake set to repopulate next round
     return true;
 }
 
@@ -3930,6 +4110,7 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
             }
         }
     }
+    MarkStakeCoinsDirty();
 
     // This wallet is in its first run if all of these are empty
     fFirstRunRet = mapKeys.empty() && mapCryptedKeys.empty() && mapWatchKeys.empty() && setWatchOnly.empty() && mapScripts.empty();
@@ -3948,6 +4129,7 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
     DBErrors nZapSelectTxRet = WalletBatch(*database,"cr+").ZapSelectTx(vHashIn, vHashOut);
     for (uint256 hash : vHashOut)
         mapWallet.erase(hash);
+    MarkStakeCoinsDirty();
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE)
     {
@@ -4511,18 +4693,21 @@ void CWallet::LockCoin(const COutPoint& output)
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
     setLockedCoins.insert(output);
+    fStakeCoinsCacheValid = false;
 }
 
 void CWallet::UnlockCoin(const COutPoint& output)
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
     setLockedCoins.erase(output);
+    fStakeCoinsCacheValid = false;
 }
 
 void CWallet::UnlockAllCoins()
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
     setLockedCoins.clear();
+    fStakeCoinsCacheValid = false;
 }
 
 bool CWallet::IsLockedCoin(uint256 hash, unsigned int n) const
@@ -4584,8 +4769,10 @@ bool CWallet::RemoveTPoSContract(const uint256 &contractTxId)
     if(tposStakenodeContracts.count(contractTxId))
         tposStakenodeContracts.erase(contractTxId);
 
-    if(tposOwnerContracts.count(contractTxId))
+    if(tposOwnerContracts.count(contractTxId)) {
         tposOwnerContracts.erase(contractTxId);
+        fStakeCoinsCacheValid = false;
+    }
 
     return true;
 }
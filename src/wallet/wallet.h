@@ -18,6 +18,7 @@
 #include <util.h>
 #include <wallet/crypter.h>
 #include <wallet/coinselection.h>
+#include <wallet/stakecoins.h>
 #include <wallet/walletdb.h>
 #include <wallet/rpcwallet.h>
 #include <stakenode/tposutils.h>
@@ -38,6 +39,8 @@ bool RemoveWallet(CWallet* wallet);
 bool HasWallets();
 std::vector<CWallet*> GetWallets();
 CWallet* GetWallet(const std::string& name);
+//! Run a stake kernel search worker
+void ThreadStakeKernelCheck();
 
 //! Default for -keypool
 static const unsigned int DEFAULT_KEYPOOL_SIZE = 1000;
@@ -64,12 +67,20 @@ static const bool DEFAULT_DISABLE_WALLET = false;
 
 static const int64_t TIMESTAMP_MIN = 0;
 
+//! -stakethreads default: search stake kernels on the staking thread only
+static const int DEFAULT_STAKE_THREADS = 1;
+//! Maximum number of threads searching stake kernels
+static const int MAX_STAKE_THREADS = 16;
+//! Number of threads searching stake kernels, including the staking thread
+extern int nStakeThreads;
+
 class CBlockIndex;
 class CCoinControl;
 class COutput;
 class CReserveKey;
 class CScript;
 class CScheduler;
+class CStakeKernelContext;
 class CTxMemPool;
 class CBlockPolicyEstimator;
 class CWalletTx;
@@ -708,7 +719,6 @@ private:
     // Stake Settings
     unsigned int nHashDrift = 45;
     unsigned int nHashInterval = 22;
-    int nStakeSetUpdateTime = 300; // 5 mins
 
     mutable bool fAnonymizableTallyCached;
     mutable std::vector<CompactTallyItem> vecAnonymizableTallyCached;
@@ -729,6 +739,29 @@ private:
 
     std::set<COutPoint> setWalletUTXO;
 
+    //! Outputs that can stake, kept up to date like setWalletUTXO
+    CStakeCoinIndex stakeCoins;
+    //! Chain height the stake coin index was promoted against
+    int nStakeCoinsHeight = 0;
+    //! Set when a change (reorg, abandoned spend, load) needs a full rebuild
+    bool fStakeCoinsDirty = true;
+    void UpdateStakeCoins(const CWalletTx& wtx);
+    void RebuildStakeCoins();
+    void PromoteStakeCoins();
+    void MarkStakeCoinsDirty();
+
+    //! Results of MintableCoins and SelectStakeCoins, served without cs_main and
+    //! cs_wallet until the stake coins, locked coins, TPoS contracts or the tip
+    //! change (which clear fStakeCoinsCacheValid under cs_wallet) or the next
+    //! waiting output reaches the minimum stake age
+    CCriticalSection cs_stakecoinscache;
+    std::atomic<bool> fStakeCoinsCacheValid{false};
+    int64_t nStakeCoinsCacheExpiry = 0;
+    bool fStakeCoinsCacheMintable = false;
+    //! Selected coins by (fSelectWitness, scriptFilterPubKey)
+    std::map<std::pair<bool, CScript>, std::set<std::pair<const CWalletTx*, unsigned int>>> mapStakeCoinsCache;
+    void RefreshStakeCoinsCache();
+
     /* Mark a transaction (and its in-wallet descendants) as conflicting with a particular block. */
     void MarkConflicted(const uint256& hashBlock, const uint256& hashTx);
 
@@ -786,11 +819,10 @@ private:
      */
     const CBlockIndex* m_last_block_processed = nullptr;
 
-    bool CreateCoinStakeKernel(CScript &kernelScript, const CScript &stakeScript,
-                               unsigned int nBits, const CBlock& blockFrom,
-                               unsigned int nTxPrevOffset, const CTransactionRef &txPrev,
-                               const COutPoint& prevout, unsigned int &nTimeTx,
-                               const TPoSContract &contract, bool fGenerateSegwit, bool fPrintProofOfStake) const;
+    bool IsStakeKernelCandidate(const CScript &stakeScript, const CStakeKernelContext& kernel,
+                                unsigned int nTimeTx, const TPoSContract &contract, bool fGenerateSegwit) const;
+    bool SearchStakeKernels(const std::vector<const CStakeKernelContext*>& vKernels, unsigned int nBits,
+                            unsigned int nTimeTx, size_t& nKernelRet, unsigned int& nTimeTxRet);
 
     void FillCoinStakePayments(CMutableTransaction &transaction,
                                const TPoSContract &tposContract,
@@ -905,7 +937,7 @@ public:
     // Coin selection
     using StakeCoinsSet = std::set<std::pair<const CWalletTx*, unsigned int>>;
     bool MintableCoins();
-    bool SelectStakeCoins(StakeCoinsSet& setCoins, CAmount nTargetAmount, bool fSelectWitness, const CScript &scriptFilterPubKey = CScript()) const;
+    bool SelectStakeCoins(StakeCoinsSet& setCoins, CAmount nTargetAmount, bool fSelectWitness, const CScript &scriptFilterPubKey = CScript());
     bool SelectCoinsGrouppedByAddresses(std::vector<CompactTallyItem>& vecTallyRet, bool fSkipDenominated = true, bool fAnonymizable = true, bool fSkipUnconfirmed = true) const;
 
 #if 0
@@ -1048,6 +1080,9 @@ public:
                          CMutableTransaction& txNew, unsigned int& nTxNewTime,
                          const TPoSContract &tposContract, std::vector<const CWalletTx *> &vwtxPrev,
                          bool fGenerateSegwit);
+    //! Kernel hashes tried by the last stake search and how long it took
+    std::atomic<uint64_t> nStakeSearchAttempts{0};
+    std::atomic<int64_t> nStakeSearchMicros{0};
     bool CommitTransaction(CTransactionRef tx, mapValue_t mapValue, std::vector<std::pair<std::string, std::string>> orderForm, std::string fromAccount, CReserveKey& reservekey, CConnman* connman, CValidationState& state);
 
     void ListAccountCreditDebit(const std::string& strAccount, std::list<CAccountingEntry>& entries);